@@ -192,6 +192,9 @@ void Application::Run()
 
 void Application::Terminate()
 {
+	// Frames still in flight use resources owned by the actors
+	mDx12->WaitForGpu();
+
 	PhysicsManager::Destroy();
 
 	UnregisterClass(mWindowClass.lpszClassName, mWindowClass.hInstance);
@@ -0,0 +1,16 @@
+#pragma once
+
+// Where the passes of a frame record to, one command list per pass
+class ICommandBackend
+{
+public:
+	virtual ~ICommandBackend() = default;
+
+	// Prepares passCount empty command lists, called before any pass records
+	virtual void BeginFrame(unsigned int passCount) = 0;
+	// Called on the recording thread, what it records until EndPass goes to the list of that pass
+	virtual void BeginPass(unsigned int pass) = 0;
+	virtual void EndPass(unsigned int pass) = 0;
+	// Every pass list in pass order in one submission, whatever order they finished recording in
+	virtual void Submit() = 0;
+};
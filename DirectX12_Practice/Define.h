@@ -1,4 +1,10 @@
 #pragma once
 
 const unsigned int window_width = 1600;
-const unsigned int window_height = 800;
\ No newline at end of file
+const unsigned int window_height = 800;
+// Frames the CPU records ahead of the GPU, 2 or 3. Each has its own allocators and upload memory behind a fence
+const unsigned int frames_in_flight = 2;
+// Simulated data also needs a slot for the frame the workers simulate ahead of the one recording
+const unsigned int frame_buffer_slots = frames_in_flight + 1;
+// Every CBV/SRV/UAV descriptor lives in one shader visible heap of this many descriptors
+const unsigned int descriptor_heap_capacity = 4096;
@@ -0,0 +1,103 @@
+#include "DescriptorAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+void DescriptorAllocator::Initialize(unsigned int capacity)
+{
+	mCapacity = capacity;
+	mFreeCount = capacity;
+
+	mFreeRanges.clear();
+
+	DescriptorRange range;
+	range.index = 0;
+	range.count = capacity;
+	mFreeRanges.push_back(range);
+}
+
+DescriptorRange DescriptorAllocator::Allocate(unsigned int count)
+{
+	DescriptorRange result;
+
+	if (count == 0)
+	{
+		return result;
+	}
+
+	for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it)
+	{
+		if (it->count < count)
+		{
+			continue;
+		}
+
+		result.index = it->index;
+		result.count = count;
+
+		it->index += count;
+		it->count -= count;
+
+		if (it->count == 0)
+		{
+			mFreeRanges.erase(it);
+		}
+
+		mFreeCount -= count;
+
+		return result;
+	}
+
+	return result;
+}
+
+void DescriptorAllocator::Free(const DescriptorRange& range)
+{
+	if (range.IsValid() == false)
+	{
+		return;
+	}
+
+	assert(range.index + range.count <= mCapacity);
+
+	auto next = std::lower_bound(mFreeRanges.begin(), mFreeRanges.end(), range,
+		[](const DescriptorRange& left, const DescriptorRange& right) { return left.index < right.index; });
+
+	// A range freed twice would overlap a free neighbour
+	assert(next == mFreeRanges.end() || range.index + range.count <= next->index);
+	assert(next == mFreeRanges.begin() || (next - 1)->index + (next - 1)->count <= range.index);
+
+	mFreeCount += range.count;
+
+	bool mergePrevious = next != mFreeRanges.begin() && (next - 1)->index + (next - 1)->count == range.index;
+	bool mergeNext = next != mFreeRanges.end() && range.index + range.count == next->index;
+
+	if (mergePrevious == true && mergeNext == true)
+	{
+		auto previous = next - 1;
+		previous->count += range.count + next->count;
+		mFreeRanges.erase(next);
+	}
+	else if (mergePrevious == true)
+	{
+		(next - 1)->count += range.count;
+	}
+	else if (mergeNext == true)
+	{
+		next->index = range.index;
+		next->count += range.count;
+	}
+	else
+	{
+		mFreeRanges.insert(next, range);
+	}
+}
+
+unsigned int DescriptorAllocator::GetCapacity() const
+{
+	return mCapacity;
+}
+
+unsigned int DescriptorAllocator::GetFreeCount() const
+{
+	return mFreeCount;
+}
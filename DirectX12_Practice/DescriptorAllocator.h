@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+
+// Contiguous descriptors starting at index, the index stays valid until the range is freed
+struct DescriptorRange
+{
+	unsigned int index = 0;
+	unsigned int count = 0;
+
+	bool IsValid() const { return count > 0; }
+};
+
+// Hands out index ranges of a fixed size descriptor heap, knows nothing about the device.
+// Free ranges are kept sorted by index and merged with their neighbours when freed
+class DescriptorAllocator
+{
+public:
+	void Initialize(unsigned int capacity);
+
+	// First free range large enough, an invalid range when none is left
+	DescriptorRange Allocate(unsigned int count);
+	void Free(const DescriptorRange& range);
+
+	unsigned int GetCapacity() const;
+	unsigned int GetFreeCount() const;
+
+private:
+	std::vector<DescriptorRange> mFreeRanges;
+	unsigned int mCapacity = 0;
+	unsigned int mFreeCount = 0;
+};
@@ -0,0 +1,94 @@
+#include "DescriptorHeap.h"
+#include <cassert>
+
+HRESULT DescriptorHeap::Initialize(ID3D12Device* device, unsigned int capacity)
+{
+	mDevice = device;
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	heapDesc.NodeMask = 0;
+	heapDesc.NumDescriptors = capacity;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+
+	auto result = device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mHeap.ReleaseAndGetAddressOf()));
+	if (FAILED(result))
+	{
+		assert(SUCCEEDED(result));
+		return result;
+	}
+
+	// Copies read from here, a shader visible heap is slow for the CPU to read
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+	result = device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mStagingHeap.ReleaseAndGetAddressOf()));
+	if (FAILED(result))
+	{
+		assert(SUCCEEDED(result));
+		return result;
+	}
+
+	mIncrementSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	mAllocator.Initialize(capacity);
+
+	return result;
+}
+
+DescriptorRange DescriptorHeap::Allocate(unsigned int count)
+{
+	DescriptorRange range = mAllocator.Allocate(count);
+
+	// Out of descriptors means the capacity is too small for the scene, not something to recover from
+	assert(range.IsValid() == true);
+
+	return range;
+}
+
+void DescriptorHeap::Free(const DescriptorRange& range)
+{
+	mAllocator.Free(range);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::GetStagingHandle(unsigned int index) const
+{
+	auto handle = mStagingHeap->GetCPUDescriptorHandleForHeapStart();
+	handle.ptr += static_cast<SIZE_T>(index) * mIncrementSize;
+
+	return handle;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::GetCpuHandle(unsigned int index) const
+{
+	auto handle = mHeap->GetCPUDescriptorHandleForHeapStart();
+	handle.ptr += static_cast<SIZE_T>(index) * mIncrementSize;
+
+	return handle;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::GetGpuHandle(unsigned int index) const
+{
+	auto handle = mHeap->GetGPUDescriptorHandleForHeapStart();
+	handle.ptr += static_cast<UINT64>(index) * mIncrementSize;
+
+	return handle;
+}
+
+void DescriptorHeap::Commit(const DescriptorRange& range) const
+{
+	if (range.IsValid() == false)
+	{
+		return;
+	}
+
+	mDevice->CopyDescriptorsSimple(range.count, GetCpuHandle(range.index), GetStagingHandle(range.index), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+ID3D12DescriptorHeap* DescriptorHeap::GetHeap() const
+{
+	return mHeap.Get();
+}
+
+const DescriptorAllocator& DescriptorHeap::GetAllocator() const
+{
+	return mAllocator;
+}
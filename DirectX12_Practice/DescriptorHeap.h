@@ -0,0 +1,39 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+
+#include "DescriptorAllocator.h"
+
+// The one shader visible CBV/SRV/UAV heap every command list binds, with a CPU only staging heap of the same layout.
+// Views are created in the staging heap and copied over by Commit, a descriptor keeps its index for its whole life
+class DescriptorHeap
+{
+public:
+	HRESULT Initialize(ID3D12Device* device, unsigned int capacity);
+
+	DescriptorRange Allocate(unsigned int count);
+	// The GPU must be done with every command list that used the range
+	void Free(const DescriptorRange& range);
+
+	// Where views of index are created before Commit
+	D3D12_CPU_DESCRIPTOR_HANDLE GetStagingHandle(unsigned int index) const;
+	// Shader visible side, for code that writes its views there itself like the ImGui backend
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(unsigned int index) const;
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(unsigned int index) const;
+
+	// Copies the staged views of range into the shader visible heap
+	void Commit(const DescriptorRange& range) const;
+
+	ID3D12DescriptorHeap* GetHeap() const;
+	const DescriptorAllocator& GetAllocator() const;
+
+private:
+	template<typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	ComPtr<ID3D12Device> mDevice = nullptr;
+	ComPtr<ID3D12DescriptorHeap> mHeap = nullptr;
+	ComPtr<ID3D12DescriptorHeap> mStagingHeap = nullptr;
+	DescriptorAllocator mAllocator;
+	unsigned int mIncrementSize = 0;
+};
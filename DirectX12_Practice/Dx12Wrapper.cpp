@@ -2,11 +2,13 @@
 #include <cassert>
 #include <d3dx12.h>
 #include "Application.h"
+#include "RenderGraph.h"
 #include "Utill.h"
 #include "BitFlag.h"
 #include "Input.h"
 #include "Transform.h"
 #include "Time.h"
+#include <chrono>
 #include <random>
 
 #pragma comment(lib, "d3d12.lib")
@@ -18,6 +20,9 @@ using namespace std;
 using namespace DirectX;
 using namespace Microsoft::WRL;
 
+// List of the pass the calling thread is recording, null outside a pass
+static thread_local ID3D12GraphicsCommandList* recordingCommandList = nullptr;
+
 Dx12Wrapper::Dx12Wrapper(HWND hwnd) :
     mCurrentPPFlag(0)
 {
@@ -40,32 +45,29 @@ Dx12Wrapper::Dx12Wrapper(HWND hwnd) :
 		return;
 	}
 
-	if (FAILED(CreateSwapChain(hwnd)))
+	if (FAILED(mDescriptorHeap.Initialize(mDevice.Get(), descriptor_heap_capacity)))
 	{
 		assert(0);
 		return;
 	}
 
-	if (FAILED(CreateFinalRenderTargets()))
-	{
-		assert(0);
-		return;
-	}
+	// Bound once per list after each reset, views are picked by index from then on
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mDescriptorHeap.GetHeap() };
+	mCmdList->SetDescriptorHeaps(1, descriptorHeaps);
 
-	if (FAILED(CreateSceneView()))
+	if (FAILED(CreateSwapChain(hwnd)))
 	{
 		assert(0);
 		return;
 	}
 
-	if (FAILED(CreateBloomParameterResource()))
+	if (FAILED(CreateFinalRenderTargets()))
 	{
 		assert(0);
 		return;
 	}
 
-
-	if (FAILED(CreateResolutionConstantBuffer()))
+	if (FAILED(CreateFrameConstants()))
 	{
 		assert(0);
 		return;
@@ -77,12 +79,6 @@ Dx12Wrapper::Dx12Wrapper(HWND hwnd) :
 		return;
 	}
 
-	if (FAILED(CreateGlobalParameterBuffer()))
-	{
-		assert(0);
-		return;
-	}
-
 	if (CreatePeraVertex() == false)
 	{
 		assert(0);
@@ -107,7 +103,7 @@ Dx12Wrapper::Dx12Wrapper(HWND hwnd) :
 		return;
 	}
 
-	if (CreateAmbientOcclusionDescriptorHeap() == false)
+	if (CreateAmbientOcclusionView() == false)
 	{
 		assert(0);
 		return;
@@ -127,17 +123,12 @@ Dx12Wrapper::Dx12Wrapper(HWND hwnd) :
 		return;
 	}
 
+	mFenceEvent = CreateEvent(nullptr, false, false, nullptr);
+
 	mWhiteTex = CreateWhiteTexture();
 	mBlackTex = CreateBlackTexture();
 	mGradTex = CreateGrayGradationTexture();
 
-	mHeapForImgui = CreateDescriptorHeapForImgui();
-	if (mHeapForImgui == nullptr)
-	{
-		assert(0);
-		return;
-	}
-
 	mCameraTransform = new Transform();
 	mCameraTransform->SetPosition(0.0f, 10.0f, -30.0f);
 	mCameraTransform->SetRotation(0.0f, 0.0f, 0.0f);
@@ -147,6 +138,10 @@ Dx12Wrapper::Dx12Wrapper(HWND hwnd) :
 
 Dx12Wrapper::~Dx12Wrapper()
 {
+	if (mFenceEvent != nullptr)
+	{
+		CloseHandle(mFenceEvent);
+	}
 }
 
 void Dx12Wrapper::SetCameraSetting()
@@ -201,26 +196,22 @@ void Dx12Wrapper::SetCameraSetting()
 
 	XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(mFov, static_cast<float>(wsize.cx) / static_cast<float>(wsize.cy), 0.1f, 1000.0f);
 
-	SceneMatricesData* mappedSceneMatricesData;
-	mSceneConstBuff->Map(0, nullptr, (void**)&mappedSceneMatricesData);
-
+	// Kept on the CPU until Update copies it to the upload memory of the frame being recorded
 	XMVECTOR det;
-	mappedSceneMatricesData->view = mCameraTransform->GetViewMatrix();
-	mappedSceneMatricesData->proj = projectionMatrix;
-	mappedSceneMatricesData->invProj = XMMatrixInverse(&det, projectionMatrix);
-	mappedSceneMatricesData->eye = mCameraTransform->GetPosition();
+	mSceneMatrices.view = mCameraTransform->GetViewMatrix();
+	mSceneMatrices.proj = projectionMatrix;
+	mSceneMatrices.invProj = XMMatrixInverse(&det, projectionMatrix);
+	mSceneMatrices.eye = mCameraTransform->GetPosition();
 
 	XMFLOAT4 planeVec(0, 1, 0, 0);
 	XMFLOAT3 lightPosition = mDirectionalLightTransform->GetPosition();
-	mappedSceneMatricesData->shadow = XMMatrixShadow(XMLoadFloat4(&planeVec), -XMLoadFloat3(&lightPosition));
+	mSceneMatrices.shadow = XMMatrixShadow(XMLoadFloat4(&planeVec), -XMLoadFloat3(&lightPosition));
 
 	XMFLOAT3 lightDirection = mDirectionalLightTransform->GetForward();
-	mappedSceneMatricesData->light = XMFLOAT4(lightDirection.x, lightDirection.y, lightDirection.z, 0);
+	mSceneMatrices.light = XMFLOAT4(lightDirection.x, lightDirection.y, lightDirection.z, 0);
 
 	XMMATRIX lightMatrix = mDirectionalLightTransform->GetViewMatrix();
-	mappedSceneMatricesData->lightCamera = lightMatrix * XMMatrixOrthographicLH(60, 60, 1.0f, 1000.0f);
-
-	mSceneConstBuff->Unmap(0, nullptr);
+	mSceneMatrices.lightCamera = lightMatrix * XMMatrixOrthographicLH(60, 60, 1.0f, 1000.0f);
 }
 
 void Dx12Wrapper::PreDrawStencil()
@@ -229,48 +220,39 @@ void Dx12Wrapper::PreDrawStencil()
 	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 
-	mCmdList->OMSetRenderTargets(0, nullptr, false, &handle);
-	mCmdList->ClearDepthStencilView(handle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
-	mCmdList->OMSetStencilRef(1);
+	RecordingCommandList()->OMSetRenderTargets(0, nullptr, false, &handle);
+	RecordingCommandList()->ClearDepthStencilView(handle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+	RecordingCommandList()->OMSetStencilRef(1);
 	
 	auto wsize = Application::Instance().GetWindowSize();
 
-	ID3D12DescriptorHeap* sceneheaps[] = { mSceneDescHeap.Get() };
-	mCmdList->SetDescriptorHeaps(1, sceneheaps);
-	mCmdList->SetGraphicsRootDescriptorTable(0, mSceneDescHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(0, mSceneBufferAddress);
 
 	D3D12_VIEWPORT vp = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
-	mCmdList->RSSetViewports(1, &vp);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, wsize.cx, wsize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 }
 
 void Dx12Wrapper::PreDrawReflection() const
 {
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mReflectionBuffer.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-	mCmdList->ResourceBarrier(1, &barrier);
-
 	auto dsvHandle = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
 	dsvHandle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV) * 2;
 
 	auto rtvHeapPointer = mPeraRTVHeap->GetCPUDescriptorHandleForHeapStart();
 	rtvHeapPointer.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV) * 6;
 
-	mCmdList->OMSetRenderTargets(1, &rtvHeapPointer, false, &dsvHandle);
-	mCmdList->OMSetStencilRef(1);
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvHeapPointer, false, &dsvHandle);
+	RecordingCommandList()->OMSetStencilRef(1);
 
 	float clearColorBlack[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-	mCmdList->ClearRenderTargetView(rtvHeapPointer, clearColorBlack, 0, nullptr);
+	RecordingCommandList()->ClearRenderTargetView(rtvHeapPointer, clearColorBlack, 0, nullptr);
 
-	ID3D12DescriptorHeap* sceneheaps[] = { mSceneDescHeap.Get() };
-	mCmdList->SetDescriptorHeaps(1, sceneheaps);
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(0, mSceneBufferAddress);
 
-	auto heapHandle = mSceneDescHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetGraphicsRootDescriptorTable(0, heapHandle);
+	// Recorded in its own list, so the stencil pass viewport does not carry over
+	SetRSSetViewportsAndScissorRectsByScreenSize();
 }
 
 void Dx12Wrapper::PreDrawShadow() const
@@ -278,30 +260,23 @@ void Dx12Wrapper::PreDrawShadow() const
 	auto handle = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
 	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 
-	mCmdList->OMSetRenderTargets(0, nullptr, false, &handle);
+	RecordingCommandList()->OMSetRenderTargets(0, nullptr, false, &handle);
 
-	mCmdList->ClearDepthStencilView(handle,
+	RecordingCommandList()->ClearDepthStencilView(handle,
 		D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 	auto wsize = Application::Instance().GetWindowSize();
 
-	ID3D12DescriptorHeap* heaps[] = { mSceneDescHeap.Get() };
-
-	heaps[0] = mSceneDescHeap.Get();
-	mCmdList->SetDescriptorHeaps(1, heaps);
-	auto sceneHandle = mSceneDescHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetGraphicsRootDescriptorTable(0, sceneHandle);
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(0, mSceneBufferAddress);
 
 	D3D12_VIEWPORT vp = CD3DX12_VIEWPORT(0.0f, 0.0f, shadow_difinition, shadow_difinition);
-	mCmdList->RSSetViewports(1, &vp);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, shadow_difinition, shadow_difinition);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 }
 
 void Dx12Wrapper::PreDrawToPera1() const
 {
-	ChangeResourceBarrierFinalRenderTarget(D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-	ChangeToDepthWriteMainDepthBuffer();
 	SetFinalRenderTarget();
 	ClearFinalRenderTarget();
 }
@@ -310,135 +285,73 @@ void Dx12Wrapper::DrawToPera1()
 {
 	auto wsize = Application::Instance().GetWindowSize();
 
-	ID3D12DescriptorHeap* sceneheaps[] = { mSceneDescHeap.Get() };
-	mCmdList->SetDescriptorHeaps(1, sceneheaps);
-	mCmdList->SetGraphicsRootDescriptorTable(0, mSceneDescHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(0, mSceneBufferAddress);
 
 	D3D12_VIEWPORT vp = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
-	mCmdList->RSSetViewports(1, &vp);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, wsize.cx, wsize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 
-	mCmdList->SetDescriptorHeaps(1, mDepthSRVHeap.GetAddressOf());
-	auto handle = mDepthSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	mCmdList->SetGraphicsRootDescriptorTable(3, handle);
+	auto handle = mDescriptorHeap.GetGpuHandle(mDepthDescriptors.index + 1);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(3, handle);
 }
 
 void Dx12Wrapper::DrawToPera1ForFbx()
 {
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mReflectionBuffer.Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-
-	mCmdList->ResourceBarrier(1, &barrier);
-
 	auto wsize = Application::Instance().GetWindowSize();
 
-	ID3D12DescriptorHeap* sceneheaps[] = { mSceneDescHeap.Get() };
-	mCmdList->SetDescriptorHeaps(1, sceneheaps);
-	mCmdList->SetGraphicsRootDescriptorTable(0, mSceneDescHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(0, mSceneBufferAddress);
 
 	D3D12_VIEWPORT vp = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
-	mCmdList->RSSetViewports(1, &vp);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, wsize.cx, wsize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
-
-	mCmdList->SetDescriptorHeaps(1, mDepthSRVHeap.GetAddressOf());
-	auto handle = mDepthSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	mCmdList->SetGraphicsRootDescriptorTable(3, handle);
-
-	mCmdList->SetDescriptorHeaps(1, mPeraSRVHeap.GetAddressOf());
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 
-	auto reflectionTextureHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	auto incSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	reflectionTextureHandle.ptr += incSize * 8;
-	mCmdList->SetGraphicsRootDescriptorTable(4, reflectionTextureHandle);
-}
+	auto handle = mDescriptorHeap.GetGpuHandle(mDepthDescriptors.index + 1);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(3, handle);
 
-void Dx12Wrapper::PostDrawToPera1()
-{
-	for (auto& resource : mPera1Resource)
-	{
-		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(),
-			D3D12_RESOURCE_STATE_RENDER_TARGET,
-			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-		mCmdList->ResourceBarrier(1, &barrier);
-	}
+	auto reflectionTextureHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index + 8);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(4, reflectionTextureHandle);
 }
 
 void Dx12Wrapper::DrawAmbientOcclusion()
 {
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mAoBuffer.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_RENDER_TARGET);
-	mCmdList->ResourceBarrier(1, &barrier);
-
 	auto rtvBaseHandle = mAoRenderTargetViewDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-	mCmdList->OMSetRenderTargets(1, &rtvBaseHandle, false, nullptr);
-	mCmdList->SetGraphicsRootSignature(mPeraRootSignature.Get());
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvBaseHandle, false, nullptr);
+	RecordingCommandList()->SetGraphicsRootSignature(mPeraRootSignature.Get());
 
 	auto wsize = Application::Instance().GetWindowSize();
 
 	D3D12_VIEWPORT vp = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
-	mCmdList->RSSetViewports(1, &vp);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, wsize.cx, wsize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 
-	mCmdList->SetDescriptorHeaps(1, mPeraSRVHeap.GetAddressOf());
+	auto srvHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(0, srvHandle);
 
-	auto srvHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetGraphicsRootDescriptorTable(0, srvHandle);
+	auto srvDSVHandle = mDescriptorHeap.GetGpuHandle(mDepthDescriptors.index);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(1, srvDSVHandle);
 
-	mCmdList->SetDescriptorHeaps(1, mDepthSRVHeap.GetAddressOf());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(3, mSceneBufferAddress);
 
-	auto srvDSVHandle = mDepthSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetGraphicsRootDescriptorTable(1, srvDSVHandle);
+	RecordingCommandList()->SetPipelineState(mAoPipeline.Get());
+	RecordingCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 
-	mCmdList->SetDescriptorHeaps(1, mSceneDescHeap.GetAddressOf());
-
-	auto sceneConstantViewHandle = mSceneDescHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetGraphicsRootDescriptorTable(3, sceneConstantViewHandle);
-
-	mCmdList->SetPipelineState(mAoPipeline.Get());
-	mCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-
-	mCmdList->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
-	mCmdList->DrawInstanced(4, 1, 0, 0);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mAoBuffer.Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
+	RecordingCommandList()->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
+	RecordingCommandList()->DrawInstanced(4, 1, 0, 0);
 }
 
 void Dx12Wrapper::DrawShrinkTextureForBlur()
 {
-	mCmdList->SetPipelineState(mBlurShrinkPipeline.Get());
-	mCmdList->SetGraphicsRootSignature(mPeraRootSignature.Get());
-
-	mCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	mCmdList->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
-
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mBloomBuffer[0].Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mBloomBuffer[1].Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_RENDER_TARGET);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mDofBuffer.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_RENDER_TARGET);
-	mCmdList->ResourceBarrier(1, &barrier);
+	RecordingCommandList()->SetPipelineState(mBlurShrinkPipeline.Get());
+	RecordingCommandList()->SetGraphicsRootSignature(mPeraRootSignature.Get());
 
+	RecordingCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	RecordingCommandList()->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
 
 	auto rtvBaseHandle = mPeraRTVHeap->GetCPUDescriptorHandleForHeapStart();
 	auto rtvIncSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
@@ -448,12 +361,11 @@ void Dx12Wrapper::DrawShrinkTextureForBlur()
 	rtvHandles[0].InitOffsetted(rtvBaseHandle, rtvIncSize * 3);
 	rtvHandles[1].InitOffsetted(rtvBaseHandle, rtvIncSize * 4);
 
-	mCmdList->OMSetRenderTargets(2, rtvHandles, false, nullptr);
+	RecordingCommandList()->OMSetRenderTargets(2, rtvHandles, false, nullptr);
 
-	auto srvHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
+	auto srvHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index);
 
-	mCmdList->SetDescriptorHeaps(1, mPeraSRVHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(0, srvHandle);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(0, srvHandle);
 
 	auto desc = mBloomBuffer[0]->GetDesc();
 	D3D12_VIEWPORT vp = {};
@@ -470,9 +382,9 @@ void Dx12Wrapper::DrawShrinkTextureForBlur()
 
 	for (int i = 0; i < mBloomIteration; ++i)
 	{
-		mCmdList->RSSetViewports(1, &vp);
-		mCmdList->RSSetScissorRects(1, &sr);
-		mCmdList->DrawInstanced(4, 1, 0, 0);
+		RecordingCommandList()->RSSetViewports(1, &vp);
+		RecordingCommandList()->RSSetScissorRects(1, &sr);
+		RecordingCommandList()->DrawInstanced(4, 1, 0, 0);
 
 		sr.top += vp.Height;
 		vp.TopLeftX = 0;
@@ -482,139 +394,84 @@ void Dx12Wrapper::DrawShrinkTextureForBlur()
 		vp.Height /= 2;
 		sr.bottom = sr.top + vp.Height;
 	}
+}
 
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mBloomBuffer[1].Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mDofBuffer.Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mBloomResultTexture.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_RENDER_TARGET);
-	mCmdList->ResourceBarrier(1, &barrier);
-
+void Dx12Wrapper::DrawBloomResult()
+{
 	auto wsize = Application::Instance().GetWindowSize();
 
-	vp = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
-	mCmdList->RSSetViewports(1, &vp);
+	auto vp = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, wsize.cx, wsize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 
-	mCmdList->SetPipelineState(mBlurResultPipeline.Get());
-	mCmdList->SetGraphicsRootSignature(mBlurResultRootSignature.Get());
+	RecordingCommandList()->SetPipelineState(mBlurResultPipeline.Get());
+	RecordingCommandList()->SetGraphicsRootSignature(mBlurResultRootSignature.Get());
 
-	mCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	mCmdList->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
+	RecordingCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	RecordingCommandList()->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
 
-	rtvBaseHandle = mPeraRTVHeap->GetCPUDescriptorHandleForHeapStart();
+	auto rtvBaseHandle = mPeraRTVHeap->GetCPUDescriptorHandleForHeapStart();
 	rtvBaseHandle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV) * 5;
 
-	mCmdList->OMSetRenderTargets(1, &rtvBaseHandle, false, nullptr);
-
-	srvHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	srvHandle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) * 2;
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvBaseHandle, false, nullptr);
 
-	mCmdList->SetDescriptorHeaps(1, mPeraSRVHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(0, srvHandle);
+	auto srvHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index + 2);
 
-	auto bloomParameterSrvHandle = mPostProcessParameterSRVHeap->GetGPUDescriptorHandleForHeapStart();
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(0, srvHandle);
 
-	mCmdList->SetDescriptorHeaps(1, mPostProcessParameterSRVHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(1, bloomParameterSrvHandle);
+	SetPostProcessParameterBuffer(1);
 
-	mCmdList->DrawInstanced(4, 1, 0, 0);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mBloomResultTexture.Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
+	RecordingCommandList()->DrawInstanced(4, 1, 0, 0);
 }
 
 void Dx12Wrapper::DrawScreenSpaceReflection()
 {
-	ChangeResourceBarrierFinalRenderTarget(D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mSsrTexture.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_RENDER_TARGET);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mSsrMaskBuffer.Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mReflectionBuffer.Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	ChangeToShaderResourceMainDepthBuffer();
-
 	auto wsize = Application::Instance().GetWindowSize();
 
 	auto viewport = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
-	mCmdList->RSSetViewports(1, &viewport);
+	RecordingCommandList()->RSSetViewports(1, &viewport);
 
 	CD3DX12_RECT rc(0, 0, wsize.cx, wsize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 
-	mCmdList->SetPipelineState(mSsrPipeline.Get());
-	mCmdList->SetGraphicsRootSignature(mSsrRootSignature.Get());
+	RecordingCommandList()->SetPipelineState(mSsrPipeline.Get());
+	RecordingCommandList()->SetGraphicsRootSignature(mSsrRootSignature.Get());
 
-	mCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	mCmdList->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
+	RecordingCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	RecordingCommandList()->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
 
 	auto rtvBaseHandle = mPeraRTVHeap->GetCPUDescriptorHandleForHeapStart();
 	rtvBaseHandle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV) * 8;
 
 	float clearColor[4] = { 0.0,0.0,0.0,1.0 };
-	mCmdList->ClearRenderTargetView(rtvBaseHandle, clearColor, 0, nullptr);
-	mCmdList->OMSetRenderTargets(1, &rtvBaseHandle, false, nullptr);
-
-	mCmdList->SetDescriptorHeaps(1, mSceneDescHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(0, mSceneDescHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->ClearRenderTargetView(rtvBaseHandle, clearColor, 0, nullptr);
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvBaseHandle, false, nullptr);
 
-	mCmdList->SetDescriptorHeaps(1, mPeraSRVHeap.GetAddressOf());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(0, mSceneBufferAddress);
 
-	auto rtvSrvHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
+	auto rtvSrvHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index);
 	auto rtvSrvIncreaseSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	mCmdList->SetGraphicsRootDescriptorTable(1, rtvSrvHandle);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(1, rtvSrvHandle);
 
 	rtvSrvHandle.ptr += rtvSrvIncreaseSize;
-	mCmdList->SetGraphicsRootDescriptorTable(2, rtvSrvHandle);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(2, rtvSrvHandle);
 
-	auto ssrMaskHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	ssrMaskHandle.ptr += rtvSrvIncreaseSize * 7;
-	mCmdList->SetGraphicsRootDescriptorTable(3, ssrMaskHandle);
+	auto ssrMaskHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index + 7);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(3, ssrMaskHandle);
 
-	auto planerReflectionHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	planerReflectionHandle.ptr += rtvSrvIncreaseSize * 6;
-	mCmdList->SetGraphicsRootDescriptorTable(4, planerReflectionHandle);
+	auto planerReflectionHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index + 6);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(4, planerReflectionHandle);
 
-	mCmdList->SetDescriptorHeaps(1, mDepthSRVHeap.GetAddressOf());
-	auto depthHandle = mDepthSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetGraphicsRootDescriptorTable(5, depthHandle);
+	auto depthHandle = mDescriptorHeap.GetGpuHandle(mDepthDescriptors.index);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(5, depthHandle);
 
 	SetPostProcessParameterBuffer(6);
-	SetResolutionDescriptorHeap(7);
-
-	mCmdList->DrawInstanced(4, 1, 0, 0);
+	SetResolutionBuffer(7);
 
-	barrier = CD3DX12_RESOURCE_BARRIER::Transition(mSsrTexture.Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	mCmdList->ResourceBarrier(1, &barrier);
-
-	ChangeToDepthWriteMainDepthBuffer();
-	ChangeResourceBarrierFinalRenderTarget(D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	RecordingCommandList()->DrawInstanced(4, 1, 0, 0);
 }
 
 void Dx12Wrapper::Clear()
@@ -624,10 +481,10 @@ void Dx12Wrapper::Clear()
 	auto rtvHeapPointer = mRtvHeaps->GetCPUDescriptorHandleForHeapStart();
 	rtvHeapPointer.ptr += backBufferIndex * mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
-	mCmdList->OMSetRenderTargets(1, &rtvHeapPointer, false, nullptr);
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvHeapPointer, false, nullptr);
 
 	float clsClr[4] = { 0.0,0.0,0.0,1.0 };
-	mCmdList->ClearRenderTargetView(rtvHeapPointer, clsClr, 0, nullptr);
+	RecordingCommandList()->ClearRenderTargetView(rtvHeapPointer, clsClr, 0, nullptr);
 }
 
 void Dx12Wrapper::Draw()
@@ -635,52 +492,61 @@ void Dx12Wrapper::Draw()
 	auto wsize = Application::Instance().GetWindowSize();
 
 	D3D12_VIEWPORT vp = CD3DX12_VIEWPORT(0.0f, 0.0f, wsize.cx, wsize.cy);
-	mCmdList->RSSetViewports(1, &vp);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, wsize.cx, wsize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 
-	mCmdList->SetGraphicsRootSignature(mPeraRootSignature.Get());
-	mCmdList->SetDescriptorHeaps(1, mPeraSRVHeap.GetAddressOf());
+	RecordingCommandList()->SetGraphicsRootSignature(mPeraRootSignature.Get());
 
-	auto handle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetGraphicsRootDescriptorTable(0, handle);
+	auto handle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(0, handle);
 
-	auto depthHandle = mDepthSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetDescriptorHeaps(1, mDepthSRVHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(1, depthHandle);
+	auto depthHandle = mDescriptorHeap.GetGpuHandle(mDepthDescriptors.index);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(1, depthHandle);
 
-	mCmdList->SetDescriptorHeaps(1, mAoSRVDescriptorHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(2, mAoSRVDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(2, mDescriptorHeap.GetGpuHandle(mAoDescriptor.index));
 
 	if ((mCurrentPPFlag & BLOOM) == BLOOM &&
 		(mCurrentPPFlag & SSAO) == SSAO)
 	{
-		mCmdList->SetPipelineState(mScreenPipelineBloomSSAO.Get());
+		RecordingCommandList()->SetPipelineState(mScreenPipelineBloomSSAO.Get());
 	}
 	else if ((mCurrentPPFlag & BLOOM) == BLOOM)
 	{
-		mCmdList->SetPipelineState(mScreenPipelineBloom.Get());
+		RecordingCommandList()->SetPipelineState(mScreenPipelineBloom.Get());
 	}
 	else if ((mCurrentPPFlag & SSAO) == SSAO)
 	{
-		mCmdList->SetPipelineState(mScreenPipelineSSAO.Get());
+		RecordingCommandList()->SetPipelineState(mScreenPipelineSSAO.Get());
 	}
 	else
 	{
-		mCmdList->SetPipelineState(mScreenPipelineDefault.Get());
+		RecordingCommandList()->SetPipelineState(mScreenPipelineDefault.Get());
 	}
 
-	mCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	mCmdList->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
-	//mCmdList->SetDescriptorHeaps(1, _distortionSRVHeap.GetAddressOf());
-	//mCmdList->SetGraphicsRootDescriptorTable(2, _distortionSRVHeap->GetGPUDescriptorHandleForHeapStart());
-	mCmdList->DrawInstanced(4, 1, 0, 0);
+	RecordingCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	RecordingCommandList()->IASetVertexBuffers(0, 1, &mPeraVertexBufferView);
+	//RecordingCommandList()->SetDescriptorHeaps(1, _distortionSRVHeap.GetAddressOf());
+	//RecordingCommandList()->SetGraphicsRootDescriptorTable(2, _distortionSRVHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->DrawInstanced(4, 1, 0, 0);
 }
 
 void Dx12Wrapper::Update()
 {
-	UpdateGlobalParameterBuffer();
+	static std::random_device randomDevice;
+	static std::mt19937 generator(randomDevice());
+	static std::uniform_int_distribution<int> distribution(0, 99);
+
+	GlobalParameterBuffer globalParameter = {};
+	globalParameter.time = Time::GetTimeFloat();
+	globalParameter.randomSeed = distribution(generator);
+
+	// Everything the passes of this frame read, so later edits never reach a frame the GPU is still on
+	mSceneBufferAddress = UploadConstantBuffer(&mSceneMatrices, sizeof(SceneMatricesData));
+	mResolutionBufferAddress = UploadConstantBuffer(&mResolution, sizeof(ResolutionBuffer));
+	mGlobalParameterBufferAddress = UploadConstantBuffer(&globalParameter, sizeof(GlobalParameterBuffer));
+	mPostProcessParameterBufferAddress = UploadConstantBuffer(&mPostProcessParameter, sizeof(BloomParameter));
 }
 
 void Dx12Wrapper::BeginDraw()
@@ -697,60 +563,243 @@ void Dx12Wrapper::BeginDraw()
 	BarrierDesc.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
 	BarrierDesc.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
 
-	mCmdList->ResourceBarrier(1, &BarrierDesc);
+	RecordingCommandList()->ResourceBarrier(1, &BarrierDesc);
 
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvH = mRtvHeaps->GetCPUDescriptorHandleForHeapStart();
 	rtvH.ptr += bbIdx * mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
 	auto dsvH = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
-	mCmdList->OMSetRenderTargets(1, &rtvH, true, &dsvH);
-	mCmdList->ClearDepthStencilView(dsvH, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvH, true, &dsvH);
+	RecordingCommandList()->ClearDepthStencilView(dsvH, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
 	float clearColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	mCmdList->ClearRenderTargetView(rtvH, clearColor, 0, nullptr);
+	RecordingCommandList()->ClearRenderTargetView(rtvH, clearColor, 0, nullptr);
 
-	mCmdList->RSSetViewports(1, mViewport.get());
-	mCmdList->RSSetScissorRects(1, mScissorRect.get());
+	RecordingCommandList()->RSSetViewports(1, mViewport.get());
+	RecordingCommandList()->RSSetScissorRects(1, mScissorRect.get());
 }
 
 void Dx12Wrapper::EndDraw()
 {
-	int bbIdx = mSwapChain->GetCurrentBackBufferIndex();
+	mFrameContexts[mFrameContextIndex].fenceValue = ++mFenceVal;
+	mCmdQueue->Signal(mFence.Get(), mFenceVal);
 
-	D3D12_RESOURCE_BARRIER BarrierDesc = {};
+	mSwapChain->Present(0, 0);
 
-	BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	BarrierDesc.Transition.pResource = mBackBuffers[bbIdx];
-	BarrierDesc.Transition.Subresource = 0;
+	mFrameIndex++;
+	mFrameContextIndex = static_cast<unsigned int>(mFrameIndex % frames_in_flight);
+
+	// Only waits when the GPU is still on the frame that last used this context
+	FrameContext& frameContext = mFrameContexts[mFrameContextIndex];
+
+	auto waitStartTime = std::chrono::steady_clock::now();
+	WaitForFrameContext(frameContext.fenceValue);
+	mFrameWaitTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitStartTime).count();
 
-	BarrierDesc.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-	BarrierDesc.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+	frameContext.releaseResources.clear();
 
-	mCmdList->ResourceBarrier(1, &BarrierDesc);
+	for (const DescriptorRange& range : frameContext.releaseDescriptors)
+	{
+		mDescriptorHeap.Free(range);
+	}
+	frameContext.releaseDescriptors.clear();
+
+	mUploadUsedSize = mUploadAllocator.GetUsedSize();
+	mUploadAllocator.BeginFrame(mFrameContextIndex);
+
+	frameContext.cmdAllocator->Reset();
+	mCmdList->Reset(frameContext.cmdAllocator.Get(), nullptr);
+
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mDescriptorHeap.GetHeap() };
+	mCmdList->SetDescriptorHeaps(1, descriptorHeaps);
+}
+
+void Dx12Wrapper::BeginFrame(unsigned int passCount)
+{
+	std::vector<ComPtr<ID3D12CommandAllocator>>& passCmdAllocators = mFrameContexts[mFrameContextIndex].passCmdAllocators;
+
+	while (passCmdAllocators.size() < passCount)
+	{
+		ComPtr<ID3D12CommandAllocator> allocator = nullptr;
+		auto result = mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(allocator.ReleaseAndGetAddressOf()));
+		assert(SUCCEEDED(result));
 
+		passCmdAllocators.push_back(allocator);
+	}
+
+	while (mPassCmdLists.size() < passCount)
+	{
+		ComPtr<ID3D12GraphicsCommandList> cmdList = nullptr;
+		auto result = mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, passCmdAllocators[mPassCmdLists.size()].Get(), nullptr, IID_PPV_ARGS(cmdList.ReleaseAndGetAddressOf()));
+		assert(SUCCEEDED(result));
+
+		// Closed like the lists of the last frame, so every list is reset the same way below
+		cmdList->Close();
+
+		mPassCmdLists.push_back(cmdList);
+	}
+
+	mPassCount = passCount;
+	mPreviousRecordingCmdLists.resize(passCount, nullptr);
+
+	ID3D12DescriptorHeap* descriptorHeaps[] = { mDescriptorHeap.GetHeap() };
+
+	// A submitted list can be reset right away, only its allocator has to wait for the GPU.
+	// EndDraw waited for the frame that last used the allocators of this context
+	for (unsigned int pass = 0; pass < passCount; pass++)
+	{
+		passCmdAllocators[pass]->Reset();
+		mPassCmdLists[pass]->Reset(passCmdAllocators[pass].Get(), nullptr);
+		mPassCmdLists[pass]->SetDescriptorHeaps(1, descriptorHeaps);
+	}
+}
+
+void Dx12Wrapper::BeginPass(unsigned int pass)
+{
+	// A thread waiting inside one pass may pick up another, so passes nest per thread
+	mPreviousRecordingCmdLists[pass] = recordingCommandList;
+	recordingCommandList = mPassCmdLists[pass].Get();
+}
+
+void Dx12Wrapper::EndPass(unsigned int pass)
+{
+	recordingCommandList = mPreviousRecordingCmdLists[pass];
+}
+
+void Dx12Wrapper::Submit()
+{
+	assert(mPassCount > 0);
+
+	// Every pass has finished recording, the render graph already put the back buffer back to present in the last one
 	mCmdList->Close();
+	mSubmitCmdLists.clear();
+	mSubmitCmdLists.push_back(mCmdList.Get());
 
-	ID3D12CommandList* cmdlists[] = { mCmdList.Get() };
-	mCmdQueue->ExecuteCommandLists(1, cmdlists);
+	for (unsigned int pass = 0; pass < mPassCount; pass++)
+	{
+		mPassCmdLists[pass]->Close();
+		mSubmitCmdLists.push_back(mPassCmdLists[pass].Get());
+	}
 
+	mCmdQueue->ExecuteCommandLists(static_cast<UINT>(mSubmitCmdLists.size()), mSubmitCmdLists.data());
+}
+
+void Dx12Wrapper::WaitForGpu()
+{
 	mCmdQueue->Signal(mFence.Get(), ++mFenceVal);
+	WaitForFrameContext(mFenceVal);
+}
 
-	if (mFence->GetCompletedValue() != mFenceVal)
-	{
-		HANDLE event = CreateEvent(nullptr, false, false, nullptr);
+UINT64 Dx12Wrapper::GetFrameIndex() const
+{
+	return mFrameIndex;
+}
 
-		mFence->SetEventOnCompletion(mFenceVal, event);
+float Dx12Wrapper::GetFrameWaitTime() const
+{
+	return mFrameWaitTime;
+}
 
-		WaitForSingleObject(event, INFINITE);
+void Dx12Wrapper::ReleaseAfterFrame(ComPtr<ID3D12Resource> resource)
+{
+	mFrameContexts[mFrameContextIndex].releaseResources.push_back(resource);
+}
 
-		CloseHandle(event);
+UploadAllocation Dx12Wrapper::AllocateUpload(size_t size)
+{
+	return mUploadAllocator.Allocate(size);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS Dx12Wrapper::UploadConstantBuffer(const void* data, size_t size)
+{
+	UploadAllocation allocation = mUploadAllocator.Allocate(size);
+	if (allocation.cpuAddress == nullptr)
+	{
+		return 0;
 	}
 
-	mCmdAllocator->Reset();
-	mCmdList->Reset(mCmdAllocator.Get(), nullptr);
+	memcpy(allocation.cpuAddress, data, size);
 
-	mSwapChain->Present(0, 0);
+	return allocation.gpuAddress;
+}
+
+size_t Dx12Wrapper::GetUploadUsedSize() const
+{
+	return mUploadUsedSize;
+}
+
+size_t Dx12Wrapper::GetUploadRegionSize() const
+{
+	return mUploadAllocator.GetRegionSize();
+}
+
+DescriptorRange Dx12Wrapper::AllocateDescriptors(unsigned int count)
+{
+	return mDescriptorHeap.Allocate(count);
+}
+
+void Dx12Wrapper::FreeDescriptorsAfterFrame(const DescriptorRange& range)
+{
+	mFrameContexts[mFrameContextIndex].releaseDescriptors.push_back(range);
+}
+
+const DescriptorHeap& Dx12Wrapper::GetDescriptorHeap() const
+{
+	return mDescriptorHeap;
+}
+
+void Dx12Wrapper::AddFrameResources(RenderGraph& graph) const
+{
+	auto addResource = [&graph](FrameResource resource, const char* name, D3D12_RESOURCE_STATES state)
+	{
+		unsigned int index = graph.AddResource(name, state);
+
+		// GetFrameResource maps the graph indices back to resources
+		assert(index == static_cast<unsigned int>(resource));
+	};
+
+	addResource(FrameResource::BackBuffer, "Back Buffer", D3D12_RESOURCE_STATE_PRESENT);
+	addResource(FrameResource::Color, "Color", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::Normal, "Normal", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::HighLuminance, "High Luminance", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::ShrinkHighLuminance, "Shrink High Luminance", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::Shrink, "Shrink", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::BloomResult, "Bloom Result", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::Reflection, "Reflection", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::SsrMask, "SSR Mask", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::Ssr, "SSR", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::AmbientOcclusion, "Ambient Occlusion", D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	addResource(FrameResource::Depth, "Depth", D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	addResource(FrameResource::LightDepth, "Light Depth", D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	addResource(FrameResource::Stencil, "Stencil", D3D12_RESOURCE_STATE_DEPTH_WRITE);
+}
+
+void Dx12Wrapper::ResourceBarrier(const std::vector<RenderGraphBarrier>& barriers) const
+{
+	std::vector<D3D12_RESOURCE_BARRIER> resourceBarriers;
+	resourceBarriers.reserve(barriers.size());
+
+	for (const RenderGraphBarrier& barrier : barriers)
+	{
+		D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+		if (barrier.type == RenderGraphBarrierType::BeginOnly)
+		{
+			flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+		}
+		else if (barrier.type == RenderGraphBarrierType::EndOnly)
+		{
+			flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+		}
+
+		resourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(GetFrameResource(static_cast<FrameResource>(barrier.resource)),
+			static_cast<D3D12_RESOURCE_STATES>(barrier.before),
+			static_cast<D3D12_RESOURCE_STATES>(barrier.after),
+			D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+			flags));
+	}
+
+	RecordingCommandList()->ResourceBarrier(static_cast<UINT>(resourceBarriers.size()), resourceBarriers.data());
 }
 
 void Dx12Wrapper::SetRenderTargetByMainFrameBuffer() const
@@ -758,42 +807,32 @@ void Dx12Wrapper::SetRenderTargetByMainFrameBuffer() const
 	auto rtvHeapPointer = mPeraRTVHeap->GetCPUDescriptorHandleForHeapStart();
 	auto dsvHeapPointer = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
 
-	mCmdList->OMSetRenderTargets(1, &rtvHeapPointer, false, &dsvHeapPointer);
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvHeapPointer, false, &dsvHeapPointer);
 }
 
 void Dx12Wrapper::SetRenderTargetSSRMaskBuffer() const
 {
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mSsrMaskBuffer.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-	mCmdList->ResourceBarrier(1, &barrier);
-
 	auto rtvHeapPointer = mPeraRTVHeap->GetCPUDescriptorHandleForHeapStart();
 	rtvHeapPointer.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV) * 7;
 
 	auto dsvHeapPointer = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
 
-	mCmdList->OMSetRenderTargets(1, &rtvHeapPointer, false, &dsvHeapPointer);
+	RecordingCommandList()->OMSetRenderTargets(1, &rtvHeapPointer, false, &dsvHeapPointer);
 
 	float clearColorBlack[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-	mCmdList->ClearRenderTargetView(rtvHeapPointer, clearColorBlack, 0, nullptr);
+	RecordingCommandList()->ClearRenderTargetView(rtvHeapPointer, clearColorBlack, 0, nullptr);
 }
 
 void Dx12Wrapper::SetShaderResourceSSRMaskBuffer(unsigned int rootParameterIndex) const
 {
-	auto srvHandle = mPeraSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	srvHandle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) * 7;
+	auto srvHandle = mDescriptorHeap.GetGpuHandle(mPeraDescriptors.index + 7);
 
-	mCmdList->SetDescriptorHeaps(1, mPeraSRVHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(rootParameterIndex, srvHandle);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(rootParameterIndex, srvHandle);
 }
 
 void Dx12Wrapper::SetSceneBuffer(int rootParameterIndex) const
 {
-	ID3D12DescriptorHeap* sceneHeaps[] = { mSceneDescHeap.Get() };
-	mCmdList->SetDescriptorHeaps(1, sceneHeaps);
-	mCmdList->SetGraphicsRootDescriptorTable(rootParameterIndex, mSceneDescHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(rootParameterIndex, mSceneBufferAddress);
 }
 
 void Dx12Wrapper::SetRSSetViewportsAndScissorRectsByScreenSize() const
@@ -801,52 +840,31 @@ void Dx12Wrapper::SetRSSetViewportsAndScissorRectsByScreenSize() const
 	const auto windowSize = Application::Instance().GetWindowSize();
 
 	D3D12_VIEWPORT vp = CD3DX12_VIEWPORT(0.0f, 0.0f, windowSize.cx, windowSize.cy);
-	mCmdList->RSSetViewports(1, &vp);
+	RecordingCommandList()->RSSetViewports(1, &vp);
 
 	CD3DX12_RECT rc(0, 0, windowSize.cx, windowSize.cy);
-	mCmdList->RSSetScissorRects(1, &rc);
+	RecordingCommandList()->RSSetScissorRects(1, &rc);
 }
 
 void Dx12Wrapper::SetLightDepthTexture(int rootParameterIndex) const
 {
-	mCmdList->SetDescriptorHeaps(1, mDepthSRVHeap.GetAddressOf());
-	auto handle = mDepthSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	mCmdList->SetGraphicsRootDescriptorTable(rootParameterIndex, handle);
+	auto handle = mDescriptorHeap.GetGpuHandle(mDepthDescriptors.index + 1);
+	RecordingCommandList()->SetGraphicsRootDescriptorTable(rootParameterIndex, handle);
 }
 
-void Dx12Wrapper::SetResolutionDescriptorHeap(unsigned rootParameterIndex) const
+void Dx12Wrapper::SetResolutionBuffer(unsigned rootParameterIndex) const
 {
-	ID3D12DescriptorHeap* heap[] = { mResolutionDescHeap.Get() };
-	mCmdList->SetDescriptorHeaps(1, heap);
-	mCmdList->SetGraphicsRootDescriptorTable(rootParameterIndex, mResolutionDescHeap->GetGPUDescriptorHandleForHeapStart());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(rootParameterIndex, mResolutionBufferAddress);
 }
 
 void Dx12Wrapper::SetGlobalParameterBuffer(unsigned rootParameterIndex) const
 {
-	mCmdList->SetGraphicsRootConstantBufferView(rootParameterIndex, mGlobalParameterBuffer->GetGPUVirtualAddress());
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(rootParameterIndex, mGlobalParameterBufferAddress);
 }
 
 void Dx12Wrapper::SetPostProcessParameterBuffer(unsigned rootParameterIndex) const
 {
-	auto bloomParameterSrvHandle = mPostProcessParameterSRVHeap->GetGPUDescriptorHandleForHeapStart();
-	mCmdList->SetDescriptorHeaps(1, mPostProcessParameterSRVHeap.GetAddressOf());
-	mCmdList->SetGraphicsRootDescriptorTable(rootParameterIndex, bloomParameterSrvHandle);
-}
-
-void Dx12Wrapper::ChangeResourceBarrierFinalRenderTarget(D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) const
-{
-	for (auto& resource : mPera1Resource)
-	{
-		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), before, after);
-		mCmdList->ResourceBarrier(1, &barrier);
-	}
-
-	for (auto& resource : mBloomBuffer)
-	{
-		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), before, after);
-		mCmdList->ResourceBarrier(1, &barrier);
-	}
+	RecordingCommandList()->SetGraphicsRootConstantBufferView(rootParameterIndex, mPostProcessParameterBufferAddress);
 }
 
 void Dx12Wrapper::SetFinalRenderTarget() const
@@ -862,13 +880,13 @@ void Dx12Wrapper::SetFinalRenderTarget() const
 
 	auto dsvHeapPointer = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
 
-	mCmdList->OMSetRenderTargets(3, rtvs, false, &dsvHeapPointer);
+	RecordingCommandList()->OMSetRenderTargets(3, rtvs, false, &dsvHeapPointer);
 }
 
 void Dx12Wrapper::SetOnlyDepthBuffer() const
 {
 	auto dsvHeapPointer = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
-	mCmdList->OMSetRenderTargets(0, nullptr, false, &dsvHeapPointer);
+	RecordingCommandList()->OMSetRenderTargets(0, nullptr, false, &dsvHeapPointer);
 }
 
 void Dx12Wrapper::ClearFinalRenderTarget() const
@@ -885,28 +903,10 @@ void Dx12Wrapper::ClearFinalRenderTarget() const
 	auto dsvHeapPointer = mDepthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
 
 	float clearColorBlack[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-	mCmdList->ClearRenderTargetView(rtvs[0], clearColorBlack, 0, nullptr);
-	mCmdList->ClearRenderTargetView(rtvs[1], clearColorBlack, 0, nullptr);
-	mCmdList->ClearRenderTargetView(rtvs[2], clearColorBlack, 0, nullptr);
-	mCmdList->ClearDepthStencilView(dsvHeapPointer, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-}
-
-void Dx12Wrapper::ChangeToDepthWriteMainDepthBuffer() const
-{
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mDepthBuffer.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-		D3D12_RESOURCE_STATE_DEPTH_WRITE);
-
-	mCmdList->ResourceBarrier(1, &barrier);
-}
-
-void Dx12Wrapper::ChangeToShaderResourceMainDepthBuffer() const
-{
-	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mDepthBuffer.Get(),
-		D3D12_RESOURCE_STATE_DEPTH_WRITE,
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-
-	mCmdList->ResourceBarrier(1, &barrier);
+	RecordingCommandList()->ClearRenderTargetView(rtvs[0], clearColorBlack, 0, nullptr);
+	RecordingCommandList()->ClearRenderTargetView(rtvs[1], clearColorBlack, 0, nullptr);
+	RecordingCommandList()->ClearRenderTargetView(rtvs[2], clearColorBlack, 0, nullptr);
+	RecordingCommandList()->ClearDepthStencilView(dsvHeapPointer, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 }
 
 ComPtr<ID3D12Device> Dx12Wrapper::Device()
@@ -916,7 +916,7 @@ ComPtr<ID3D12Device> Dx12Wrapper::Device()
 
 ComPtr<ID3D12GraphicsCommandList> Dx12Wrapper::CommandList()
 {
-	return mCmdList;
+	return RecordingCommandList();
 }
 
 ComPtr<IDXGISwapChain4> Dx12Wrapper::SwapChain()
@@ -924,11 +924,6 @@ ComPtr<IDXGISwapChain4> Dx12Wrapper::SwapChain()
 	return mSwapChain;
 }
 
-ComPtr<ID3D12DescriptorHeap> Dx12Wrapper::GetHeapForImgui()
-{
-	return mHeapForImgui;
-}
-
 ComPtr<ID3D12Resource> Dx12Wrapper::GetTextureByPath(const char* texpath)
 {
 	auto it = mResourceTable.find(texpath);
@@ -972,48 +967,33 @@ ComPtr<ID3D12Resource> Dx12Wrapper::GetGradTexture()
 
 int Dx12Wrapper::GetBloomIteration() const
 {
-	return mMappedPostProcessParameter->iteration;
+	return mPostProcessParameter.iteration;
 }
 
 void Dx12Wrapper::SetBloomIteration(int iteration)
 {
-	if (mMappedPostProcessParameter == nullptr)
-	{
-		return;
-	}
-
 	mBloomIteration = iteration;
-	mMappedPostProcessParameter->iteration = iteration;
+	mPostProcessParameter.iteration = iteration;
 }
 
 float Dx12Wrapper::GetBloomIntensity() const
 {
-	return mMappedPostProcessParameter->intensity;
+	return mPostProcessParameter.intensity;
 }
 
 void Dx12Wrapper::SetBloomIntensity(float intensity)
 {
-	if (mMappedPostProcessParameter == nullptr)
-	{
-		return;
-	}
-
-	mMappedPostProcessParameter->intensity = intensity;
+	mPostProcessParameter.intensity = intensity;
 }
 
 float Dx12Wrapper::GetScreenSpaceReflectionStepSize() const
 {
-	return mMappedPostProcessParameter->screenSpaceReflectionStepSize;
+	return mPostProcessParameter.screenSpaceReflectionStepSize;
 }
 
 void Dx12Wrapper::SetScreenSpaceReflectionStepSize(float stepSize)
 {
-	if (mMappedPostProcessParameter == nullptr)
-	{
-		return;
-	}
-
-	mMappedPostProcessParameter->screenSpaceReflectionStepSize = stepSize;
+	mPostProcessParameter.screenSpaceReflectionStepSize = stepSize;
 }
 
 void Dx12Wrapper::SetFov(float fov)
@@ -1113,14 +1093,19 @@ HRESULT Dx12Wrapper::InitializeDXGIDevice()
 
 HRESULT Dx12Wrapper::InitializeCommand()
 {
-	auto result = mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(mCmdAllocator.ReleaseAndGetAddressOf()));
-	if (FAILED(result))
+	HRESULT result = S_OK;
+
+	for (FrameContext& frameContext : mFrameContexts)
 	{
-		assert(0);
-		return result;
+		result = mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(frameContext.cmdAllocator.ReleaseAndGetAddressOf()));
+		if (FAILED(result))
+		{
+			assert(0);
+			return result;
+		}
 	}
 
-	result = mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mCmdAllocator.Get(), nullptr, IID_PPV_ARGS(mCmdList.ReleaseAndGetAddressOf()));
+	result = mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mFrameContexts[mFrameContextIndex].cmdAllocator.Get(), nullptr, IID_PPV_ARGS(mCmdList.ReleaseAndGetAddressOf()));
 	if (FAILED(result))
 	{
 		assert(0);
@@ -1205,35 +1190,10 @@ HRESULT Dx12Wrapper::CreateFinalRenderTargets()
 	return result;
 }
 
-HRESULT Dx12Wrapper::CreateSceneView()
+HRESULT Dx12Wrapper::CreateFrameConstants()
 {
 	DXGI_SWAP_CHAIN_DESC1 desc = {};
 	auto result = mSwapChain->GetDesc1(&desc);
-	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	auto resDesc = CD3DX12_RESOURCE_DESC::Buffer((sizeof(SceneMatricesData) + 0xff) & ~0xff);
-
-	result = mDevice->CreateCommittedResource(
-		&heapProp,
-		D3D12_HEAP_FLAG_NONE,
-		&resDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mSceneConstBuff.ReleaseAndGetAddressOf())
-	);
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	SceneMatricesData* mappedSceneMatricesData;
-	mSceneConstBuff->Map(0, nullptr, (void**)&mappedSceneMatricesData);
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
 
 	XMFLOAT3 eye(0, 10, -30);
 	XMFLOAT3 target(0, 10, 0);
@@ -1242,164 +1202,25 @@ HRESULT Dx12Wrapper::CreateSceneView()
 	XMMATRIX lookMatrix = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMLoadFloat3(&up));
 	XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(mFov, static_cast<float>(desc.Width) / static_cast<float>(desc.Height), 0.1f, 1000.0f);
 
-	mappedSceneMatricesData->view = lookMatrix;
-	mappedSceneMatricesData->proj = projectionMatrix;
-	mappedSceneMatricesData->eye = eye;
+	mSceneMatrices = {};
+	mSceneMatrices.view = lookMatrix;
+	mSceneMatrices.proj = projectionMatrix;
+	mSceneMatrices.eye = eye;
 
 	XMFLOAT4 planeVec(0, 1, 0, 0);
-	mappedSceneMatricesData->shadow = XMMatrixShadow(XMLoadFloat4(&planeVec), -XMLoadFloat3(&eye));
-
-	mSceneConstBuff->Unmap(0, nullptr);
-
-	D3D12_DESCRIPTOR_HEAP_DESC descHeapDesc = {};
-	descHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	descHeapDesc.NodeMask = 0;
-	descHeapDesc.NumDescriptors = 1;
-	descHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	result = mDevice->CreateDescriptorHeap(&descHeapDesc, IID_PPV_ARGS(mSceneDescHeap.ReleaseAndGetAddressOf()));
-
-	auto heapHandle = mSceneDescHeap->GetCPUDescriptorHandleForHeapStart();
-	auto incSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-	cbvDesc.BufferLocation = mSceneConstBuff->GetGPUVirtualAddress();
-	cbvDesc.SizeInBytes = mSceneConstBuff->GetDesc().Width;
-
-	mDevice->CreateConstantBufferView(&cbvDesc, heapHandle);
-
-	return result;
-}
-
-HRESULT Dx12Wrapper::CreateBloomParameterResource()
-{
-	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-
-	unsigned int size = sizeof(BloomParameter);
-	unsigned int alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
-	unsigned int width = size + alignment - (size % alignment);
-
-	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(width);
-
-	auto result = mDevice->CreateCommittedResource(
-		&heapProp,
-		D3D12_HEAP_FLAG_NONE,
-		&resourceDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ, 
-		nullptr, 
-		IID_PPV_ARGS(mPostProcessParameterBuffer.ReleaseAndGetAddressOf()));
-	if (FAILED(result) == true)
-	{
-		return result;
-	}
-
-	result = mPostProcessParameterBuffer->Map(0, nullptr, (void**)&mMappedPostProcessParameter);
-	if (FAILED(result) == true)
-	{
-		return result;
-	}
-
-	mMappedPostProcessParameter->iteration = 8;
-	mMappedPostProcessParameter->intensity = 1.0f;
-	mMappedPostProcessParameter->screenSpaceReflectionStepSize = 0.1f;
-
-	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	heapDesc.NodeMask = 0;
-	heapDesc.NumDescriptors = 1;
-	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-
-	result = mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mPostProcessParameterSRVHeap.ReleaseAndGetAddressOf()));
-	if (FAILED(result) == true)
-	{
-		return result;
-	}
-
-	auto handle = mPostProcessParameterSRVHeap->GetCPUDescriptorHandleForHeapStart();
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC bloomParamCbvDesc;
-	bloomParamCbvDesc.BufferLocation = mPostProcessParameterBuffer->GetGPUVirtualAddress();
-	bloomParamCbvDesc.SizeInBytes = mPostProcessParameterBuffer->GetDesc().Width;
-
-	mDevice->CreateConstantBufferView(&bloomParamCbvDesc, handle);
-
-	return result;
-}
-
-HRESULT Dx12Wrapper::CreateResolutionConstantBuffer()
-{
-	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-
-	unsigned int size = sizeof(ResolutionBuffer);
-	unsigned int alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
-	unsigned int width = size + alignment - (size % alignment);
-
-	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(width);
-
-	auto result = mDevice->CreateCommittedResource(
-		&heapProp,
-		D3D12_HEAP_FLAG_NONE,
-		&resourceDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mResolutionConstBuffer.ReleaseAndGetAddressOf()));
-	if (FAILED(result) == true)
-	{
-		return result;
-	}
+	mSceneMatrices.shadow = XMMatrixShadow(XMLoadFloat4(&planeVec), -XMLoadFloat3(&eye));
 
-	result = mResolutionConstBuffer->Map(0, nullptr, (void**)&mMappedResolutionBuffer);
-	if (FAILED(result) == true)
-	{
-		return result;
-	}
+	mPostProcessParameter.iteration = 8;
+	mPostProcessParameter.intensity = 1.0f;
+	mPostProcessParameter.screenSpaceReflectionStepSize = 0.1f;
 
 	const SIZE windowSize = Application::Instance().GetWindowSize();
-	mMappedResolutionBuffer->width = static_cast<float>(windowSize.cx);
-	mMappedResolutionBuffer->height = static_cast<float>(windowSize.cy);
+	mResolution.width = static_cast<float>(windowSize.cx);
+	mResolution.height = static_cast<float>(windowSize.cy);
 
-	mResolutionConstBuffer->Unmap(0, nullptr);
-
-	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	heapDesc.NodeMask = 0;
-	heapDesc.NumDescriptors = 1;
-	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-
-	result = mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mResolutionDescHeap.ReleaseAndGetAddressOf()));
-	if (FAILED(result) == true)
-	{
-		return result;
-	}
-
-	auto handle = mResolutionDescHeap->GetCPUDescriptorHandleForHeapStart();
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC constantBufferViewDesc;
-	constantBufferViewDesc.BufferLocation = mResolutionConstBuffer->GetGPUVirtualAddress();
-	constantBufferViewDesc.SizeInBytes = mResolutionConstBuffer->GetDesc().Width;
-
-	mDevice->CreateConstantBufferView(&constantBufferViewDesc, handle);
-
-	return result;
-}
-
-HRESULT Dx12Wrapper::CreateGlobalParameterBuffer()
-{
-	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-
-	unsigned int size = sizeof(GlobalParameterBuffer);
-	unsigned int alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
-	unsigned int width = size + alignment - (size % alignment);
-
-	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(width);
-
-	auto result = mDevice->CreateCommittedResource(
-		&heapProp,
-		D3D12_HEAP_FLAG_NONE,
-		&resourceDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mGlobalParameterBuffer.ReleaseAndGetAddressOf()));
+	// Constants, transforms and materials of every actor for one frame, a few hundred 256 byte slices
+	result = mUploadAllocator.Initialize(mDevice.Get(), 4 * 1024 * 1024, frames_in_flight);
+	assert(SUCCEEDED(result));
 
 	return result;
 }
@@ -1563,18 +1384,9 @@ HRESULT Dx12Wrapper::CreatePeraResource()
 	mDevice->CreateRenderTargetView(mSsrTexture.Get(), &rtvDesc, handle); //rtv offset 8
 	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
-	heapDesc.NumDescriptors = 9;
-	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	heapDesc.NodeMask = 0;
-
-	result = mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mPeraSRVHeap.ReleaseAndGetAddressOf()));
-	if (FAILED(result))
-	{
-		return result;
-	}
+	mPeraDescriptors = mDescriptorHeap.Allocate(9);
 
-	handle = mPeraSRVHeap->GetCPUDescriptorHandleForHeapStart();
+	handle = mDescriptorHeap.GetStagingHandle(mPeraDescriptors.index);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
@@ -1609,6 +1421,8 @@ HRESULT Dx12Wrapper::CreatePeraResource()
 	mDevice->CreateShaderResourceView(mSsrTexture.Get(), &srvDesc, handle); //offset 8
 	handle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+	mDescriptorHeap.Commit(mPeraDescriptors);
+
 	return result;
 }
 
@@ -1654,7 +1468,7 @@ bool Dx12Wrapper::CreatePeraVertex()
 
 bool Dx12Wrapper::CreatePeraPipeline()
 {
-	D3D12_DESCRIPTOR_RANGE range[4] = {};
+	D3D12_DESCRIPTOR_RANGE range[3] = {};
 
 	range[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
 	range[0].BaseShaderRegister = 0;
@@ -1668,10 +1482,6 @@ bool Dx12Wrapper::CreatePeraPipeline()
 	range[2].BaseShaderRegister = 7;
 	range[2].NumDescriptors = 1;
 
-	range[3].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	range[3].BaseShaderRegister = 0;
-	range[3].NumDescriptors = 1;
-
 	D3D12_ROOT_PARAMETER rp[4] = {};
 
 	rp[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
@@ -1689,10 +1499,11 @@ bool Dx12Wrapper::CreatePeraPipeline()
 	rp[2].DescriptorTable.pDescriptorRanges = &range[2];
 	rp[2].DescriptorTable.NumDescriptorRanges = 1;
 
-	rp[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	// SceneBuffer, uploaded each frame
+	rp[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 	rp[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-	rp[3].DescriptorTable.pDescriptorRanges = &range[3];
-	rp[3].DescriptorTable.NumDescriptorRanges = 1;
+	rp[3].Descriptor.ShaderRegister = 0;
+	rp[3].Descriptor.RegisterSpace = 0;
 
 	D3D12_ROOT_SIGNATURE_DESC rsDesc = {};
 	rsDesc.NumParameters = 4;
@@ -1900,25 +1711,21 @@ bool Dx12Wrapper::CreatePeraPipeline()
 	}
 
 
-	D3D12_DESCRIPTOR_RANGE blurResultRange[2] = {};
+	D3D12_DESCRIPTOR_RANGE blurResultRange[1] = {};
 	blurResultRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
 	blurResultRange[0].BaseShaderRegister = 0;
 	blurResultRange[0].NumDescriptors = 2;
 
-	blurResultRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	blurResultRange[1].BaseShaderRegister = 0;
-	blurResultRange[1].NumDescriptors = 1;
-
 	D3D12_ROOT_PARAMETER blurResultRootParameter[2] = {};
 	blurResultRootParameter[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 	blurResultRootParameter[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 	blurResultRootParameter[0].DescriptorTable.pDescriptorRanges = &blurResultRange[0];
 	blurResultRootParameter[0].DescriptorTable.NumDescriptorRanges = 1;
 
-	blurResultRootParameter[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	blurResultRootParameter[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 	blurResultRootParameter[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-	blurResultRootParameter[1].DescriptorTable.pDescriptorRanges = &blurResultRange[1];
-	blurResultRootParameter[1].DescriptorTable.NumDescriptorRanges = 1;
+	blurResultRootParameter[1].Descriptor.ShaderRegister = 0;
+	blurResultRootParameter[1].Descriptor.RegisterSpace = 0;
 
 	D3D12_ROOT_SIGNATURE_DESC blurResultRootSignatureDesc = {};
 	blurResultRootSignatureDesc.NumParameters = 2;
@@ -1988,13 +1795,6 @@ bool Dx12Wrapper::CreateSSRPipeline()
 	flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
 
-	//Scene Buffer
-	D3D12_DESCRIPTOR_RANGE sceneBufferDescriptorRange = {};
-	sceneBufferDescriptorRange.NumDescriptors = 1;
-	sceneBufferDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	sceneBufferDescriptorRange.BaseShaderRegister = 0;
-	sceneBufferDescriptorRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
 	//Color 
 	D3D12_DESCRIPTOR_RANGE colorTexDescriptorRange = {};
 	colorTexDescriptorRange.NumDescriptors = 1;
@@ -2030,30 +1830,17 @@ bool Dx12Wrapper::CreateSSRPipeline()
 	depthTexDescriptorRange.BaseShaderRegister = 4;
 	depthTexDescriptorRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 
-	//Post Process Parameter
-	D3D12_DESCRIPTOR_RANGE postProcessParameterDescriptorRange = {};
-	postProcessParameterDescriptorRange.NumDescriptors = 1;
-	postProcessParameterDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	postProcessParameterDescriptorRange.BaseShaderRegister = 1;
-	postProcessParameterDescriptorRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-	//Resolution Buffer
-	D3D12_DESCRIPTOR_RANGE resolutionBufferDescriptorRange = {};
-	resolutionBufferDescriptorRange.NumDescriptors = 1;
-	resolutionBufferDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	resolutionBufferDescriptorRange.BaseShaderRegister = 2;
-	resolutionBufferDescriptorRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
 	CD3DX12_ROOT_PARAMETER range[8] = {};
 
-	range[0].InitAsDescriptorTable(1, &sceneBufferDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
+	// Scene, post process and resolution constants are uploaded each frame
+	range[0].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
 	range[1].InitAsDescriptorTable(1, &colorTexDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
 	range[2].InitAsDescriptorTable(1, &normalTexDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
 	range[3].InitAsDescriptorTable(1, &ssrMaskTexDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
 	range[4].InitAsDescriptorTable(1, &planerReflectionTexDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
 	range[5].InitAsDescriptorTable(1, &depthTexDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
-	range[6].InitAsDescriptorTable(1, &postProcessParameterDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
-	range[7].InitAsDescriptorTable(1, &resolutionBufferDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
+	range[6].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	range[7].InitAsConstantBufferView(2, 0, D3D12_SHADER_VISIBILITY_PIXEL);
 
 	D3D12_ROOT_SIGNATURE_DESC rsDesc = {};
 	rsDesc.NumParameters = 8;
@@ -2177,7 +1964,7 @@ bool Dx12Wrapper::CreateAmbientOcclusionBuffer()
 	return true;
 }
 
-bool Dx12Wrapper::CreateAmbientOcclusionDescriptorHeap()
+bool Dx12Wrapper::CreateAmbientOcclusionView()
 {
 	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
 	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
@@ -2197,24 +1984,15 @@ bool Dx12Wrapper::CreateAmbientOcclusionDescriptorHeap()
 	rtvDesc.Format = DXGI_FORMAT_R32_FLOAT;
 	mDevice->CreateRenderTargetView(mAoBuffer.Get(), &rtvDesc, mAoRenderTargetViewDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
 
-	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	desc.NodeMask = 0;
-	desc.NumDescriptors = 1;
-	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	result = mDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(mAoSRVDescriptorHeap.ReleaseAndGetAddressOf()));
-
-	if (FAILED(result))
-	{
-		assert(0);
-		return false;
-	}
+	mAoDescriptor = mDescriptorHeap.Allocate(1);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 	srvDesc.Texture2D.MipLevels = 1;
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	mDevice->CreateShaderResourceView(mAoBuffer.Get(), &srvDesc, mAoSRVDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+	mDevice->CreateShaderResourceView(mAoBuffer.Get(), &srvDesc, mDescriptorHeap.GetStagingHandle(mAoDescriptor.index));
+	mDescriptorHeap.Commit(mAoDescriptor);
 
 	return true;
 }
@@ -2338,18 +2116,7 @@ HRESULT Dx12Wrapper::CreateDepthStencilView()
 
 	mDevice->CreateDepthStencilView(mStencilBuffer.Get(), &dsvDesc, handle);
 
-	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	heapDesc.NodeMask = 0;
-	heapDesc.NumDescriptors = 3;
-	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	result = mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&mDepthSRVHeap));
-
-	if (FAILED(result))
-	{
-		return result;
-	}
+	mDepthDescriptors = mDescriptorHeap.Allocate(3);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC depthSrvResDesc = {};
 	depthSrvResDesc.Format = DXGI_FORMAT_R32_FLOAT;
@@ -2357,7 +2124,7 @@ HRESULT Dx12Wrapper::CreateDepthStencilView()
 	depthSrvResDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 	depthSrvResDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 
-    auto srvHandle = mDepthSRVHeap->GetCPUDescriptorHandleForHeapStart();
+    auto srvHandle = mDescriptorHeap.GetStagingHandle(mDepthDescriptors.index);
 
 	mDevice->CreateShaderResourceView(mDepthBuffer.Get(), &depthSrvResDesc, srvHandle);
 
@@ -2367,6 +2134,8 @@ HRESULT Dx12Wrapper::CreateDepthStencilView()
 
 	srvHandle.ptr += mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+	mDescriptorHeap.Commit(mDepthDescriptors);
+
     return result;
 }
 
@@ -2584,31 +2353,57 @@ ID3D12Resource* Dx12Wrapper::CreateDefaultTexture(size_t width, size_t height)
 	return buff;
 }
 
-ComPtr<ID3D12DescriptorHeap> Dx12Wrapper::CreateDescriptorHeapForImgui()
+void Dx12Wrapper::WaitForFrameContext(UINT64 fenceValue)
 {
-	ComPtr<ID3D12DescriptorHeap> result;
-
-	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	desc.NodeMask = 0;
-	desc.NumDescriptors = 1;
-	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	mDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(result.ReleaseAndGetAddressOf()));
-
-	return result;
-}
+	if (mFence->GetCompletedValue() >= fenceValue)
+	{
+		return;
+	}
 
-void Dx12Wrapper::UpdateGlobalParameterBuffer() const
-{
-	GlobalParameterBuffer* mapped;
-	static std::random_device randomDevice;
-	static std::mt19937 generator(randomDevice());
-	static std::uniform_int_distribution<int> distribution(0, 99);
-	
-	mGlobalParameterBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mapped));
-	mapped->time = Time::GetTimeFloat();
-	mapped->randomSeed = distribution(generator);
-	mGlobalParameterBuffer->Unmap(0, nullptr);
+	mFence->SetEventOnCompletion(fenceValue, mFenceEvent);
+	WaitForSingleObject(mFenceEvent, INFINITE);
+}
+
+
+ID3D12GraphicsCommandList* Dx12Wrapper::RecordingCommandList() const
+{
+	return recordingCommandList != nullptr ? recordingCommandList : mCmdList.Get();
+}
+
+ID3D12Resource* Dx12Wrapper::GetFrameResource(FrameResource resource) const
+{
+	switch (resource)
+	{
+	case FrameResource::BackBuffer:
+		return mBackBuffers[mSwapChain->GetCurrentBackBufferIndex()];
+	case FrameResource::Color:
+		return mPera1Resource[0].Get();
+	case FrameResource::Normal:
+		return mPera1Resource[1].Get();
+	case FrameResource::HighLuminance:
+		return mBloomBuffer[0].Get();
+	case FrameResource::ShrinkHighLuminance:
+		return mBloomBuffer[1].Get();
+	case FrameResource::Shrink:
+		return mDofBuffer.Get();
+	case FrameResource::BloomResult:
+		return mBloomResultTexture.Get();
+	case FrameResource::Reflection:
+		return mReflectionBuffer.Get();
+	case FrameResource::SsrMask:
+		return mSsrMaskBuffer.Get();
+	case FrameResource::Ssr:
+		return mSsrTexture.Get();
+	case FrameResource::AmbientOcclusion:
+		return mAoBuffer.Get();
+	case FrameResource::Depth:
+		return mDepthBuffer.Get();
+	case FrameResource::LightDepth:
+		return mLightDepthBuffer.Get();
+	case FrameResource::Stencil:
+		return mStencilBuffer.Get();
+	default:
+		assert(0);
+		return nullptr;
+	}
 }
-
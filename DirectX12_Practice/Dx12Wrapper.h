@@ -9,9 +9,38 @@
 #include<string>
 #include<functional>
 #include<array>
+#include<vector>
+
+#include "CommandBackend.h"
+#include "Define.h"
+#include "DescriptorHeap.h"
+#include "UploadAllocator.h"
 
 class Transform;
-class Dx12Wrapper
+class RenderGraph;
+struct RenderGraphBarrier;
+
+// Resources the passes hand to each other, the values are their indices in the render graph
+enum class FrameResource : unsigned int
+{
+	BackBuffer,
+	Color,
+	Normal,
+	HighLuminance,
+	ShrinkHighLuminance,
+	Shrink,
+	BloomResult,
+	Reflection,
+	SsrMask,
+	Ssr,
+	AmbientOcclusion,
+	Depth,
+	LightDepth,
+	Stencil,
+	Count,
+};
+
+class Dx12Wrapper : public ICommandBackend
 {
 	template<typename T>
 	using ComPtr = Microsoft::WRL::ComPtr<T>;
@@ -27,9 +56,9 @@ public:
 	void PreDrawToPera1() const;
 	void DrawToPera1();
 	void DrawToPera1ForFbx();
-	void PostDrawToPera1();
 	void DrawAmbientOcclusion();
 	void DrawShrinkTextureForBlur();
+	void DrawBloomResult();
 	void DrawScreenSpaceReflection();
 	void Clear();
 	void Draw();
@@ -37,6 +66,40 @@ public:
 	void BeginDraw();
 	void EndDraw();
 
+	// One allocator and command list per pass, CommandList() returns the list of the pass the calling thread records
+	void BeginFrame(unsigned int passCount) override;
+	void BeginPass(unsigned int pass) override;
+	void EndPass(unsigned int pass) override;
+	void Submit() override;
+
+	// Blocks until every submitted frame has finished on the GPU
+	void WaitForGpu();
+	// Frames presented so far
+	UINT64 GetFrameIndex() const;
+	// Milliseconds the last EndDraw waited for the oldest frame in flight
+	float GetFrameWaitTime() const;
+	// Keeps a resource alive until the GPU is done with the frame being recorded
+	void ReleaseAfterFrame(ComPtr<ID3D12Resource> resource);
+
+	// Upload memory of the frame being recorded, bound as root constant buffer views.
+	// A null cpuAddress or a zero address means the upload failed and the draw has to be skipped
+	UploadAllocation AllocateUpload(size_t size);
+	D3D12_GPU_VIRTUAL_ADDRESS UploadConstantBuffer(const void* data, size_t size);
+	// Upload memory the last submitted frame used, out of what a frame context has, more than the region size once it spilled
+	size_t GetUploadUsedSize() const;
+	size_t GetUploadRegionSize() const;
+
+	// Ranges of the one shader visible heap every command list has bound, views go to the staging side and are committed
+	DescriptorRange AllocateDescriptors(unsigned int count);
+	// Freed once the GPU is done with the frame being recorded
+	void FreeDescriptorsAfterFrame(const DescriptorRange& range);
+	const DescriptorHeap& GetDescriptorHeap() const;
+
+	// Adds every FrameResource to an empty graph, in the state it is created in and left in between frames
+	void AddFrameResources(RenderGraph& graph) const;
+	// Records a barrier batch of the render graph with one ResourceBarrier call
+	void ResourceBarrier(const std::vector<RenderGraphBarrier>& barriers) const;
+
 	void SetRenderTargetByMainFrameBuffer() const;
 	void SetRenderTargetSSRMaskBuffer() const;
 	void SetShaderResourceSSRMaskBuffer(unsigned int rootParameterIndex) const;
@@ -46,22 +109,17 @@ public:
 
 	void SetLightDepthTexture(int rootParameterIndex) const;
 
-	void SetResolutionDescriptorHeap(unsigned int rootParameterIndex) const;
+	void SetResolutionBuffer(unsigned int rootParameterIndex) const;
 	void SetGlobalParameterBuffer(unsigned int rootParameterIndex) const;
 	void SetPostProcessParameterBuffer(unsigned int rootParameterIndex) const;
 
-	void ChangeResourceBarrierFinalRenderTarget(D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) const;
 	void SetFinalRenderTarget() const;
 	void SetOnlyDepthBuffer() const;
 	void ClearFinalRenderTarget() const;
 
-	void ChangeToDepthWriteMainDepthBuffer() const;
-	void ChangeToShaderResourceMainDepthBuffer() const;
-
 	ComPtr<ID3D12Device> Device();
 	ComPtr<ID3D12GraphicsCommandList> CommandList();
 	ComPtr<IDXGISwapChain4> SwapChain();
-	ComPtr<ID3D12DescriptorHeap> GetHeapForImgui();
 
 	ComPtr<ID3D12Resource> GetTextureByPath(const char* texpath);
 	ComPtr<ID3D12Resource> GetTextureByPath(const std::wstring& texpath);
@@ -110,16 +168,13 @@ private:
 	HRESULT InitializeCommand();
 	HRESULT CreateSwapChain(const HWND& hwnd);
 	HRESULT CreateFinalRenderTargets();
-	HRESULT CreateSceneView();
-	HRESULT CreateBloomParameterResource();
-	HRESULT CreateResolutionConstantBuffer();
-	HRESULT CreateGlobalParameterBuffer();
+	HRESULT CreateFrameConstants();
 	HRESULT CreatePeraResource();
 	bool CreatePeraVertex();
 	bool CreatePeraPipeline();
 	bool CreateSSRPipeline();
 	bool CreateAmbientOcclusionBuffer();
-	bool CreateAmbientOcclusionDescriptorHeap();
+	bool CreateAmbientOcclusionView();
 	void CreateTextureLoaderTable();
 	HRESULT CreateDepthStencilView();
 	ID3D12Resource* CreateWhiteTexture();
@@ -129,17 +184,24 @@ private:
 	ID3D12Resource* CreateTextureFromFile(const char* texpath);
 	ID3D12Resource* CreateTextureFromFile(const std::wstring& texpath);
 	ID3D12Resource* CreateDefaultTexture(size_t width, size_t height);
-	ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeapForImgui();
 
-	void UpdateGlobalParameterBuffer() const; 
+	void WaitForFrameContext(UINT64 fenceValue);
+	ID3D12GraphicsCommandList* RecordingCommandList() const;
+	// The back buffer is the one of the frame being recorded
+	ID3D12Resource* GetFrameResource(FrameResource resource) const;
 
 	SIZE mWindowSize;
 
 	ComPtr<IDXGIFactory6> mDXGIFactory = nullptr;
 	ComPtr<ID3D12Device> mDevice = nullptr;
-	ComPtr<ID3D12CommandAllocator> mCmdAllocator = nullptr;
 	ComPtr<ID3D12GraphicsCommandList> mCmdList = nullptr;
 	ComPtr<ID3D12CommandQueue> mCmdQueue = nullptr;
+
+	// mCmdList keeps what is recorded outside the passes, like uploads, and is submitted ahead of them
+	std::vector<ComPtr<ID3D12GraphicsCommandList>> mPassCmdLists;
+	std::vector<ID3D12GraphicsCommandList*> mPreviousRecordingCmdLists;
+	std::vector<ID3D12CommandList*> mSubmitCmdLists;
+	unsigned int mPassCount = 0;
 	ComPtr<IDXGISwapChain4> mSwapChain = nullptr;
 	ComPtr<ID3D12DescriptorHeap> mRtvHeaps = nullptr;
 	std::vector<ID3D12Resource*> mBackBuffers;
@@ -147,7 +209,7 @@ private:
 	std::unique_ptr<D3D12_RECT> mScissorRect;
 
 	ComPtr<ID3D12DescriptorHeap> mPeraRTVHeap = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mPeraSRVHeap = nullptr;
+	DescriptorRange mPeraDescriptors;
 	ComPtr<ID3D12Resource> mPeraVB;
 	D3D12_VERTEX_BUFFER_VIEW mPeraVertexBufferView;
 	ComPtr<ID3D12RootSignature> mPeraRootSignature;
@@ -157,18 +219,8 @@ private:
 	ComPtr<ID3D12PipelineState> mSsrPipeline = nullptr;
 	ComPtr<ID3D12Resource> mSsrTexture = nullptr;
 
-	// SceneBuffer(view, proj, shadow, camera ...)
-	ComPtr<ID3D12Resource> mSceneConstBuff = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mSceneDescHeap = nullptr;
-
-	ComPtr<ID3D12Resource> mGlobalParameterBuffer = nullptr;
-
-	ComPtr<ID3D12Resource> mResolutionConstBuffer = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mResolutionDescHeap = nullptr;
-	ResolutionBuffer* mMappedResolutionBuffer = nullptr;
-
 	ComPtr<ID3D12DescriptorHeap> mDepthStencilViewHeap = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mDepthSRVHeap = nullptr;
+	DescriptorRange mDepthDescriptors;
 	ComPtr<ID3D12Resource> mDepthBuffer = nullptr;
 	ComPtr<ID3D12Resource> mLightDepthBuffer = nullptr;
 	ComPtr<ID3D12Resource> mStencilBuffer = nullptr;
@@ -181,14 +233,12 @@ private:
 	ComPtr<ID3D12PipelineState> mAoPipeline;
 	ComPtr<ID3D12Resource> mAoBuffer; // texSSAO
 	ComPtr<ID3D12DescriptorHeap> mAoRenderTargetViewDescriptorHeap;
-	ComPtr<ID3D12DescriptorHeap> mAoSRVDescriptorHeap;
+	DescriptorRange mAoDescriptor;
 
 	ComPtr<ID3D12PipelineState> mBlurShrinkPipeline;
 	ComPtr<ID3D12Resource> mDofBuffer; // texShrink
 	ComPtr<ID3D12Resource> mBloomResultTexture; //offset 8
-	ComPtr<ID3D12Resource> mPostProcessParameterBuffer;
-	BloomParameter* mMappedPostProcessParameter = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mPostProcessParameterSRVHeap;
+	BloomParameter mPostProcessParameter;
 	ComPtr<ID3D12RootSignature> mBlurResultRootSignature;
 	ComPtr<ID3D12PipelineState> mBlurResultPipeline;
 	int mBloomIteration = 0;
@@ -216,8 +266,39 @@ private:
 		DirectX::XMFLOAT3 eye;
 	};
 
+	SceneMatricesData mSceneMatrices;
+	ResolutionBuffer mResolution;
+
+	// Uploaded by Update for the frame being recorded
+	D3D12_GPU_VIRTUAL_ADDRESS mSceneBufferAddress = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS mResolutionBufferAddress = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS mGlobalParameterBufferAddress = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS mPostProcessParameterBufferAddress = 0;
+
+	// What the CPU needs to keep until the GPU finished one frame, the CPU runs up to frames_in_flight frames ahead
+	struct FrameContext
+	{
+		ComPtr<ID3D12CommandAllocator> cmdAllocator = nullptr;
+		std::vector<ComPtr<ID3D12CommandAllocator>> passCmdAllocators;
+		std::vector<ComPtr<ID3D12Resource>> releaseResources;
+		std::vector<DescriptorRange> releaseDescriptors;
+		UINT64 fenceValue = 0;
+	};
+
+	std::array<FrameContext, frames_in_flight> mFrameContexts;
+	unsigned int mFrameContextIndex = 0;
+	UINT64 mFrameIndex = 0;
+	float mFrameWaitTime = 0.0f;
+
+	// A region per frame context, reset once the fence of the context passed
+	UploadAllocator mUploadAllocator;
+	size_t mUploadUsedSize = 0;
+
+	DescriptorHeap mDescriptorHeap;
+
 	ComPtr<ID3D12Fence> mFence = nullptr;
 	UINT64 mFenceVal = 0;
+	HANDLE mFenceEvent = nullptr;
 
 	using LoadLambda_t = std::function<HRESULT(const std::wstring& path, DirectX::TexMetadata*, DirectX::ScratchImage&)>;
 	std::map<std::string, LoadLambda_t> mLoadLambdaTable;
@@ -229,8 +310,6 @@ private:
 	ComPtr<ID3D12Resource> mBlackTex = nullptr;
 	ComPtr<ID3D12Resource> mGradTex = nullptr;
 
-	ComPtr<ID3D12DescriptorHeap> mHeapForImgui;
-
 	int mCurrentPPFlag;
 };
 
@@ -44,12 +44,6 @@ bool FBXActor::Initialize(const std::string& path, Dx12Wrapper& dx)
 		return false;
 	}
 
-	hResult = CreateTransformView(dx);
-	if (FAILED(hResult))
-	{
-		return false;
-	}
-
 	std::vector<DirectX::XMFLOAT3> vertexPositionList;
 	vertexPositionList.reserve(mVertices.size());
 
@@ -78,15 +72,16 @@ void FBXActor::SetMaterialName(const std::vector<std::string> materialNameList)
 
 void FBXActor::Draw(Dx12Wrapper& dx, bool isShadow) const
 {
+	if (mTransformAddress == 0)
+	{
+		return;
+	}
+
 	dx.CommandList()->IASetVertexBuffers(0, 1, &mVertexBufferView);
 	dx.CommandList()->IASetIndexBuffer(&mIndexBufferView);
 	dx.CommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	ID3D12DescriptorHeap* transformHeap[] = { mTransformHeap.Get() };
-	dx.CommandList()->SetDescriptorHeaps(1, transformHeap);
-	dx.CommandList()->SetGraphicsRootDescriptorTable(1, mTransformHeap->GetGPUDescriptorHandleForHeapStart());
-
-	MaterialManager::Instance().SetMaterialDescriptorHeaps(dx);
+	dx.CommandList()->SetGraphicsRootConstantBufferView(1, mTransformAddress);
 
 	unsigned int indexOffset = 0;
 
@@ -104,9 +99,10 @@ void FBXActor::Draw(Dx12Wrapper& dx, bool isShadow) const
 	//dx.CommandList()->DrawIndexedInstanced(mIndexCount, 1, indexOffset, 0, 0);
 }
 
-void FBXActor::Update()
+void FBXActor::Update(Dx12Wrapper& dx)
 {
-	mMappedWorldTransform[0] = mTransform.GetTransformMatrix();
+	DirectX::XMMATRIX world = mTransform.GetTransformMatrix();
+	mTransformAddress = dx.UploadConstantBuffer(&world, sizeof(DirectX::XMMATRIX));
 }
 
 Transform& FBXActor::GetTransform()
@@ -357,60 +353,3 @@ HRESULT FBXActor::CreateVertexBufferAndIndexBuffer(Dx12Wrapper& dx)
 
 	return S_OK;
 }
-
-HRESULT FBXActor::CreateTransformView(Dx12Wrapper& dx)
-{
-	auto buffSize = sizeof(DirectX::XMMATRIX);
-	buffSize = (buffSize + 0xff) & ~0xff;
-
-	auto result = dx.Device()->CreateCommittedResource
-	(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(buffSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mTransformBuffer.ReleaseAndGetAddressOf())
-	);
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	result = mTransformBuffer->Map(0, nullptr, (void**)&mMappedWorldTransform);
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	mMappedWorldTransform[0] = DirectX::XMMatrixIdentity() * DirectX::XMMatrixScaling(100.0f, 100.0f, 100.0f);
-
-	D3D12_DESCRIPTOR_HEAP_DESC transformDescHeapDesc = {};
-	transformDescHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	transformDescHeapDesc.NodeMask = 0;
-	transformDescHeapDesc.NumDescriptors = 1;
-	transformDescHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	result = dx.Device()->CreateDescriptorHeap(
-		&transformDescHeapDesc,
-		IID_PPV_ARGS(mTransformHeap.ReleaseAndGetAddressOf()));
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-	cbvDesc.BufferLocation = mTransformBuffer->GetGPUVirtualAddress();
-	cbvDesc.SizeInBytes = buffSize;
-
-	dx.Device()->CreateConstantBufferView(&cbvDesc, mTransformHeap->GetCPUDescriptorHandleForHeapStart());
-
-	return S_OK;
-}
- 
\ No newline at end of file
@@ -44,7 +44,7 @@ public:
 	bool Initialize(const std::string& path, Dx12Wrapper& dx);
 	void SetMaterialName(const std::vector<std::string> materialNameList);
 	void Draw(Dx12Wrapper& dx, bool isShadow) const;
-	void Update();
+	void Update(Dx12Wrapper& dx);
 
 	Transform& GetTransform() override;
 	TypeIdentity GetType() override;
@@ -64,7 +64,6 @@ private:
 	void ReadMesh(aiMesh* mesh, const aiScene* scene);
 
 	HRESULT CreateVertexBufferAndIndexBuffer(Dx12Wrapper& dx);
-	HRESULT CreateTransformView(Dx12Wrapper& dx);
 
 private:
 	template<typename T>
@@ -86,9 +85,7 @@ private:
 	FBXVertex* mMappedVertex;
 	unsigned int* mMappedIndex;
 
-	ComPtr<ID3D12Resource> mTransformBuffer = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mTransformHeap = nullptr;
-	DirectX::XMMATRIX* mMappedWorldTransform;
+	D3D12_GPU_VIRTUAL_ADDRESS mTransformAddress = 0;
 	Transform mTransform;
 	std::string mName;
 
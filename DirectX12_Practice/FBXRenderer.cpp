@@ -29,7 +29,7 @@ void FBXRenderer::Update()
 {
 	for (auto& actor : mActors)
 	{
-		actor->Update();
+		actor->Update(mDx);
 	}
 }
 
@@ -49,7 +49,7 @@ void FBXRenderer::BeforeDrawAtForwardPipeline()
 
 void FBXRenderer::Draw()
 {
-	mDx.SetResolutionDescriptorHeap(5);
+	mDx.SetResolutionBuffer(5);
 
 	for (auto& actor : mActors)
 	{
@@ -79,52 +79,35 @@ std::vector<std::shared_ptr<FBXActor>>& FBXRenderer::GetActor()
 
 HRESULT FBXRenderer::CreateRootSignature()
 {
-	D3D12_DESCRIPTOR_RANGE descriptorRange[6] = {};
+	D3D12_DESCRIPTOR_RANGE descriptorRange[3] = {};
 
-	//Scene Buffer
+	//Material Buffer
 	descriptorRange[0].NumDescriptors = 1;
 	descriptorRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	descriptorRange[0].BaseShaderRegister = 0;
+	descriptorRange[0].BaseShaderRegister = 2;
 	descriptorRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 
-	//World Transform Buffer
+	//Shadow Depth Texture
 	descriptorRange[1].NumDescriptors = 1;
-	descriptorRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	descriptorRange[1].BaseShaderRegister = 1;
+	descriptorRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	descriptorRange[1].BaseShaderRegister = 0;
 	descriptorRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 
-	//Material Buffer
+	//Reflection Render Texture
 	descriptorRange[2].NumDescriptors = 1;
-	descriptorRange[2].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	descriptorRange[2].BaseShaderRegister = 2;
+	descriptorRange[2].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	descriptorRange[2].BaseShaderRegister = 1;
 	descriptorRange[2].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 
-	//Shadow Depth Texture
-	descriptorRange[3].NumDescriptors = 1;
-	descriptorRange[3].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-	descriptorRange[3].BaseShaderRegister = 0;
-	descriptorRange[3].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-	//Reflection Render Texture
-	descriptorRange[4].NumDescriptors = 1;
-	descriptorRange[4].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-	descriptorRange[4].BaseShaderRegister = 1;
-	descriptorRange[4].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-	//Resolution Buffer
-	descriptorRange[5].NumDescriptors = 1;
-	descriptorRange[5].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	descriptorRange[5].BaseShaderRegister = 3;
-	descriptorRange[5].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
 	CD3DX12_ROOT_PARAMETER rootParam[6] = {};
 
-	rootParam[0].InitAsDescriptorTable(1, &descriptorRange[0], D3D12_SHADER_VISIBILITY_ALL);
-	rootParam[1].InitAsDescriptorTable(1, &descriptorRange[1], D3D12_SHADER_VISIBILITY_ALL);
-	rootParam[2].InitAsDescriptorTable(1, &descriptorRange[2], D3D12_SHADER_VISIBILITY_ALL);
-	rootParam[3].InitAsDescriptorTable(1, &descriptorRange[3], D3D12_SHADER_VISIBILITY_ALL);
-	rootParam[4].InitAsDescriptorTable(1, &descriptorRange[4], D3D12_SHADER_VISIBILITY_ALL);
-	rootParam[5].InitAsDescriptorTable(1, &descriptorRange[5], D3D12_SHADER_VISIBILITY_ALL);
+	// Scene, world transform and resolution are uploaded each frame, bound without a descriptor heap
+	rootParam[0].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_ALL);
+	rootParam[1].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_ALL);
+	rootParam[2].InitAsDescriptorTable(1, &descriptorRange[0], D3D12_SHADER_VISIBILITY_ALL);
+	rootParam[3].InitAsDescriptorTable(1, &descriptorRange[1], D3D12_SHADER_VISIBILITY_ALL);
+	rootParam[4].InitAsDescriptorTable(1, &descriptorRange[2], D3D12_SHADER_VISIBILITY_ALL);
+	rootParam[5].InitAsConstantBufferView(3, 0, D3D12_SHADER_VISIBILITY_ALL);
 
 	CD3DX12_STATIC_SAMPLER_DESC samplerDesc[2] = {};
 	samplerDesc[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
@@ -0,0 +1,202 @@
+#include "FrameTaskGraph.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
+void FrameTaskGraph::Clear()
+{
+	assert(mIsRunning == false);
+
+	mTasks.clear();
+	mCriticalPath.clear();
+	mFrameTime = 0.0f;
+	mTotalTaskTime = 0.0f;
+	mCriticalPathTime = 0.0f;
+}
+
+unsigned int FrameTaskGraph::AddTask(const std::string& name, std::function<void()> function)
+{
+	std::unique_ptr<FrameTask> task = std::make_unique<FrameTask>();
+	task->name = name;
+	task->function = std::move(function);
+	task->graph = this;
+
+	mTasks.push_back(std::move(task));
+	return static_cast<unsigned int>(mTasks.size() - 1);
+}
+
+void FrameTaskGraph::AddDependency(unsigned int before, unsigned int after)
+{
+	// Insertion order is then a topological order, the critical path walks it once
+	assert(before < after && after < mTasks.size());
+
+	mTasks[before]->successors.push_back(after);
+	mTasks[after]->dependencyCount++;
+}
+
+void FrameTaskGraph::Run()
+{
+	Start();
+	Wait();
+}
+
+void FrameTaskGraph::Start()
+{
+	if (mTasks.empty() == true || mIsRunning == true)
+	{
+		return;
+	}
+
+	mIsRunning = true;
+	mRunCounter.remaining = static_cast<unsigned int>(mTasks.size());
+	mRunStartTime = std::chrono::steady_clock::now();
+
+	for (std::unique_ptr<FrameTask>& task : mTasks)
+	{
+		task->remainingDependencyCount = task->dependencyCount;
+	}
+
+	for (std::unique_ptr<FrameTask>& task : mTasks)
+	{
+		if (task->dependencyCount == 0)
+		{
+			PushTask(*task);
+		}
+	}
+}
+
+void FrameTaskGraph::Wait()
+{
+	if (mIsRunning == false)
+	{
+		return;
+	}
+
+	JobSystem::Instance().Wait(mRunCounter);
+	mIsRunning = false;
+
+	// Measured up to the last task, not to the Wait call, since the caller may join late
+	mFrameTime = 0.0f;
+	for (std::unique_ptr<FrameTask>& task : mTasks)
+	{
+		mFrameTime = (std::max)(mFrameTime, task->endTime);
+	}
+
+	UpdateCriticalPath();
+}
+
+bool FrameTaskGraph::IsRunning() const
+{
+	return mIsRunning;
+}
+
+bool FrameTaskGraph::IsEmpty() const
+{
+	return mTasks.empty();
+}
+
+unsigned int FrameTaskGraph::GetTaskCount() const
+{
+	return static_cast<unsigned int>(mTasks.size());
+}
+
+const std::string& FrameTaskGraph::GetTaskName(unsigned int task) const
+{
+	return mTasks[task]->name;
+}
+
+float FrameTaskGraph::GetTaskTime(unsigned int task) const
+{
+	return mTasks[task]->endTime - mTasks[task]->startTime;
+}
+
+float FrameTaskGraph::GetFrameTime() const
+{
+	return mFrameTime;
+}
+
+float FrameTaskGraph::GetTotalTaskTime() const
+{
+	return mTotalTaskTime;
+}
+
+float FrameTaskGraph::GetCriticalPathTime() const
+{
+	return mCriticalPathTime;
+}
+
+const std::vector<unsigned int>& FrameTaskGraph::GetCriticalPath() const
+{
+	return mCriticalPath;
+}
+
+void FrameTaskGraph::RunTask(const void* data, unsigned int begin, unsigned int end)
+{
+	FrameTask& task = *static_cast<FrameTask*>(const_cast<void*>(data));
+	FrameTaskGraph& graph = *task.graph;
+
+	task.startTime = graph.GetElapsedTime();
+	task.function();
+	task.endTime = graph.GetElapsedTime();
+
+	for (unsigned int successor : task.successors)
+	{
+		FrameTask& successorTask = *graph.mTasks[successor];
+		if (successorTask.remainingDependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			graph.PushTask(successorTask);
+		}
+	}
+}
+
+void FrameTaskGraph::PushTask(FrameTask& task)
+{
+	// The run counter already counts every task, so pushing does not add to it
+	JobSystem::Instance().Push(Job{ &FrameTaskGraph::RunTask, &task, 0, 1, 1, &mRunCounter });
+}
+
+float FrameTaskGraph::GetElapsedTime() const
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mRunStartTime).count();
+}
+
+void FrameTaskGraph::UpdateCriticalPath()
+{
+	// Longest chain of measured task times, ignoring the time a ready task waited for a thread
+	std::vector<float> chainTimes(mTasks.size(), 0.0f);
+	std::vector<unsigned int> previousTasks(mTasks.size(), UINT_MAX);
+
+	mTotalTaskTime = 0.0f;
+	mCriticalPathTime = 0.0f;
+	unsigned int lastTask = 0;
+
+	for (unsigned int i = 0; i < mTasks.size(); i++)
+	{
+		float taskTime = GetTaskTime(i);
+		float chainTime = chainTimes[i] + taskTime;
+		mTotalTaskTime += taskTime;
+
+		if (chainTime > mCriticalPathTime)
+		{
+			mCriticalPathTime = chainTime;
+			lastTask = i;
+		}
+
+		for (unsigned int successor : mTasks[i]->successors)
+		{
+			if (chainTime > chainTimes[successor])
+			{
+				chainTimes[successor] = chainTime;
+				previousTasks[successor] = i;
+			}
+		}
+	}
+
+	mCriticalPath.clear();
+	for (unsigned int task = lastTask; task != UINT_MAX; task = previousTasks[task])
+	{
+		mCriticalPath.push_back(task);
+	}
+
+	std::reverse(mCriticalPath.begin(), mCriticalPath.end());
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Per frame stages as nodes with explicit dependencies, built once and run every frame on the JobSystem
+class FrameTaskGraph
+{
+public:
+	void Clear();
+	unsigned int AddTask(const std::string& name, std::function<void()> function);
+	// Tasks must be added before the tasks that depend on them
+	void AddDependency(unsigned int before, unsigned int after);
+
+	// Returns when every task has run once
+	void Run();
+	// Run split in two so the calling thread can do other work while the tasks run on the workers
+	void Start();
+	void Wait();
+	bool IsRunning() const;
+
+	bool IsEmpty() const;
+	unsigned int GetTaskCount() const;
+	const std::string& GetTaskName(unsigned int task) const;
+	// Milliseconds of the last Run
+	float GetTaskTime(unsigned int task) const;
+	float GetFrameTime() const;
+	float GetTotalTaskTime() const;
+	float GetCriticalPathTime() const;
+	const std::vector<unsigned int>& GetCriticalPath() const;
+
+private:
+	struct FrameTask
+	{
+		std::string name;
+		std::function<void()> function;
+		std::vector<unsigned int> successors;
+		unsigned int dependencyCount = 0;
+		std::atomic<unsigned int> remainingDependencyCount{ 0 };
+		FrameTaskGraph* graph = nullptr;
+		float startTime = 0.0f;
+		float endTime = 0.0f;
+	};
+
+	static void RunTask(const void* data, unsigned int begin, unsigned int end);
+	void PushTask(FrameTask& task);
+	float GetElapsedTime() const;
+	void UpdateCriticalPath();
+
+	std::vector<std::unique_ptr<FrameTask>> mTasks;
+	JobCounter mRunCounter;
+	bool mIsRunning = false;
+	std::chrono::steady_clock::time_point mRunStartTime;
+
+	float mFrameTime = 0.0f;
+	float mTotalTaskTime = 0.0f;
+	float mCriticalPathTime = 0.0f;
+	std::vector<unsigned int> mCriticalPath;
+};
@@ -17,18 +17,20 @@ void GeometryActor::Initialize(Dx12Wrapper& dx)
 {
 	HRESULT result = CreateVertexBufferAndIndexBuffer(dx);
 	assert(SUCCEEDED(result));
-
-	result = CreateTransformBuffer(dx);
-	assert(SUCCEEDED(result));
 }
 
 void GeometryActor::Draw(Dx12Wrapper& dx) const
 {
+	if (mTransformAddress == 0)
+	{
+		return;
+	}
+
 	dx.SetSceneBuffer(0);
 	dx.SetRSSetViewportsAndScissorRectsByScreenSize();
 
 	auto cmdList = dx.CommandList();
-	cmdList->SetGraphicsRootConstantBufferView(1, mTransformBuffer->GetGPUVirtualAddress());
+	cmdList->SetGraphicsRootConstantBufferView(1, mTransformAddress);
 
 	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	cmdList->IASetVertexBuffers(0, 1, &mVertexBufferView);
@@ -36,12 +38,10 @@ void GeometryActor::Draw(Dx12Wrapper& dx) const
 	cmdList->DrawIndexedInstanced(mIndices.size(), 1, 0, 0, 0);
 }
 
-void GeometryActor::Update()
+void GeometryActor::Update(Dx12Wrapper& dx)
 {
-	DirectX::XMMATRIX* mappedTransform;
-	mTransformBuffer->Map(0, nullptr, (void**)&mappedTransform);
-	mappedTransform[0] = mTransform->GetTransformMatrix();
-	mTransformBuffer->Unmap(0, nullptr);
+	DirectX::XMMATRIX world = mTransform->GetTransformMatrix();
+	mTransformAddress = dx.UploadConstantBuffer(&world, sizeof(DirectX::XMMATRIX));
 }
 
 void GeometryActor::EndOfFrame(Dx12Wrapper& dx)
@@ -148,42 +148,3 @@ HRESULT GeometryActor::CreateVertexBufferAndIndexBuffer(Dx12Wrapper& dx)
 
 	return S_OK;
 }
-
-HRESULT GeometryActor::CreateTransformBuffer(Dx12Wrapper& dx)
-{
-	auto buffSize = sizeof(DirectX::XMMATRIX);
-	buffSize = (buffSize + 0xff) & ~0xff;
-
-	auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(buffSize);
-
-	auto result = dx.Device()->CreateCommittedResource(
-		&heapProperties,
-		D3D12_HEAP_FLAG_NONE,
-		&bufferDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mTransformBuffer.ReleaseAndGetAddressOf())
-	);
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	DirectX::XMMATRIX* mappedTransform;
-	result = mTransformBuffer->Map(0, nullptr, (void**)&mappedTransform);
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	mappedTransform[0] = mTransform->GetTransformMatrix();
-
-	mTransformBuffer->Unmap(0, nullptr);
-
-	return S_OK;
-}
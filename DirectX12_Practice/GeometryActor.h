@@ -16,7 +16,7 @@ public:
 
     void Initialize(Dx12Wrapper& dx);
     void Draw(Dx12Wrapper& dx) const;
-    void Update();
+    void Update(Dx12Wrapper& dx);
     void EndOfFrame(Dx12Wrapper& dx);
 
     // override
@@ -27,7 +27,6 @@ public:
 
 private:
     HRESULT CreateVertexBufferAndIndexBuffer(Dx12Wrapper& dx);
-    HRESULT CreateTransformBuffer(Dx12Wrapper& dx);
 
 private:
     template<typename T>
@@ -42,7 +41,7 @@ private:
     Vertex* mMappedVertex = nullptr;
     unsigned int* mMappedIndex = nullptr;
 
-    ComPtr<ID3D12Resource> mTransformBuffer = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS mTransformAddress = 0;
     std::unique_ptr<Transform> mTransform{};
 
     std::string mName;
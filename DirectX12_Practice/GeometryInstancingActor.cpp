@@ -317,6 +317,10 @@ void GeometryInstancingActor::ChangeInstanceCount(Dx12Wrapper& dx)
 {
 	InitializeInstanceData(mInstanceCount);
 
+	// Frames still in flight draw with the old buffers
+	dx.ReleaseAfterFrame(mInstanceBuffer);
+	dx.ReleaseAfterFrame(mInstanceUploadBuffer);
+
 	mInstanceBuffer = nullptr;
 	mInstanceUploadBuffer = nullptr;
 
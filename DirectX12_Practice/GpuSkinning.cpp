@@ -0,0 +1,79 @@
+#include "GpuSkinning.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace GpuSkinning
+{
+	void PackVertex(const float* position, const float* normal, const float* uv, unsigned int influenceCount, const int* boneIndices, const float* boneWeights, GpuSkinningVertex& vertex)
+	{
+		std::memcpy(vertex.position, position, sizeof(vertex.position));
+		std::memcpy(vertex.normal, normal, sizeof(vertex.normal));
+		std::memcpy(vertex.uv, uv, sizeof(vertex.uv));
+
+		for (unsigned int k = 0; k < 4; k++)
+		{
+			vertex.boneIndices[k] = 0;
+			vertex.boneWeights[k] = 0;
+
+			if (k >= influenceCount || boneIndices[k] < 0)
+			{
+				continue;
+			}
+
+			float weight = influenceCount == 1 ? 1.0f : boneWeights[k];
+			vertex.boneIndices[k] = static_cast<unsigned short>(boneIndices[k]);
+			vertex.boneWeights[k] = static_cast<unsigned short>(std::nearbyint((std::min)((std::max)(weight, 0.0f), 1.0f) * 65535.0f));
+		}
+	}
+
+	void PackPalette(const float* skinningPalette, unsigned int boneCount, float* destination)
+	{
+		for (unsigned int bone = 0; bone < boneCount; bone++)
+		{
+			const float* m = skinningPalette + bone * skinningPaletteStride;
+			float* rows = destination + bone * gpuSkinningPaletteStride;
+
+			// Row vector matrix columns, the fourth component is the translation
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				rows[c * 4 + 0] = m[0 * 3 + c];
+				rows[c * 4 + 1] = m[1 * 3 + c];
+				rows[c * 4 + 2] = m[2 * 3 + c];
+				rows[c * 4 + 3] = m[3 * 3 + c];
+			}
+		}
+	}
+
+	void SkinVertex(const GpuSkinningVertex& vertex, const GpuMorphVertex& morph, const float* packedPalette, float* position, float* normal, float* uv)
+	{
+		float px = vertex.position[0] + morph.position[0];
+		float py = vertex.position[1] + morph.position[1];
+		float pz = vertex.position[2] + morph.position[2];
+
+		float result[6] = {};
+
+		for (unsigned int k = 0; k < 4; k++)
+		{
+			float weight = vertex.boneWeights[k] / 65535.0f;
+			const float* rows = packedPalette + vertex.boneIndices[k] * gpuSkinningPaletteStride;
+
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				const float* row = rows + c * 4;
+				result[c] += weight * (row[0] * px + row[1] * py + row[2] * pz + row[3]);
+				result[3 + c] += weight * (row[0] * vertex.normal[0] + row[1] * vertex.normal[1] + row[2] * vertex.normal[2]);
+			}
+		}
+
+		float inverseLength = 1.0f / std::sqrt(result[3] * result[3] + result[4] * result[4] + result[5] * result[5] + 1e-20f);
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			position[c] = result[c];
+			normal[c] = result[3 + c] * inverseLength;
+		}
+
+		uv[0] = vertex.uv[0] + morph.uv[0];
+		uv[1] = vertex.uv[1] + morph.uv[1];
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "SkinningKernel.h"
+
+// Static vertex of the GPU skinning path, bone weights in unorm16
+struct GpuSkinningVertex
+{
+	float position[3];
+	float normal[3];
+	float uv[2];
+	unsigned short boneIndices[4];
+	unsigned short boneWeights[4];
+};
+
+// Per frame vertex morph offset, second vertex stream of the GPU skinning path
+struct GpuMorphVertex
+{
+	float position[3];
+	float uv[2];
+};
+
+// Palette entry per bone : three float4 rows so the shader skins with dot(row, float4(position, 1))
+constexpr unsigned int gpuSkinningPaletteStride = 12;
+// 64KB constant buffer limit
+constexpr unsigned int maxGpuSkinningBoneCount = 4096 / 3;
+
+namespace GpuSkinning
+{
+	// influenceCount weights as the CPU kernels blend them, BDEF2 and SDEF pass both weights
+	void PackVertex(const float* position, const float* normal, const float* uv, unsigned int influenceCount, const int* boneIndices, const float* boneWeights, GpuSkinningVertex& vertex);
+	// skinningPalette in the SkinningKernel layout (skinningPaletteStride floats per bone)
+	void PackPalette(const float* skinningPalette, unsigned int boneCount, float* destination);
+
+	// Same arithmetic as VS in PMXVertexShader.hlsl compiled with GPU_SKINNING
+	void SkinVertex(const GpuSkinningVertex& vertex, const GpuMorphVertex& morph, const float* packedPalette, float* position, float* normal, float* uv);
+}
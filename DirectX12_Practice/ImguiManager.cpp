@@ -15,6 +15,8 @@
 #include "IActor.h"
 #include "Serialize.h"
 #include "MaterialManager.h"
+#include "FrameTaskGraph.h"
+#include "RenderGraph.h"
 
 ImguiManager ImguiManager::_instance;
 
@@ -38,12 +40,16 @@ bool ImguiManager::Initialize(HWND hwnd, std::shared_ptr<Dx12Wrapper> dx)
 		return false;
 	}
 
+	// The backend writes the font view itself, straight into the shader visible heap
+	mFontDescriptor = dx->AllocateDescriptors(1);
+	const DescriptorHeap& descriptorHeap = dx->GetDescriptorHeap();
+
 	result = ImGui_ImplDX12_Init(dx->Device().Get(),
-		3,
+		frames_in_flight,
 		DXGI_FORMAT_R8G8B8A8_UNORM,
-		dx->GetHeapForImgui().Get(),
-		dx->GetHeapForImgui()->GetCPUDescriptorHandleForHeapStart(),
-		dx->GetHeapForImgui()->GetGPUDescriptorHandleForHeapStart());
+		descriptorHeap.GetHeap(),
+		descriptorHeap.GetCpuHandle(mFontDescriptor.index),
+		descriptorHeap.GetGpuHandle(mFontDescriptor.index));
 
 	if (result == false)
 	{
@@ -79,7 +85,6 @@ void ImguiManager::StartUI()
 void ImguiManager::EndUI(std::shared_ptr<Dx12Wrapper> dx)
 {
 	ImGui::Render();
-	dx->CommandList()->SetDescriptorHeaps(1, dx->GetHeapForImgui().GetAddressOf());
 	ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), dx->CommandList().Get());
 }
 
@@ -99,10 +104,6 @@ void ImguiManager::UpdateAndSetDrawData(std::shared_ptr<Dx12Wrapper> dx)
 	ImGui::LabelText("FPS", std::to_string(fps).c_str());
 	ImGui::LabelText("MS", std::to_string(Time::GetDeltaTime()).c_str());
 
-	ImGui::LabelText("Animation", std::to_string(Time::GetAnimationUpdateTime()).c_str());
-	ImGui::LabelText("Morph", std::to_string(Time::GetMorphUpdateTime()).c_str());
-	ImGui::LabelText("Skinning", std::to_string(Time::GetSkinningUpdateTime()).c_str());
-
 	ImGui::End();
 
 	if (changed == true)
@@ -112,6 +113,76 @@ void ImguiManager::UpdateAndSetDrawData(std::shared_ptr<Dx12Wrapper> dx)
 	}
 }
 
+void ImguiManager::UpdateFrameTaskGraphWindow(const FrameTaskGraph& graph, bool& isPipelinedSimulation, float simulationWaitTime)
+{
+	ImGui::Begin("Frame Task Graph");
+	ImGui::SetWindowSize(ImVec2(400, 500), ImGuiCond_::ImGuiCond_FirstUseEver);
+
+	ImGui::Checkbox("Pipelined Simulation (1 frame latency)", &isPipelinedSimulation);
+	if (isPipelinedSimulation == true)
+	{
+		ImGui::Text("Render waited %.3f ms for the simulation", simulationWaitTime);
+	}
+
+	ImGui::Text("Update %.3f ms, work %.3f ms on %u threads", graph.GetFrameTime(), graph.GetTotalTaskTime(), JobSystem::Instance().GetThreadCount());
+	ImGui::Text("Critical Path %.3f ms", graph.GetCriticalPathTime());
+
+	for (unsigned int task : graph.GetCriticalPath())
+	{
+		ImGui::BulletText("%s : %.3f ms", graph.GetTaskName(task).c_str(), graph.GetTaskTime(task));
+	}
+
+	if (ImGui::CollapsingHeader("Tasks"))
+	{
+		for (unsigned int task = 0; task < graph.GetTaskCount(); task++)
+		{
+			ImGui::Text("%s : %.3f ms", graph.GetTaskName(task).c_str(), graph.GetTaskTime(task));
+		}
+	}
+
+	ImGui::End();
+}
+
+void ImguiManager::UpdateCommandRecordingWindow(const FrameTaskGraph& passGraph, const RenderGraph& renderGraph, float frameWaitTime, size_t uploadUsedSize, size_t uploadRegionSize)
+{
+	ImGui::Begin("Command Recording");
+	ImGui::SetWindowSize(ImVec2(400, 300), ImGuiCond_::ImGuiCond_FirstUseEver);
+
+	ImGui::Text("%u frames in flight, CPU waited %.3f ms for the GPU", frames_in_flight, frameWaitTime);
+	ImGui::Text("Upload %.1f / %.1f KB per frame", uploadUsedSize / 1024.0f, uploadRegionSize / 1024.0f);
+
+	ImGui::Text("Record %.3f ms, work %.3f ms on %u threads", passGraph.GetFrameTime(), passGraph.GetTotalTaskTime(), JobSystem::Instance().GetThreadCount());
+
+	for (unsigned int pass = 0; pass < passGraph.GetTaskCount(); pass++)
+	{
+		ImGui::Text("%s : %.3f ms", passGraph.GetTaskName(pass).c_str(), passGraph.GetTaskTime(pass));
+	}
+
+	ImGui::Separator();
+
+	unsigned int culledPassCount = 0;
+	for (unsigned int pass = 0; pass < renderGraph.GetPassCount(); pass++)
+	{
+		if (renderGraph.IsCulled(pass) == true)
+		{
+			culledPassCount++;
+		}
+	}
+
+	ImGui::Text("Render graph %u passes, %u culled", renderGraph.GetPassCount(), culledPassCount);
+	ImGui::Text("%u barriers, %u split", renderGraph.GetBarrierCount(), renderGraph.GetSplitBarrierCount());
+
+	for (unsigned int pass = 0; pass < renderGraph.GetPassCount(); pass++)
+	{
+		if (renderGraph.IsCulled(pass) == true)
+		{
+			ImGui::Text("Culled : %s", renderGraph.GetPassName(pass).c_str());
+		}
+	}
+
+	ImGui::End();
+}
+
 void ImguiManager::AddActor(std::shared_ptr<IActor> actor)
 {
 	mActorList.push_back(actor);
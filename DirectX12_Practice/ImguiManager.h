@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "IType.h"
+#include "DescriptorAllocator.h"
 
 class PMXActor;
 class PMXRenderer;
@@ -14,6 +15,8 @@ class FBXActor;
 class FBXRenderer;
 class IActor;
 class Transform;
+class FrameTaskGraph;
+class RenderGraph;
 
 constexpr float pi = 3.141592653589f;
 
@@ -35,6 +38,8 @@ public:
 	void EndUI(std::shared_ptr<Dx12Wrapper> dx);
 
 	void UpdateAndSetDrawData(std::shared_ptr<Dx12Wrapper> dx);
+	void UpdateFrameTaskGraphWindow(const FrameTaskGraph& graph, bool& isPipelinedSimulation, float simulationWaitTime);
+	void UpdateCommandRecordingWindow(const FrameTaskGraph& passGraph, const RenderGraph& renderGraph, float frameWaitTime, size_t uploadUsedSize, size_t uploadRegionSize);
 
 	void AddActor(std::shared_ptr<IActor> actor);
 
@@ -66,5 +71,8 @@ private:
 	bool _enableSSAO;
 
 	std::vector<std::shared_ptr<IActor>> mActorList = {};
+
+	// Font texture view in the heap of the Dx12Wrapper
+	DescriptorRange mFontDescriptor;
 };
 
@@ -29,7 +29,7 @@ void InstancingRenderer::Update()
 
 	for (auto& actor : mSSRActorList)
 	{
-		actor->Update();
+		actor->Update(mDirectX);
 	}
 }
 
@@ -94,16 +94,9 @@ void InstancingRenderer::AddActor(std::shared_ptr<GeometryActor> actor)
 
 HRESULT InstancingRenderer::CreateRootSignature()
 {
-	//Scene Buffer
-	D3D12_DESCRIPTOR_RANGE sceneBufferDescriptorRange = {};
-	sceneBufferDescriptorRange.NumDescriptors = 1;
-	sceneBufferDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	sceneBufferDescriptorRange.BaseShaderRegister = 0;
-	sceneBufferDescriptorRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
 	CD3DX12_ROOT_PARAMETER rootParam[3] = {};
 
-	rootParam[0].InitAsDescriptorTable(1, &sceneBufferDescriptorRange, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParam[0].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX); // SceneBuffer
 	rootParam[1].InitAsShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX); // InstanceBuffer;
 	rootParam[2].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX); // GlobalParameterBuffer
 
@@ -132,16 +125,9 @@ HRESULT InstancingRenderer::CreateRootSignature()
 
 HRESULT InstancingRenderer::CreateSSRRootSignature()
 {
-	//Scene Buffer
-	D3D12_DESCRIPTOR_RANGE sceneBufferDescriptorRange = {};
-	sceneBufferDescriptorRange.NumDescriptors = 1;
-	sceneBufferDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	sceneBufferDescriptorRange.BaseShaderRegister = 0;
-	sceneBufferDescriptorRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
 	CD3DX12_ROOT_PARAMETER rootParam[2] = {};
 
-	rootParam[0].InitAsDescriptorTable(1, &sceneBufferDescriptorRange, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParam[0].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX); // SceneBuffer
 	rootParam[1].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX); // TransformBuffer;
 
 	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
@@ -0,0 +1,293 @@
+#include "JobSystem.h"
+#include <immintrin.h>
+
+namespace
+{
+	// Pause takes about 140 cycles on recent cores, so roughly 100 microseconds before a thread with nothing to do parks
+	constexpr unsigned int spinCountBeforePark = 2048;
+
+	thread_local unsigned int localThreadIndex = 0;
+
+	class DequeLock
+	{
+	public:
+		explicit DequeLock(std::atomic_flag& lock) : _lock(lock)
+		{
+			while (_lock.test_and_set(std::memory_order_acquire) == true)
+			{
+				_mm_pause();
+			}
+		}
+
+		~DequeLock()
+		{
+			_lock.clear(std::memory_order_release);
+		}
+
+	private:
+		std::atomic_flag& _lock;
+	};
+}
+
+JobSystem& JobSystem::Instance()
+{
+	static JobSystem instance;
+	return instance;
+}
+
+JobSystem::JobSystem()
+{
+	unsigned int hardwareThreadCount = std::thread::hardware_concurrency();
+	unsigned int workerCount = hardwareThreadCount > 1 ? hardwareThreadCount - 1 : 0;
+
+	// Deque 0 belongs to the main thread and any other thread that is not a worker
+	for (unsigned int i = 0; i < workerCount + 1; i++)
+	{
+		mDeques.push_back(std::make_unique<JobDeque>());
+	}
+
+	// Parking should not allocate, every thread that can join at once fits
+	mParkedJoiners.reserve(workerCount + 1);
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		mWorkers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mIsRunning = false;
+	}
+	mWakeCondition.notify_all();
+
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+unsigned int JobSystem::GetThreadCount() const
+{
+	return static_cast<unsigned int>(mDeques.size());
+}
+
+void JobSystem::Push(const Job& job)
+{
+	if (TryPush(GetThreadIndex(), job) == false)
+	{
+		Execute(job);
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	unsigned int currentThreadIndex = GetThreadIndex();
+	unsigned int spinCount = 0;
+
+	while (counter.remaining.load(std::memory_order_acquire) > 0)
+	{
+		Job job;
+		if (TryGetJob(currentThreadIndex, job) == true)
+		{
+			Execute(job);
+			spinCount = 0;
+			continue;
+		}
+
+		if (++spinCount < spinCountBeforePark)
+		{
+			_mm_pause();
+			continue;
+		}
+
+		// Everything left is running on other threads, the last one to finish or the next push wakes us
+		ParkedJoiner joiner;
+		joiner.counter = &counter;
+
+		std::unique_lock<std::mutex> lock(mJoinMutex);
+		mParkedJoiners.push_back(&joiner);
+		mParkedJoinerCount.fetch_add(1);
+		joiner.condition.wait(lock, [this, &counter]() { return counter.remaining.load() == 0 || mPendingCount.load() > 0; });
+		mParkedJoinerCount.fetch_sub(1);
+		mParkedJoiners.erase(std::find(mParkedJoiners.begin(), mParkedJoiners.end(), &joiner));
+		spinCount = 0;
+	}
+}
+
+unsigned int JobSystem::GetThreadIndex() const
+{
+	return localThreadIndex;
+}
+
+bool JobSystem::TryPush(unsigned int threadIndex, const Job& job)
+{
+	JobDeque& deque = *mDeques[threadIndex];
+
+	{
+		DequeLock lock(deque.lock);
+		if (deque.bottom - deque.top == JobDeque::capacity)
+		{
+			return false;
+		}
+
+		deque.jobs[deque.bottom % JobDeque::capacity] = job;
+		deque.bottom++;
+	}
+
+	mPendingCount.fetch_add(1);
+
+	if (mSleepingCount.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mWakeCondition.notify_one();
+	}
+
+	// A parked joiner helps too, one that is not already on its way up
+	if (mParkedJoinerCount.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(mJoinMutex);
+		for (ParkedJoiner* joiner : mParkedJoiners)
+		{
+			if (joiner->isNotified == false)
+			{
+				joiner->isNotified = true;
+				joiner->condition.notify_one();
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool JobSystem::TryPop(unsigned int threadIndex, Job& job)
+{
+	JobDeque& deque = *mDeques[threadIndex];
+
+	DequeLock lock(deque.lock);
+	if (deque.bottom == deque.top)
+	{
+		return false;
+	}
+
+	// Newest first, it is the smallest split and still warm in this core's cache
+	deque.bottom--;
+	job = deque.jobs[deque.bottom % JobDeque::capacity];
+	mPendingCount.fetch_sub(1);
+	return true;
+}
+
+bool JobSystem::TrySteal(unsigned int threadIndex, Job& job)
+{
+	unsigned int dequeCount = static_cast<unsigned int>(mDeques.size());
+
+	for (unsigned int offset = 1; offset < dequeCount; offset++)
+	{
+		JobDeque& deque = *mDeques[(threadIndex + offset) % dequeCount];
+
+		DequeLock lock(deque.lock);
+		if (deque.bottom == deque.top)
+		{
+			continue;
+		}
+
+		// Oldest first, it is the largest split so one steal feeds the thief for a while
+		job = deque.jobs[deque.top % JobDeque::capacity];
+		deque.top++;
+		mPendingCount.fetch_sub(1);
+		return true;
+	}
+
+	return false;
+}
+
+bool JobSystem::TryGetJob(unsigned int threadIndex, Job& job)
+{
+	if (mPendingCount.load() == 0)
+	{
+		return false;
+	}
+
+	return TryPop(threadIndex, job) == true || TrySteal(threadIndex, job) == true;
+}
+
+void JobSystem::Execute(const Job& job)
+{
+	unsigned int currentThreadIndex = GetThreadIndex();
+	unsigned int threadCount = GetThreadCount();
+	unsigned int begin = job.begin;
+	unsigned int end = job.end;
+
+	while (begin < end)
+	{
+		// Lazy binary splitting : hand out the upper half only while there is too little queued work to feed every thread
+		while (end - begin > job.grainSize && mPendingCount.load() < threadCount)
+		{
+			unsigned int middle = begin + (end - begin) / 2;
+
+			Job upperHalf = job;
+			upperHalf.begin = middle;
+			upperHalf.end = end;
+
+			job.counter->remaining.fetch_add(1);
+			if (TryPush(currentThreadIndex, upperHalf) == false)
+			{
+				job.counter->remaining.fetch_sub(1);
+				break;
+			}
+
+			end = middle;
+		}
+
+		unsigned int chunkEnd = (std::min)(begin + job.grainSize, end);
+		job.function(job.data, begin, chunkEnd);
+		begin = chunkEnd;
+	}
+
+	// The counter may be gone once it reads zero, parked joiners are matched by address without touching it
+	JobCounter* counter = job.counter;
+	if (counter->remaining.fetch_sub(1) == 1 && mParkedJoinerCount.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(mJoinMutex);
+		for (ParkedJoiner* joiner : mParkedJoiners)
+		{
+			if (joiner->counter == counter)
+			{
+				joiner->isNotified = true;
+				joiner->condition.notify_one();
+			}
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int workerThreadIndex)
+{
+	localThreadIndex = workerThreadIndex;
+	unsigned int spinCount = 0;
+
+	while (mIsRunning.load() == true)
+	{
+		Job job;
+		if (TryGetJob(workerThreadIndex, job) == true)
+		{
+			Execute(job);
+			spinCount = 0;
+			continue;
+		}
+
+		if (++spinCount < spinCountBeforePark)
+		{
+			_mm_pause();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mSleepingCount.fetch_add(1);
+		mWakeCondition.wait(lock, [this]() { return mPendingCount.load() > 0 || mIsRunning.load() == false; });
+		mSleepingCount.fetch_sub(1);
+		spinCount = 0;
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Outstanding jobs of one fork/join, lives on the forking thread's stack
+struct JobCounter
+{
+	std::atomic<unsigned int> remaining{ 0 };
+};
+
+// Plain data so pushing a job never allocates, data outlives the job through the JobCounter wait
+struct Job
+{
+	void (*function)(const void* data, unsigned int begin, unsigned int end);
+	const void* data;
+	unsigned int begin;
+	unsigned int end;
+	unsigned int grainSize;
+	JobCounter* counter;
+};
+
+// Persistent worker pool, one deque per thread, idle threads steal from the others
+class JobSystem
+{
+public:
+	static JobSystem& Instance();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Workers plus the calling thread
+	unsigned int GetThreadCount() const;
+
+	// function(begin, end) over sub ranges of at least grainSize, the calling thread joins in and returns when all are done
+	template<typename Function>
+	void ParallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const Function& function);
+
+	// Queues job.counter must already count this job
+	void Push(const Job& job);
+	// Runs other jobs while waiting, parks until the counter drains or new jobs are queued
+	void Wait(JobCounter& counter);
+
+private:
+	JobSystem();
+	~JobSystem();
+
+	struct JobDeque
+	{
+		static constexpr unsigned int capacity = 1024;
+
+		std::atomic_flag lock = ATOMIC_FLAG_INIT;
+		unsigned int top = 0;
+		unsigned int bottom = 0;
+		Job jobs[capacity];
+	};
+
+	// A thread parked in Wait, lives on its stack and is listed only while it sleeps
+	struct ParkedJoiner
+	{
+		const JobCounter* counter = nullptr;
+		bool isNotified = false;
+		std::condition_variable condition;
+	};
+
+	template<typename Function>
+	static void RunRange(const void* data, unsigned int begin, unsigned int end);
+
+	unsigned int GetThreadIndex() const;
+	bool TryPush(unsigned int threadIndex, const Job& job);
+	bool TryPop(unsigned int threadIndex, Job& job);
+	bool TrySteal(unsigned int threadIndex, Job& job);
+	bool TryGetJob(unsigned int threadIndex, Job& job);
+	void Execute(const Job& job);
+	void WorkerLoop(unsigned int threadIndex);
+
+	std::vector<std::unique_ptr<JobDeque>> mDeques;
+	std::vector<std::thread> mWorkers;
+	std::atomic<bool> mIsRunning{ true };
+	std::atomic<unsigned int> mPendingCount{ 0 };
+	std::atomic<unsigned int> mSleepingCount{ 0 };
+
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeCondition;
+	// Guards mParkedJoiners, each joiner sleeps on its own condition so a wake reaches exactly one thread
+	std::mutex mJoinMutex;
+	std::vector<ParkedJoiner*> mParkedJoiners;
+	std::atomic<unsigned int> mParkedJoinerCount{ 0 };
+};
+
+template<typename Function>
+void JobSystem::ParallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const Function& function)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	JobCounter counter;
+	counter.remaining = 1;
+
+	Execute(Job{ &RunRange<Function>, &function, begin, end, (std::max)(grainSize, 1u), &counter });
+	Wait(counter);
+}
+
+template<typename Function>
+void JobSystem::RunRange(const void* data, unsigned int begin, unsigned int end)
+{
+	(*static_cast<const Function*>(data))(begin, end);
+}
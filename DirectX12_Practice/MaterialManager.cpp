@@ -47,8 +47,11 @@ void MaterialManager::AddNewMaterial(Dx12Wrapper& dx, std::string name)
 
 	if (mMaterialDataList.size() <= mNameList.size())
 	{
+		// Frames still in flight read the old buffer and views
+		dx.ReleaseAfterFrame(mMaterialBuff);
+		dx.FreeDescriptorsAfterFrame(mMaterialDescriptors);
 		mMaterialBuff.Reset();
-		mMaterialHeap.Reset();
+		mMaterialDescriptors = DescriptorRange();
 
 		StandardLoadMaterial newMaterial;
 		newMaterial.name = name;
@@ -245,32 +248,21 @@ void MaterialManager::SetMaterialData(std::string name, const StandardLoadMateri
 	uploadMaterial->bloomFactor = setData.isBloom ? 1.0f : 0.0f;
 }
 
-void MaterialManager::SetMaterialDescriptorHeaps(Dx12Wrapper& dx)
-{
-	ID3D12DescriptorHeap* heaps[] = { mMaterialHeap.Get() };
-	dx.CommandList()->SetDescriptorHeaps(1, heaps);
-}
-
-
 void MaterialManager::SetGraphicsRootDescriptorTableMaterial(Dx12Wrapper& dx, unsigned rootParameterIndex, std::string name)
 {
-	auto matDescHeapHandle = mMaterialHeap->GetGPUDescriptorHandleForHeapStart();
+	const DescriptorHeap& descriptorHeap = dx.GetDescriptorHeap();
 
 	auto it = mIndexByName.find(name);
 	if (it == mIndexByName.end())
 	{
-		dx.CommandList()->SetGraphicsRootDescriptorTable(rootParameterIndex, matDescHeapHandle);
+		dx.CommandList()->SetGraphicsRootDescriptorTable(rootParameterIndex, descriptorHeap.GetGpuHandle(mMaterialDescriptors.index));
 
 		return;
 	}
 
 	unsigned int index = it->second;
 
-	auto increaseSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-	matDescHeapHandle.ptr += increaseSize * index;
-
-	dx.CommandList()->SetGraphicsRootDescriptorTable(rootParameterIndex, matDescHeapHandle);
+	dx.CommandList()->SetGraphicsRootDescriptorTable(rootParameterIndex, descriptorHeap.GetGpuHandle(mMaterialDescriptors.index + index));
 }
 
 bool MaterialManager::CreateBuffer(Dx12Wrapper& dx)
@@ -318,19 +310,14 @@ bool MaterialManager::CreateBuffer(Dx12Wrapper& dx)
 
 bool MaterialManager::CreateMaterialView(Dx12Wrapper& dx)
 {
-	D3D12_DESCRIPTOR_HEAP_DESC matDescHeapDesc = {};
-	matDescHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	matDescHeapDesc.NodeMask = 0;
-	matDescHeapDesc.NumDescriptors = mMaterialDataList.size();
-	matDescHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	auto result = dx.Device()->CreateDescriptorHeap(&matDescHeapDesc, IID_PPV_ARGS(mMaterialHeap.ReleaseAndGetAddressOf()));
-	if (FAILED(result))
+	mMaterialDescriptors = dx.AllocateDescriptors(static_cast<unsigned int>(mMaterialDataList.size()));
+	if (mMaterialDescriptors.IsValid() == false)
 	{
-		assert(SUCCEEDED(result));
 		return false;
 	}
 
+	const DescriptorHeap& descriptorHeap = dx.GetDescriptorHeap();
+
 	auto materialBuffSize = sizeof(StandardUploadMaterial);
 	materialBuffSize = (materialBuffSize + 0xff) & ~0xff;
 
@@ -338,7 +325,7 @@ bool MaterialManager::CreateMaterialView(Dx12Wrapper& dx)
 	matCBVDesc.BufferLocation = mMaterialBuff->GetGPUVirtualAddress();
 	matCBVDesc.SizeInBytes = materialBuffSize;
 
-	auto matDescHeapHandle = mMaterialHeap->GetCPUDescriptorHandleForHeapStart();
+	auto matDescHeapHandle = descriptorHeap.GetStagingHandle(mMaterialDescriptors.index);
 	auto increaseSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
 	for (int i = 0; i < mMaterialDataList.size(); i++)
@@ -348,5 +335,7 @@ bool MaterialManager::CreateMaterialView(Dx12Wrapper& dx)
 		matCBVDesc.BufferLocation += materialBuffSize;
 	}
 
+	descriptorHeap.Commit(mMaterialDescriptors);
+
 	return true;
 }
@@ -6,6 +6,7 @@
 #include <DirectXMath.h>
 #include <wrl/client.h>
 #include "json.hpp"
+#include "DescriptorAllocator.h"
 
 template<typename T>
 using ComPtr = Microsoft::WRL::ComPtr<T>;
@@ -51,7 +52,6 @@ public:
 	bool GetMaterialData(std::string name, const StandardLoadMaterial** result) const;
 	void SetMaterialData(std::string name, const StandardLoadMaterial& setData);
 
-	void SetMaterialDescriptorHeaps(Dx12Wrapper& dx);
 	void SetGraphicsRootDescriptorTableMaterial(Dx12Wrapper& dx, unsigned int rootParameterIndex, std::string name);
 
 private:
@@ -62,7 +62,8 @@ private:
 	static MaterialManager mInstance;
 
 	ComPtr<ID3D12Resource> mMaterialBuff = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mMaterialHeap = nullptr;
+	// A constant buffer view per material, in the heap of the Dx12Wrapper
+	DescriptorRange mMaterialDescriptors;
 	char* mMappedMaterial = nullptr;
 
 	std::vector<StandardLoadMaterial> mMaterialDataList;
@@ -45,6 +45,7 @@ public:
 	const MorphType& GetMorphType() const { return _morphType; }
 
 	void SetPositionMorph(std::vector<PMXMorph::PositionMorph> pmxPositionMorphs);
+	void ClearPositionMorph() { std::vector<PMXMorph::PositionMorph>().swap(_positionMorphData); }
 	void SetUVMorph(std::vector<PMXMorph::UVMorph> pmxUVMorphs);
 	void SetMaterialMorph(std::vector<PMXMorph::MaterialMorph> pmxMaterialMorphs);
 	void SetBoneMorph(std::vector<PMXMorph::BoneMorph> pmxBoneMorphs);
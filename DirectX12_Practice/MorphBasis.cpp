@@ -0,0 +1,320 @@
+#include "MorphBasis.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <Windows.h>
+
+namespace
+{
+	// Cyclic Jacobi rotation. matrix becomes diagonal (eigen values), eigenVectors holds eigen vectors as columns
+	void DecomposeSymmetric(std::vector<double>& matrix, unsigned int size, std::vector<double>& eigenVectors)
+	{
+		eigenVectors.assign(size * size, 0.0);
+		for (unsigned int i = 0; i < size; i++)
+		{
+			eigenVectors[i * size + i] = 1.0;
+		}
+
+		double trace = 0.0;
+		for (unsigned int i = 0; i < size; i++)
+		{
+			trace += std::abs(matrix[i * size + i]);
+		}
+
+		constexpr unsigned int maxSweepCount = 64;
+		for (unsigned int sweep = 0; sweep < maxSweepCount; sweep++)
+		{
+			double offDiagonal = 0.0;
+			for (unsigned int p = 0; p < size; p++)
+			{
+				for (unsigned int q = p + 1; q < size; q++)
+				{
+					offDiagonal += matrix[p * size + q] * matrix[p * size + q];
+				}
+			}
+
+			if (offDiagonal <= trace * trace * 1e-24)
+			{
+				break;
+			}
+
+			for (unsigned int p = 0; p < size; p++)
+			{
+				for (unsigned int q = p + 1; q < size; q++)
+				{
+					double apq = matrix[p * size + q];
+					if (std::abs(apq) <= trace * 1e-15)
+					{
+						continue;
+					}
+
+					double theta = (matrix[q * size + q] - matrix[p * size + p]) / (2.0 * apq);
+					double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+					double c = 1.0 / std::sqrt(t * t + 1.0);
+					double s = t * c;
+
+					for (unsigned int k = 0; k < size; k++)
+					{
+						double akp = matrix[k * size + p];
+						double akq = matrix[k * size + q];
+						matrix[k * size + p] = c * akp - s * akq;
+						matrix[k * size + q] = s * akp + c * akq;
+					}
+
+					for (unsigned int k = 0; k < size; k++)
+					{
+						double apk = matrix[p * size + k];
+						double aqk = matrix[q * size + k];
+						matrix[p * size + k] = c * apk - s * aqk;
+						matrix[q * size + k] = s * apk + c * aqk;
+					}
+
+					for (unsigned int k = 0; k < size; k++)
+					{
+						double vkp = eigenVectors[k * size + p];
+						double vkq = eigenVectors[k * size + q];
+						eigenVectors[k * size + p] = c * vkp - s * vkq;
+						eigenVectors[k * size + q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+	}
+}
+
+MorphBasis::MorphBasis()
+{
+}
+
+bool MorphBasis::Build(const std::vector<Morph>& morphs, const std::vector<unsigned int>& morphIndices, unsigned int vertexCount, const MorphCompressionSetting& setting)
+{
+	Clear();
+
+	if (setting.enable == false || morphIndices.size() < 2)
+	{
+		return false;
+	}
+
+	unsigned int morphCount = static_cast<unsigned int>(morphIndices.size());
+
+	std::vector<unsigned int> rowByVertex(vertexCount, UINT_MAX);
+	unsigned int entryCount = 0;
+
+	for (unsigned int morphIndex : morphIndices)
+	{
+		for (const PMXMorph::PositionMorph& data : morphs[morphIndex].GetPositionMorphData())
+		{
+			if (data.vertexIndex < vertexCount)
+			{
+				rowByVertex[data.vertexIndex] = 0;
+				entryCount++;
+			}
+		}
+	}
+
+	std::vector<unsigned int> vertexIndices;
+	for (unsigned int vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		if (rowByVertex[vertexIndex] == UINT_MAX)
+		{
+			continue;
+		}
+
+		rowByVertex[vertexIndex] = static_cast<unsigned int>(vertexIndices.size());
+		vertexIndices.push_back(vertexIndex);
+	}
+
+	unsigned int rowCount = static_cast<unsigned int>(vertexIndices.size());
+	if (rowCount == 0)
+	{
+		return false;
+	}
+
+	// Dense delta columns (rowCount * 3 per morph) and the rows each morph touches
+	std::vector<float> deltas(static_cast<size_t>(morphCount) * rowCount * 3, 0.f);
+	std::vector<std::vector<unsigned int>> morphRows(morphCount);
+
+	for (unsigned int column = 0; column < morphCount; column++)
+	{
+		float* delta = &deltas[static_cast<size_t>(column) * rowCount * 3];
+		std::vector<unsigned int>& rows = morphRows[column];
+
+		for (const PMXMorph::PositionMorph& data : morphs[morphIndices[column]].GetPositionMorphData())
+		{
+			if (data.vertexIndex >= vertexCount)
+			{
+				continue;
+			}
+
+			unsigned int row = rowByVertex[data.vertexIndex];
+			delta[row * 3 + 0] += data.position.x;
+			delta[row * 3 + 1] += data.position.y;
+			delta[row * 3 + 2] += data.position.z;
+			rows.push_back(row);
+		}
+
+		std::sort(rows.begin(), rows.end());
+		rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+	}
+
+	std::vector<double> gram(morphCount * morphCount, 0.0);
+	for (unsigned int i = 0; i < morphCount; i++)
+	{
+		const float* deltaI = &deltas[static_cast<size_t>(i) * rowCount * 3];
+
+		for (unsigned int j = i; j < morphCount; j++)
+		{
+			const float* deltaJ = &deltas[static_cast<size_t>(j) * rowCount * 3];
+
+			double dot = 0.0;
+			for (unsigned int row : morphRows[i])
+			{
+				dot += static_cast<double>(deltaI[row * 3 + 0]) * deltaJ[row * 3 + 0];
+				dot += static_cast<double>(deltaI[row * 3 + 1]) * deltaJ[row * 3 + 1];
+				dot += static_cast<double>(deltaI[row * 3 + 2]) * deltaJ[row * 3 + 2];
+			}
+
+			gram[i * morphCount + j] = dot;
+			gram[j * morphCount + i] = dot;
+		}
+	}
+
+	std::vector<double> eigenVectors;
+	DecomposeSymmetric(gram, morphCount, eigenVectors);
+
+	std::vector<unsigned int> order(morphCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(),
+		[&gram, morphCount](unsigned int left, unsigned int right)
+		{
+			return gram[left * morphCount + left] > gram[right * morphCount + right];
+		});
+
+	// Discarded eigen values are the squared Frobenius error of the truncation
+	std::vector<double> discarded(morphCount + 1, 0.0);
+	for (int k = static_cast<int>(morphCount) - 1; k >= 0; k--)
+	{
+		discarded[k] = discarded[k + 1] + (std::max)(gram[order[k] * morphCount + order[k]], 0.0);
+	}
+
+	double sampleCount = static_cast<double>(rowCount) * morphCount;
+	unsigned int maxBasisCount = (std::min)(setting.maxBasisCount, morphCount);
+	unsigned int basisCount = 0;
+
+	for (unsigned int k = 1; k <= maxBasisCount; k++)
+	{
+		if (std::sqrt(discarded[k] / sampleCount) <= setting.errorBound)
+		{
+			basisCount = k;
+			break;
+		}
+	}
+
+	if (basisCount == 0)
+	{
+		OutputDebugStringA("Skip Morph Compression : Error Bound Not Reached");
+		return false;
+	}
+
+	if (static_cast<size_t>(rowCount) * basisCount >= entryCount)
+	{
+		OutputDebugStringA("Skip Morph Compression : Basis Larger Than Sparse Morphs");
+		return false;
+	}
+
+	_morphIndices = morphIndices;
+	_vertexIndices = std::move(vertexIndices);
+	_basisCount = basisCount;
+	_reconstructionError = static_cast<float>(std::sqrt(discarded[basisCount] / sampleCount));
+
+	_basis.assign(static_cast<size_t>(rowCount) * basisCount, XMFLOAT4A(0.f, 0.f, 0.f, 0.f));
+	_coefficients.resize(basisCount * morphCount);
+	_frameCoefficients.resize(basisCount, 0.f);
+
+	for (unsigned int k = 0; k < basisCount; k++)
+	{
+		for (unsigned int column = 0; column < morphCount; column++)
+		{
+			_coefficients[k * morphCount + column] = static_cast<float>(eigenVectors[column * morphCount + order[k]]);
+		}
+	}
+
+	for (unsigned int column = 0; column < morphCount; column++)
+	{
+		const float* delta = &deltas[static_cast<size_t>(column) * rowCount * 3];
+
+		for (unsigned int row : morphRows[column])
+		{
+			for (unsigned int k = 0; k < basisCount; k++)
+			{
+				float coefficient = _coefficients[k * morphCount + column];
+				XMFLOAT4A& basis = _basis[static_cast<size_t>(row) * basisCount + k];
+				basis.x += delta[row * 3 + 0] * coefficient;
+				basis.y += delta[row * 3 + 1] * coefficient;
+				basis.z += delta[row * 3 + 2] * coefficient;
+			}
+		}
+	}
+
+	std::string message = "Morph Compression : " + std::to_string(morphCount) + " morphs, " + std::to_string(rowCount) + " vertices, "
+		+ std::to_string(basisCount) + " basis, rms error " + std::to_string(_reconstructionError);
+	OutputDebugStringA(message.c_str());
+
+	return true;
+}
+
+bool MorphBasis::UpdateCoefficients(const std::vector<float>& morphWeights, float epsilon)
+{
+	if (IsValid() == false)
+	{
+		return false;
+	}
+
+	std::fill(_frameCoefficients.begin(), _frameCoefficients.end(), 0.f);
+
+	unsigned int morphCount = static_cast<unsigned int>(_morphIndices.size());
+	bool isActive = false;
+
+	for (unsigned int column = 0; column < morphCount; column++)
+	{
+		float weight = morphWeights[_morphIndices[column]];
+		if (std::abs(weight) < epsilon)
+		{
+			continue;
+		}
+
+		isActive = true;
+		for (unsigned int k = 0; k < _basisCount; k++)
+		{
+			_frameCoefficients[k] += _coefficients[k * morphCount + column] * weight;
+		}
+	}
+
+	return isActive;
+}
+
+XMVECTOR MorphBasis::Evaluate(unsigned int row) const
+{
+	const XMFLOAT4A* basis = &_basis[static_cast<size_t>(row) * _basisCount];
+
+	XMVECTOR result = XMVectorZero();
+	for (unsigned int k = 0; k < _basisCount; k++)
+	{
+		result = XMVectorMultiplyAdd(XMLoadFloat4A(&basis[k]), XMVectorReplicate(_frameCoefficients[k]), result);
+	}
+
+	return result;
+}
+
+void MorphBasis::Clear()
+{
+	_morphIndices.clear();
+	_vertexIndices.clear();
+	_basisCount = 0;
+	_reconstructionError = 0.f;
+	_basis.clear();
+	_coefficients.clear();
+	_frameCoefficients.clear();
+}
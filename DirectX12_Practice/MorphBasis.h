@@ -0,0 +1,47 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+#include "Morph.h"
+
+using namespace DirectX;
+
+struct MorphCompressionSetting
+{
+	bool enable = false;
+	float errorBound = 0.0005f;		// RMS position error allowed per vertex and morph (model units)
+	unsigned int maxBasisCount = 64;
+};
+
+// Truncated PCA basis of a set of position morphs : delta(w) = B * (C * w)
+class MorphBasis
+{
+public:
+	MorphBasis();
+
+	bool Build(const std::vector<Morph>& morphs, const std::vector<unsigned int>& morphIndices, unsigned int vertexCount, const MorphCompressionSetting& setting);
+
+	bool IsValid() const { return _basisCount > 0; }
+	unsigned int GetBasisCount() const { return _basisCount; }
+	float GetReconstructionError() const { return _reconstructionError; }
+
+	const std::vector<unsigned int>& GetMorphIndices() const { return _morphIndices; }
+	const std::vector<unsigned int>& GetVertexIndices() const { return _vertexIndices; }
+
+	bool UpdateCoefficients(const std::vector<float>& morphWeights, float epsilon);
+	XMVECTOR Evaluate(unsigned int row) const;
+
+private:
+	void Clear();
+
+private:
+	std::vector<unsigned int> _morphIndices;
+	std::vector<unsigned int> _vertexIndices;
+
+	unsigned int _basisCount = 0;
+	float _reconstructionError = 0.f;
+
+	std::vector<XMFLOAT4A> _basis;			// row major : row * basisCount + basisIndex
+	std::vector<float> _coefficients;		// basisIndex * morphCount + morph
+	std::vector<float> _frameCoefficients;
+};
@@ -1,12 +1,103 @@
 #include "MorphManager.h"
 #include "MathUtil.h"
 #include <algorithm>
+#include <climits>
+#include <cmath>
+#include <Windows.h>
+
+constexpr float morphWeightEpsilon = 0.0001f;
+
+namespace
+{
+	// Tarjan's strongly connected components over group to group references.
+	// A group is cyclic when its component holds another group or it references itself, wherever it sits in the morph list
+	class GroupMorphCycleSearch
+	{
+	public:
+		explicit GroupMorphCycleSearch(const std::vector<Morph>& morphs) :
+			_morphs(morphs),
+			_visitState(morphs.size(), 0),
+			_order(morphs.size(), 0),
+			_lowLink(morphs.size(), 0),
+			_isCyclic(morphs.size(), false)
+		{
+			for (unsigned int morphIndex = 0; morphIndex < _morphs.size(); morphIndex++)
+			{
+				if (_morphs[morphIndex].GetMorphType() == MorphType::Group && _visitState[morphIndex] == 0)
+				{
+					Visit(morphIndex);
+				}
+			}
+		}
+
+		const std::vector<bool>& GetCyclic() const { return _isCyclic; }
+
+	private:
+		void Visit(unsigned int morphIndex)
+		{
+			// 0 : not visited, 1 : on the stack, 2 : component done
+			_visitState[morphIndex] = 1;
+			_order[morphIndex] = _nextOrder;
+			_lowLink[morphIndex] = _nextOrder;
+			_nextOrder++;
+			_stack.push_back(morphIndex);
+
+			for (const PMXMorph::GroupMorph& data : _morphs[morphIndex].GetGroupMorphData())
+			{
+				unsigned int childIndex = data.morphIndex;
+				if (childIndex >= _morphs.size() || _morphs[childIndex].GetMorphType() != MorphType::Group)
+				{
+					continue;
+				}
+
+				if (childIndex == morphIndex)
+				{
+					_isCyclic[morphIndex] = true;
+				}
+
+				if (_visitState[childIndex] == 0)
+				{
+					Visit(childIndex);
+					_lowLink[morphIndex] = (std::min)(_lowLink[morphIndex], _lowLink[childIndex]);
+				}
+				else if (_visitState[childIndex] == 1)
+				{
+					_lowLink[morphIndex] = (std::min)(_lowLink[morphIndex], _order[childIndex]);
+				}
+			}
+
+			if (_lowLink[morphIndex] != _order[morphIndex])
+			{
+				return;
+			}
+
+			auto componentStart = std::find(_stack.begin(), _stack.end(), morphIndex);
+			bool isCycle = _stack.end() - componentStart > 1;
+
+			for (auto it = componentStart; it != _stack.end(); ++it)
+			{
+				_visitState[*it] = 2;
+				_isCyclic[*it] = _isCyclic[*it] || isCycle;
+			}
+
+			_stack.erase(componentStart, _stack.end());
+		}
+
+		const std::vector<Morph>& _morphs;
+		std::vector<unsigned char> _visitState;
+		std::vector<unsigned int> _order;
+		std::vector<unsigned int> _lowLink;
+		std::vector<unsigned int> _stack;
+		std::vector<bool> _isCyclic;
+		unsigned int _nextOrder = 0;
+	};
+}
 
 MorphManager::MorphManager()
 {
 }
 
-void MorphManager::Init(const std::vector<PMXMorph>& pmxMorphs, const std::vector<VMDMorph>& vmdMorphs, unsigned int vertexCount, unsigned int materialCount, unsigned int boneCount)
+void MorphManager::Init(const std::vector<PMXMorph>& pmxMorphs, const std::vector<VMDMorph>& vmdMorphs, unsigned int vertexCount, unsigned int materialCount, unsigned int boneCount, const MorphCompressionSetting& compressionSetting)
 {
 	_morphs.resize(pmxMorphs.size());
 
@@ -100,10 +191,12 @@ void MorphManager::Init(const std::vector<PMXMorph>& pmxMorphs, const std::vecto
 			});
 	}
 
-	_morphVertexPosition.resize(vertexCount);
-	_morphUV.resize(vertexCount);
 	_morphMaterial.resize(materialCount);
 	_morphBone.resize(boneCount);
+
+	InitGroupMorphLeaves();
+	InitMorphBasis(pmxMorphs, vertexCount, compressionSetting);
+	InitVertexMorphTable(vertexCount);
 }
 
 void MorphManager::Animate(unsigned frame)
@@ -137,20 +230,41 @@ void MorphManager::Animate(unsigned frame)
 		}
 	}
 
-	for (Morph& morph : _morphs)
+	AccumulateLeafMorphWeights();
+
+	_isMorphBasisActive = _morphBasis.UpdateCoefficients(_leafMorphWeights, morphWeightEpsilon);
+
+	for (unsigned int morphIndex = 0; morphIndex < _morphs.size(); morphIndex++)
 	{
-		AnimateMorph(morph);
+		float weight = _leafMorphWeights[morphIndex];
+		if (std::abs(weight) < morphWeightEpsilon)
+		{
+			continue;
+		}
+
+		AnimateMorph(_morphs[morphIndex], weight);
 	}
-}
 
-const XMFLOAT3& MorphManager::GetMorphVertexPosition(unsigned index) const
-{
-	return _morphVertexPosition[index];
+	CollectActiveVertexMorphRows();
 }
 
-const XMFLOAT4& MorphManager::GetMorphUV(unsigned index) const
+void MorphManager::GatherVertexMorph(unsigned int row, XMVECTOR& position, XMVECTOR& uv) const
 {
-	return _morphUV[index];
+	const VertexMorphTable& table = _vertexMorphTable;
+
+	position = XMVectorZero();
+	for (unsigned int entry = table.rowOffsets[row]; entry < table.uvRowOffsets[row]; ++entry)
+	{
+		float weight = _vertexMorphWeights[table.morphIndices[entry]];
+		position = XMVectorMultiplyAdd(XMLoadFloat4A(&table.deltas[entry]), XMVectorReplicate(weight), position);
+	}
+
+	uv = XMVectorZero();
+	for (unsigned int entry = table.uvRowOffsets[row]; entry < table.rowOffsets[row + 1]; ++entry)
+	{
+		float weight = _vertexMorphWeights[table.morphIndices[entry]];
+		uv = XMVectorMultiplyAdd(XMLoadFloat4A(&table.deltas[entry]), XMVectorReplicate(weight), uv);
+	}
 }
 
 const MaterialMorphData& MorphManager::GetMorphMaterial(unsigned index) const
@@ -187,11 +301,6 @@ void MorphManager::AnimateMorph(Morph& morph, float weight)
 			AnimateBoneMorph(morph, weight);
 		}
 		break;
-		case MorphType::Group:
-		{
-			AnimateGroupMorph(morph, weight);
-		}
-		break;
 		default:
 			break;
 	}
@@ -199,40 +308,12 @@ void MorphManager::AnimateMorph(Morph& morph, float weight)
 
 void MorphManager::AnimatePositionMorph(Morph& morph, float weight)
 {
-	const auto& vertexPositionMorph = morph.GetPositionMorphData();
-
-	for (const PMXMorph::PositionMorph& data : vertexPositionMorph)
-	{
-		if (data.vertexIndex >= _morphVertexPosition.size())
-		{
-			continue;
-		}
-
-		XMVECTOR originPosition = XMLoadFloat3(&_morphVertexPosition[data.vertexIndex]);
-		XMVECTOR morphPosition = XMLoadFloat3(&data.position) * morph.GetWeight() * weight;
-		XMFLOAT3 storePosition;
-		XMStoreFloat3(&storePosition, XMVectorAdd(originPosition, morphPosition));
-
-		_morphVertexPosition[data.vertexIndex] = storePosition;
-	}
+	ActivateVertexMorph(morph, weight);
 }
 
 void MorphManager::AnimateUVMorph(Morph& morph, float weight)
 {
-	const auto& uvMorph = morph.GetUVMorphData();
-
-	for (const PMXMorph::UVMorph& data : uvMorph)
-	{
-		if (data.vertexIndex >= _morphUV.size())
-		{
-			continue;
-		}
-
-		XMVECTOR morphUV = XMLoadFloat4(&data.uv);
-		XMVECTOR originUV = XMLoadFloat4(&_morphUV[data.vertexIndex]);
-
-		XMStoreFloat4(&_morphUV[data.vertexIndex], XMVectorAdd(originUV, morphUV) * morph.GetWeight() * weight);
-	}
+	ActivateVertexMorph(morph, weight);
 }
 
 void MorphManager::AnimateMaterialMorph(Morph& morph, float weight)
@@ -247,7 +328,7 @@ void MorphManager::AnimateMaterialMorph(Morph& morph, float weight)
 		}
 
 		MaterialMorphData& cur = _morphMaterial[data.materialIndex];
-		cur.weight = morph.GetWeight() * weight;
+		cur.weight = weight;
 		cur.opType = data.opType;
 		cur.diffuse = data.diffuse;
 		cur.specular = data.specular;
@@ -272,40 +353,292 @@ void MorphManager::AnimateBoneMorph(Morph& morph, float weight)
 			continue;
 		}
 
-		_morphBone[data.boneIndex].weight = morph.GetWeight() * weight;
+		_morphBone[data.boneIndex].weight = weight;
 		_morphBone[data.boneIndex].position = data.position;
 		_morphBone[data.boneIndex].quaternion = data.quaternion;
 	}
 }
 
-void MorphManager::AnimateGroupMorph(Morph& morph, float weight)
+void MorphManager::InitGroupMorphLeaves()
 {
-	const auto& groupMorph = morph.GetGroupMorphData();
+	_groupMorphLeaves.resize(_morphs.size());
+	_leafMorphWeights.resize(_morphs.size(), 0.f);
 
-	for (const PMXMorph::GroupMorph& data : groupMorph)
+	// Only the groups on a cycle are rejected, groups that merely reference one drop that reference
+	std::vector<bool> isCyclic = GroupMorphCycleSearch(_morphs).GetCyclic();
+	for (unsigned int morphIndex = 0; morphIndex < _morphs.size(); morphIndex++)
+	{
+		if (isCyclic[morphIndex] == true)
+		{
+			OutputDebugStringA("Reject Cyclic Group Morph");
+			_morphs[morphIndex].SetMorphType(MorphType::None);
+		}
+	}
+
+	// The remaining groups form a DAG, each leaf list is built once and reused by the groups above it
+	std::vector<bool> isResolved(_morphs.size(), false);
+	for (unsigned int morphIndex = 0; morphIndex < _morphs.size(); morphIndex++)
+	{
+		if (_morphs[morphIndex].GetMorphType() != MorphType::Group)
+		{
+			continue;
+		}
+
+		ResolveGroupMorph(morphIndex, isResolved);
+		_groupMorphIndices.push_back(morphIndex);
+	}
+}
+
+void MorphManager::ResolveGroupMorph(unsigned int morphIndex, std::vector<bool>& isResolved)
+{
+	if (isResolved[morphIndex] == true)
+	{
+		return;
+	}
+
+	std::vector<GroupMorphLeaf> leaves;
+
+	for (const PMXMorph::GroupMorph& data : _morphs[morphIndex].GetGroupMorphData())
 	{
 		if (data.morphIndex >= _morphs.size())
 		{
 			continue;
 		}
 
-		AnimateMorph(_morphs[data.morphIndex], morph.GetWeight() * weight);
+		MorphType childType = _morphs[data.morphIndex].GetMorphType();
+		if (childType == MorphType::None)
+		{
+			continue;
+		}
+
+		if (childType != MorphType::Group)
+		{
+			leaves.push_back(GroupMorphLeaf{ data.morphIndex, data.weight });
+			continue;
+		}
+
+		ResolveGroupMorph(data.morphIndex, isResolved);
+
+		for (const GroupMorphLeaf& childLeaf : _groupMorphLeaves[data.morphIndex])
+		{
+			leaves.push_back(GroupMorphLeaf{ childLeaf.morphIndex, childLeaf.factor * data.weight });
+		}
 	}
+
+	std::sort(leaves.begin(), leaves.end(),
+		[](const GroupMorphLeaf& left, const GroupMorphLeaf& right)
+		{
+			return left.morphIndex < right.morphIndex;
+		});
+
+	std::vector<GroupMorphLeaf>& mergedLeaves = _groupMorphLeaves[morphIndex];
+	for (const GroupMorphLeaf& leaf : leaves)
+	{
+		if (mergedLeaves.empty() == false && mergedLeaves.back().morphIndex == leaf.morphIndex)
+		{
+			mergedLeaves.back().factor += leaf.factor;
+			continue;
+		}
+
+		mergedLeaves.push_back(leaf);
+	}
+
+	isResolved[morphIndex] = true;
 }
 
-void MorphManager::ResetMorphData()
+void MorphManager::AccumulateLeafMorphWeights()
 {
-	for (XMFLOAT3& position : _morphVertexPosition)
+	for (unsigned int morphIndex = 0; morphIndex < _morphs.size(); morphIndex++)
+	{
+		const Morph& morph = _morphs[morphIndex];
+		_leafMorphWeights[morphIndex] = (morph.GetMorphType() == MorphType::Group) ? 0.f : morph.GetWeight();
+	}
+
+	for (unsigned int groupIndex : _groupMorphIndices)
 	{
-		position = XMFLOAT3(0.f, 0.f, 0.f);
+		const Morph& groupMorph = _morphs[groupIndex];
+		float groupWeight = groupMorph.GetWeight();
+
+		if (groupMorph.GetMorphType() != MorphType::Group || std::abs(groupWeight) < morphWeightEpsilon)
+		{
+			continue;
+		}
+
+		for (const GroupMorphLeaf& leaf : _groupMorphLeaves[groupIndex])
+		{
+			_leafMorphWeights[leaf.morphIndex] += groupWeight * leaf.factor;
+		}
 	}
+}
 
-	for (XMFLOAT4& uv : _morphUV)
+void MorphManager::InitMorphBasis(const std::vector<PMXMorph>& pmxMorphs, unsigned int vertexCount, const MorphCompressionSetting& compressionSetting)
+{
+	// Face panel : 1 eyebrow, 2 eye, 3 mouth
+	std::vector<unsigned int> faceMorphIndices;
+	for (unsigned int morphIndex = 0; morphIndex < _morphs.size(); morphIndex++)
+	{
+		const PMXMorph& pmxMorph = pmxMorphs[morphIndex];
+		if (_morphs[morphIndex].GetMorphType() != MorphType::Position || pmxMorph.controlPanel < 1 || pmxMorph.controlPanel > 3)
+		{
+			continue;
+		}
+
+		faceMorphIndices.push_back(morphIndex);
+	}
+
+	if (_morphBasis.Build(_morphs, faceMorphIndices, vertexCount, compressionSetting) == false)
+	{
+		return;
+	}
+
+	// Compressed morphs are evaluated from the basis and leave the sparse table
+	for (unsigned int morphIndex : _morphBasis.GetMorphIndices())
+	{
+		_morphs[morphIndex].ClearPositionMorph();
+	}
+}
+
+void MorphManager::InitVertexMorphTable(unsigned int vertexCount)
+{
+	std::vector<unsigned int> positionCount(vertexCount, 0);
+	std::vector<unsigned int> uvCount(vertexCount, 0);
+
+	for (const Morph& morph : _morphs)
+	{
+		for (const PMXMorph::PositionMorph& data : morph.GetPositionMorphData())
+		{
+			if (data.vertexIndex < vertexCount)
+			{
+				positionCount[data.vertexIndex]++;
+			}
+		}
+
+		for (const PMXMorph::UVMorph& data : morph.GetUVMorphData())
+		{
+			if (data.vertexIndex < vertexCount)
+			{
+				uvCount[data.vertexIndex]++;
+			}
+		}
+	}
+
+	VertexMorphTable& table = _vertexMorphTable;
+	std::vector<unsigned int> rowByVertex(vertexCount, UINT_MAX);
+	unsigned int entryCount = 0;
+
+	for (unsigned int vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		if (positionCount[vertexIndex] + uvCount[vertexIndex] == 0)
+		{
+			continue;
+		}
+
+		rowByVertex[vertexIndex] = table.vertexIndices.size();
+		table.vertexIndices.push_back(vertexIndex);
+		table.rowOffsets.push_back(entryCount);
+		table.uvRowOffsets.push_back(entryCount + positionCount[vertexIndex]);
+
+		entryCount += positionCount[vertexIndex] + uvCount[vertexIndex];
+	}
+	table.rowOffsets.push_back(entryCount);
+
+	table.morphIndices.resize(entryCount);
+	table.deltas.resize(entryCount);
+
+	std::vector<unsigned int> positionCursor(table.rowOffsets.begin(), table.rowOffsets.end() - 1);
+	std::vector<unsigned int> uvCursor(table.uvRowOffsets.begin(), table.uvRowOffsets.end());
+
+	_vertexMorphRows.resize(_morphs.size());
+
+	for (unsigned int morphIndex = 0; morphIndex < _morphs.size(); morphIndex++)
+	{
+		const Morph& morph = _morphs[morphIndex];
+		std::vector<unsigned int>& morphRows = _vertexMorphRows[morphIndex];
+
+		for (const PMXMorph::PositionMorph& data : morph.GetPositionMorphData())
+		{
+			if (data.vertexIndex >= vertexCount)
+			{
+				continue;
+			}
+
+			unsigned int row = rowByVertex[data.vertexIndex];
+			unsigned int entry = positionCursor[row]++;
+			table.morphIndices[entry] = morphIndex;
+			table.deltas[entry] = XMFLOAT4A(data.position.x, data.position.y, data.position.z, 0.f);
+			morphRows.push_back(row);
+		}
+
+		for (const PMXMorph::UVMorph& data : morph.GetUVMorphData())
+		{
+			if (data.vertexIndex >= vertexCount)
+			{
+				continue;
+			}
+
+			unsigned int row = rowByVertex[data.vertexIndex];
+			unsigned int entry = uvCursor[row]++;
+			table.morphIndices[entry] = morphIndex;
+			table.deltas[entry] = XMFLOAT4A(data.uv.x, data.uv.y, data.uv.z, data.uv.w);
+			morphRows.push_back(row);
+		}
+	}
+
+	_vertexMorphWeights.resize(_morphs.size(), 0.f);
+	_isActiveRow.resize(table.vertexIndices.size(), false);
+	_activeRows.reserve(table.vertexIndices.size());
+}
+
+void MorphManager::ActivateVertexMorph(Morph& morph, float weight)
+{
+	unsigned int morphIndex = static_cast<unsigned int>(&morph - _morphs.data());
+
+	_activeVertexMorphs.push_back(morphIndex);
+	_vertexMorphWeights[morphIndex] = weight;
+}
+
+void MorphManager::CollectActiveVertexMorphRows()
+{
+	// Morphs are activated in index order, the rows only change with the set of active morphs
+	if (_activeVertexMorphs == _activeRowMorphs)
+	{
+		return;
+	}
+
+	for (unsigned int row : _activeRows)
+	{
+		_isActiveRow[row] = false;
+	}
+	_activeRows.clear();
+
+	for (unsigned int morphIndex : _activeVertexMorphs)
+	{
+		for (unsigned int row : _vertexMorphRows[morphIndex])
+		{
+			if (_isActiveRow[row] == true)
+			{
+				continue;
+			}
+
+			_isActiveRow[row] = true;
+			_activeRows.push_back(row);
+		}
+	}
+
+	std::sort(_activeRows.begin(), _activeRows.end());
+
+	_activeRowMorphs = _activeVertexMorphs;
+}
+
+void MorphManager::ResetMorphData()
+{
+	for (unsigned int morphIndex : _activeVertexMorphs)
 	{
-		uv = XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+		_vertexMorphWeights[morphIndex] = 0.f;
 	}
+	_activeVertexMorphs.clear();
 
-	for (MaterialMorphData material : _morphMaterial)
+	for (MaterialMorphData& material : _morphMaterial)
 	{
 		material.weight = 0.f;
 		material.diffuse = XMFLOAT4(0.f, 0.f, 0.f, 0.f);
@@ -319,7 +652,7 @@ void MorphManager::ResetMorphData()
 		material.toonTextureFactor = XMFLOAT4(0.f, 0.f, 0.f, 0.f);
 	}
 
-	for (BoneMorphData bone : _morphBone)
+	for (BoneMorphData& bone : _morphBone)
 	{
 		bone.weight = 0.f;
 		bone.position = XMFLOAT3(0.f, 0.f, 0.f);
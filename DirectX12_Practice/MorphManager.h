@@ -4,6 +4,7 @@
 #include <unordered_map>
 
 #include "Morph.h"
+#include "MorphBasis.h"
 
 using namespace DirectX;
 
@@ -29,27 +30,55 @@ struct BoneMorphData
 	XMFLOAT4 quaternion;
 };
 
+struct VertexMorphTable
+{
+	std::vector<unsigned int> vertexIndices;
+	std::vector<unsigned int> rowOffsets;
+	std::vector<unsigned int> uvRowOffsets;
+	std::vector<unsigned int> morphIndices;
+	std::vector<XMFLOAT4A> deltas;
+};
+
+struct GroupMorphLeaf
+{
+	unsigned int morphIndex;
+	float factor;
+};
+
 class MorphManager
 {
 public:
 	MorphManager();
 
-	void Init(const std::vector<PMXMorph>& pmxMorphs, const std::vector<VMDMorph>& vmdMorphs, unsigned int vertexCount, unsigned int materialCount, unsigned int boneCount);
+	void Init(const std::vector<PMXMorph>& pmxMorphs, const std::vector<VMDMorph>& vmdMorphs, unsigned int vertexCount, unsigned int materialCount, unsigned int boneCount, const MorphCompressionSetting& compressionSetting = MorphCompressionSetting());
 
 	void Animate(unsigned int frame);
 
-	const XMFLOAT3& GetMorphVertexPosition(unsigned int index) const;
-	const XMFLOAT4& GetMorphUV(unsigned int index) const;
+	const VertexMorphTable& GetVertexMorphTable() const { return _vertexMorphTable; }
+	const std::vector<unsigned int>& GetActiveVertexMorphRows() const { return _activeRows; }
+	void GatherVertexMorph(unsigned int row, XMVECTOR& position, XMVECTOR& uv) const;
+
+	const MorphBasis& GetMorphBasis() const { return _morphBasis; }
+	bool IsMorphBasisActive() const { return _isMorphBasisActive; }
+
 	const MaterialMorphData& GetMorphMaterial(unsigned int index) const;
 	const BoneMorphData& GetMorphBone(unsigned int index) const;
 
 private:
-	void AnimateMorph(Morph& morph, float weight = 1.f);
+	void AnimateMorph(Morph& morph, float weight);
 	void AnimatePositionMorph(Morph& morph, float weight);
 	void AnimateUVMorph(Morph& morph, float weight);
 	void AnimateMaterialMorph(Morph& morph, float weight);
 	void AnimateBoneMorph(Morph& morph, float weight);
-	void AnimateGroupMorph(Morph& morph, float weight);
+
+	void InitGroupMorphLeaves();
+	void ResolveGroupMorph(unsigned int morphIndex, std::vector<bool>& isResolved);
+	void AccumulateLeafMorphWeights();
+
+	void InitMorphBasis(const std::vector<PMXMorph>& pmxMorphs, unsigned int vertexCount, const MorphCompressionSetting& compressionSetting);
+	void InitVertexMorphTable(unsigned int vertexCount);
+	void ActivateVertexMorph(Morph& morph, float weight);
+	void CollectActiveVertexMorphRows();
 
 	void ResetMorphData();
 
@@ -57,11 +86,24 @@ private:
 	std::vector<Morph> _morphs;
 	std::unordered_map<std::wstring, Morph*> _morphByName;
 
+	std::vector<std::vector<GroupMorphLeaf>> _groupMorphLeaves;
+	std::vector<unsigned int> _groupMorphIndices;
+	std::vector<float> _leafMorphWeights;
+
 	std::vector<VMDMorph> _morphKeys;
 	std::unordered_map<std::wstring, std::vector<VMDMorph*>> _morphKeyByName;
 
-	std::vector<XMFLOAT3> _morphVertexPosition;
-	std::vector<XMFLOAT4> _morphUV;
+	VertexMorphTable _vertexMorphTable;
+	std::vector<std::vector<unsigned int>> _vertexMorphRows;
+	std::vector<float> _vertexMorphWeights;
+	std::vector<unsigned int> _activeVertexMorphs;
+	std::vector<bool> _isActiveRow;
+	std::vector<unsigned int> _activeRows;
+	std::vector<unsigned int> _activeRowMorphs;
+
+	MorphBasis _morphBasis;
+	bool _isMorphBasisActive = false;
+
 	std::vector<MaterialMorphData> _morphMaterial;
 	std::vector<BoneMorphData> _morphBone;
 };
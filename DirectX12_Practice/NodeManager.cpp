@@ -1,6 +1,8 @@
 #include "NodeManager.h"
 #include <algorithm>
 
+#include "JobSystem.h"
+
 NodeManager::NodeManager()
 {
 }
@@ -118,8 +120,6 @@ void NodeManager::Init(const std::vector<PMXBone>& bones)
 	OrderingGlobalUpdate(true);
 	OrderingAppendOrIKUpdate(false);
 	OrderingAppendOrIKUpdate(true);
-
-	InitParallelAnimateEvaluate();
 }
 
 void NodeManager::SortKey()
@@ -164,26 +164,15 @@ void NodeManager::BeforeUpdateAnimation()
 
 void NodeManager::EvaluateAnimation(unsigned frameNo)
 {
-	const int futureCount = _parallelEvaluateFutures.size();
-
-	for (int i = 0; i < futureCount; i++)
-	{
-		const AnimateEvaluateRange& currentRange = _animateEvaluateRanges[i];
-		_parallelEvaluateFutures[i] = std::async(std::launch::async, [this, frameNo, currentRange]()
+	JobSystem::Instance().ParallelFor(0, _boneNodeByIdx.size(), 16, [this, frameNo](unsigned int startIndex, unsigned int endIndex)
+		{
+			for (unsigned int i = startIndex; i < endIndex; ++i)
 			{
-				for (int i = currentRange.startIndex; i < currentRange.startIndex + currentRange.vertexCount; ++i)
-				{
-					BoneNode* curNode = _boneNodeByIdx[i];
-					curNode->AnimateMotion(frameNo);
-					curNode->AnimateIK(frameNo);
-				}
-			});
-	}
-
-	for (const std::future<void>& future : _parallelEvaluateFutures)
-	{
-		future.wait();
-	}
+				BoneNode* curNode = _boneNodeByIdx[i];
+				curNode->AnimateMotion(frameNo);
+				curNode->AnimateIK(frameNo);
+			}
+		});
 
 	//for (BoneNode* curNode : _boneNodeByIdx)
 	//{
@@ -453,28 +442,4 @@ void NodeManager::AddGlobalOrder(BoneNode* node, bool afterPhysics)
 	}
 }
 
-void NodeManager::InitParallelAnimateEvaluate()
-{
-	unsigned int threadCount = (std::thread::hardware_concurrency() * 2) + 1;
-	unsigned int divNum = threadCount - 1;
-
-	_animateEvaluateRanges.resize(threadCount);
-	_parallelEvaluateFutures.resize(threadCount);
-
-	unsigned int divVertexCount = _boneNodeByIdx.size() / divNum;
-	unsigned int remainder = _boneNodeByIdx.size() % divNum;
-
-	int startIndex = 0;
-	for (int i = 0; i < _animateEvaluateRanges.size() - 1; i++)
-	{
-		_animateEvaluateRanges[i].startIndex = startIndex;
-		_animateEvaluateRanges[i].vertexCount = divVertexCount;
-
-		startIndex += _animateEvaluateRanges[i].vertexCount;
-	}
-
-	_animateEvaluateRanges[_animateEvaluateRanges.size() - 1].startIndex = startIndex;
-	_animateEvaluateRanges[_animateEvaluateRanges.size() - 1].vertexCount = remainder;
-}
-
 
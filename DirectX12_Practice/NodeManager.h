@@ -1,16 +1,9 @@
 #pragma once
 #include <unordered_map>
 #include <thread>
-#include <future>
 
 #include "IKSolver.h"
 
-struct AnimateEvaluateRange
-{
-	unsigned int startIndex;
-	unsigned int vertexCount;
-};
-
 class NodeManager
 {
 public:
@@ -38,7 +31,6 @@ private:
 	void OrderingGlobalUpdate(bool afterPhysics);
 	void OrderingAppendOrIKUpdate(bool afterPhysics);
 	void AddGlobalOrder(BoneNode* node, bool afterPhysics);
-	void InitParallelAnimateEvaluate();
 
 private:
 	std::unordered_map<std::wstring, BoneNode*> _boneNodeByName;
@@ -47,9 +39,6 @@ private:
 
 	std::vector<IKSolver*> _ikSolvers;
 
-	std::vector<AnimateEvaluateRange> _animateEvaluateRanges;
-	std::vector<std::future<void>> _parallelEvaluateFutures;
-
 	std::vector<int> _beforePhysicsLocalUpdateOrder;
 	std::vector<int> _beforePhysicsGlobalUpdateOrder;
 	std::vector<int> _beforePhysicsAppendOrIKUpdateOrder;
@@ -197,10 +197,10 @@ HRESULT PMDRenderer::CreateRootSignature()
 
 	//Ʈ Ķ
 	D3D12_ROOT_PARAMETER rootparam[4] = {};
-	rootparam[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rootparam[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 	rootparam[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-	rootparam[0].DescriptorTable.pDescriptorRanges = &descTblRange[0];
-	rootparam[0].DescriptorTable.NumDescriptorRanges = 1;
+	rootparam[0].Descriptor.ShaderRegister = 0;
+	rootparam[0].Descriptor.RegisterSpace = 0;
 
 	rootparam[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 	rootparam[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
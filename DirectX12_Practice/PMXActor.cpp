@@ -3,6 +3,10 @@
 #include <array>
 #include <bitset>
 #include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <string>
 #include <d3dx12.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
 
@@ -13,6 +17,10 @@
 #include "RigidBody.h"
 #include "Joint.h"
 #include "Time.h"
+#include "JobSystem.h"
+#include "FrameTaskGraph.h"
+#include "SkinningKernel.h"
+#include "VertexSkinning.h"
 #include "UnicodeUtil.h"
 #include "ImguiManager.h"
 #include "Imgui/imgui.h"
@@ -21,6 +29,55 @@ using namespace std;
 
 constexpr float epsilon = 0.0005f;
 
+namespace
+{
+	struct VertexWeightLess
+	{
+		bool operator()(const PMXVertex& vertex, PMXVertexWeight weightType) const { return vertex.weightType < weightType; }
+		bool operator()(PMXVertexWeight weightType, const PMXVertex& vertex) const { return weightType < vertex.weightType; }
+	};
+
+	unsigned int GetSkinningCost(PMXVertexWeight weightType)
+	{
+		switch (weightType)
+		{
+		case PMXVertexWeight::BDEF2:
+			return 2;
+		case PMXVertexWeight::BDEF4:
+			return 4;
+		case PMXVertexWeight::SDEF:
+			return 6;
+		default:
+			return 1;
+		}
+	}
+
+	// Every bone turns 45 degrees about its own head on a distinct axis, a harsher pose than most animation
+	XMVECTOR TransformByTestPose(const std::vector<PMXBone>& bones, int boneIndex, FXMVECTOR position)
+	{
+		XMVECTOR head = XMLoadFloat3(&bones[boneIndex].position);
+		XMVECTOR axis = XMVector3Normalize(XMVectorSet(std::sin(boneIndex * 1.7f), std::cos(boneIndex * 1.3f), 0.5f, 0.0f));
+		XMVECTOR rotation = XMQuaternionRotationNormal(axis, XM_PIDIV4);
+		return XMVectorAdd(head, XMVector3Rotate(XMVectorSubtract(position, head), rotation));
+	}
+
+	XMVECTOR BlendByTestPose(const std::vector<PMXBone>& bones, const int* boneIndices, const float* boneWeights, unsigned int influenceCount, FXMVECTOR position)
+	{
+		XMVECTOR result = XMVectorZero();
+		for (unsigned int k = 0; k < influenceCount; k++)
+		{
+			if (boneWeights[k] == 0.0f)
+			{
+				continue;
+			}
+
+			result = XMVectorMultiplyAdd(TransformByTestPose(bones, boneIndices[k], position), XMVectorReplicate(boneWeights[k]), result);
+		}
+
+		return result;
+	}
+}
+
 PMXActor::PMXActor()
 {
 }
@@ -38,7 +95,12 @@ bool PMXActor::Initialize(const std::wstring& filePath, Dx12Wrapper& dx)
 		return false;
 	}
 
-	LoadVertexData(mPmxFileData.vertices);
+	PruneVertexWeights();
+	SortVerticesByWeightType();
+	InitSkinningStream();
+	InitSkinningBounds();
+	InitMaterialVertices();
+	InitProxyMesh();
 
 	result = LoadVMDFile(L"VMD\\ラビットホール.vmd", mVmdFileData);
 	if (result == false)
@@ -48,10 +110,10 @@ bool PMXActor::Initialize(const std::wstring& filePath, Dx12Wrapper& dx)
 
 	//_transform.world = XMMatrixIdentity() * XMMatrixTranslation(0.0f, 0.0f, 0.0f);
 
-	InitParallelVertexSkinningSetting();
+	UpdateVisibleVertexRuns();
 
 	mNodeManager.Init(mPmxFileData.bones);
-	mMorphManager.Init(mPmxFileData.morphs, mVmdFileData.morphs, mPmxFileData.vertices.size(), mPmxFileData.materials.size(), mPmxFileData.bones.size());
+	mMorphManager.Init(mPmxFileData.morphs, mVmdFileData.morphs, mPmxFileData.vertices.size(), mPmxFileData.materials.size(), mPmxFileData.bones.size(), mMorphCompressionSetting);
 
 	InitAnimation(mVmdFileData);
 
@@ -63,12 +125,14 @@ bool PMXActor::Initialize(const std::wstring& filePath, Dx12Wrapper& dx)
 		return false;
 	}
 
-	hResult = CreateTransformView(dx);
+	hResult = CreateGpuSkinningBuffers(dx);
 	if (FAILED(hResult))
 	{
 		return false;
 	}
 
+	InitTransforms();
+
 	hResult = CreateMaterialData(dx);
 	if (FAILED(hResult))
 	{
@@ -88,88 +152,209 @@ bool PMXActor::Initialize(const std::wstring& filePath, Dx12Wrapper& dx)
 
 void PMXActor::Update()
 {
-	mMappedMatrices[0] = mTransform.GetTransformMatrix();
-	mMappedReflectionMatrices[0] = mTransform.GetPlanarReflectionsTransform(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	mTransforms[mSimulationSlot].world = mTransform.GetTransformMatrix();
+	mReflectionTransforms[mSimulationSlot].world = mTransform.GetPlanarReflectionsTransform(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+}
+
+void PMXActor::AddFrameTasks(FrameTaskGraph& graph)
+{
+	unsigned int morph = graph.AddTask(mName + " Morph", [this]() { UpdateMorph(); });
+	unsigned int boneEvaluate = graph.AddTask(mName + " Bone Evaluate", [this]() { EvaluateBones(); });
+	unsigned int ik = graph.AddTask(mName + " IK", [this]() { SolveIK(); });
+	unsigned int physicsSync = graph.AddTask(mName + " Physics Sync", [this]() { SyncPhysics(); });
+	unsigned int skinning = graph.AddTask(mName + " Skinning", [this]() { UpdateSkinning(); });
+	unsigned int upload = graph.AddTask(mName + " Upload", [this]() { UploadFrameData(); });
+
+	graph.AddDependency(morph, boneEvaluate);
+	graph.AddDependency(boneEvaluate, ik);
+	graph.AddDependency(ik, physicsSync);
+	graph.AddDependency(physicsSync, skinning);
+	graph.AddDependency(skinning, upload);
 }
 
-void PMXActor::UpdateAnimation()
+void PMXActor::PublishFrame()
 {
+	mRenderSlot = mSimulationSlot;
+}
+
+void PMXActor::UploadConstants(Dx12Wrapper& dx)
+{
+	mTransformAddress = dx.UploadConstantBuffer(&mTransforms[mRenderSlot], sizeof(TransformForShader));
+	mReflectionTransformAddress = dx.UploadConstantBuffer(&mReflectionTransforms[mRenderSlot], sizeof(TransformForShader));
+
+	const std::vector<MaterialForShader>& materials = mMaterials[mRenderSlot];
+	if (materials.empty() == true)
+	{
+		return;
+	}
+
+	size_t materialBufferSize = sizeof(MaterialForShader);
+	materialBufferSize = (materialBufferSize + 0xff) & ~0xff;
+
+	UploadAllocation allocation = dx.AllocateUpload(materialBufferSize * materials.size());
+	if (allocation.cpuAddress == nullptr)
+	{
+		// Nothing to bind, the draws skip the actor this frame
+		mTransformAddress = 0;
+		mReflectionTransformAddress = 0;
+		return;
+	}
+
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		memcpy(allocation.cpuAddress + i * materialBufferSize, &materials[i], sizeof(MaterialForShader));
+	}
+
+	mMaterialAddress = allocation.gpuAddress;
+}
+
+void PMXActor::UpdateMorph()
+{
+	// Never the slot the draws are reading, whether or not the last frame was published
+	mSimulationSlot = (mRenderSlot + 1) % frame_buffer_slots;
+
 	if (mStartTime <= 0)
 	{
 		mStartTime = Time::GetTime();
 	}
 
-	unsigned int elapsedTime = Time::GetTime() - mStartTime;
-	unsigned int frameNo = 30 * (elapsedTime / 1000.0f);
+	mElapsedTime = Time::GetTime() - mStartTime;
+	mFrameNo = 30 * (mElapsedTime / 1000.0f);
 
-	if (frameNo > mDuration)
+	if (mFrameNo > mDuration)
 	{
 		mStartTime = Time::GetTime();
-		frameNo = 0;
+		mFrameNo = 0;
 	}
 
-	Time::RecordStartMorphUpdateTime();
 	MorphMaterial();
 	MorphBone();
-	Time::EndMorphUpdate();
-
-	Time::RecordStartAnimationUpdateTime();
+}
 
+void PMXActor::EvaluateBones()
+{
 	mNodeManager.BeforeUpdateAnimation();
 
-	mMorphManager.Animate(frameNo);
-	mNodeManager.EvaluateAnimation(frameNo);
+	mMorphManager.Animate(mFrameNo);
+	mNodeManager.EvaluateAnimation(mFrameNo);
+}
 
+void PMXActor::SolveIK()
+{
 	mNodeManager.UpdateAnimation();
+}
 
-	UpdatePhysicsAnimation(elapsedTime);
+void PMXActor::SyncPhysics()
+{
+	UpdatePhysicsAnimation(mElapsedTime);
 
 	mNodeManager.UpdateAnimationAfterPhysics();
+}
+
+void PMXActor::UpdateSkinning()
+{
+	UpdateSkinningPalette();
+
+	if (mSkinningMode != SkinningMode::Gpu)
+	{
+		UpdateVertexQuantization();
+		VertexSkinning();
+	}
+}
+
+void PMXActor::UploadFrameData()
+{
+	Update();
+
+	if (mSkinningMode == SkinningMode::Gpu)
+	{
+		UpdateGpuSkinning();
+	}
+	else
+	{
+		WriteVertexQuantization();
+	}
 
-	Time::EndAnimationUpdate();
+	PMXRenderSnapshot& snapshot = mRenderSnapshots[mSimulationSlot];
+	snapshot.skinningMode = mSkinningMode;
+	snapshot.materialVisible.resize(mLoadedMaterial.size());
 
-	Time::RecordStartSkinningUpdateTime();
-	VertexSkinning();
-	std::copy(mUploadVertices.begin(), mUploadVertices.end(), mMappedVertex);
-	Time::EndSkinningUpdate();
+	for (unsigned int i = 0; i < mLoadedMaterial.size(); i++)
+	{
+		snapshot.materialVisible[i] = mLoadedMaterial[i].visible;
+	}
 }
 
 void PMXActor::Draw(Dx12Wrapper& dx, bool isShadow = false) const
 {
-	dx.CommandList()->IASetVertexBuffers(0, 1, &mVertexBufferView);
-	dx.CommandList()->IASetIndexBuffer(&mIndexBufferView);
-	dx.CommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	if (mTransformAddress == 0)
+	{
+		return;
+	}
 
-	ID3D12DescriptorHeap* transheap[] = { mTransformHeap.Get() };
-	dx.CommandList()->SetDescriptorHeaps(1, transheap);
-	dx.CommandList()->SetGraphicsRootDescriptorTable(1, mTransformHeap->GetGPUDescriptorHandleForHeapStart());
+	SetVertexBuffers(dx);
+	dx.CommandList()->IASetIndexBuffer(isShadow == true ? &mProxyIndexBufferView : &mIndexBufferView);
+	dx.CommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	ID3D12DescriptorHeap* mdh[] = { mMaterialHeap.Get() };
+	const PMXRenderSnapshot& snapshot = mRenderSnapshots[mRenderSlot];
+	auto incSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	dx.CommandList()->SetDescriptorHeaps(1, mdh);
+	dx.CommandList()->SetGraphicsRootConstantBufferView(1, mTransformAddress);
 
 	if (isShadow == true)
 	{
-		dx.CommandList()->DrawIndexedInstanced(mPmxFileData.faces.size() * 3, 1, 0, 0, 0);
+		// Hidden materials are not skinned, draw the visible index ranges merged where they touch
+		unsigned int idxOffset = 0;
+		unsigned int drawOffset = 0;
+		unsigned int drawCount = 0;
+
+		for (int i = 0; i < mPmxFileData.materials.size(); i++)
+		{
+			unsigned int numFaceVertices = mProxyIndexCounts[i];
+
+			if (snapshot.materialVisible[i] == true)
+			{
+				drawCount += numFaceVertices;
+			}
+			else
+			{
+				if (drawCount > 0)
+				{
+					dx.CommandList()->DrawIndexedInstanced(drawCount, 1, drawOffset, 0, 0);
+				}
+
+				drawOffset = idxOffset + numFaceVertices;
+				drawCount = 0;
+			}
+
+			idxOffset += numFaceVertices;
+		}
+
+		if (drawCount > 0)
+		{
+			dx.CommandList()->DrawIndexedInstanced(drawCount, 1, drawOffset, 0, 0);
+		}
 	}
 	else
 	{
-		auto cbvSrvIncSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) * 4;
+		auto srvIncSize = incSize * 3;
+		size_t materialBufferSize = (sizeof(MaterialForShader) + 0xff) & ~0xff;
 
-		auto materialH = mMaterialHeap->GetGPUDescriptorHandleForHeapStart();
+		auto materialH = dx.GetDescriptorHeap().GetGpuHandle(mMaterialDescriptors.index);
 		unsigned int idxOffset = 0;
 
 		for (int i = 0; i < mPmxFileData.materials.size(); i++)
 		{
 			unsigned int numFaceVertices = mPmxFileData.materials[i].numFaceVertices;
 
-			if (mLoadedMaterial[i].visible == true)
+			if (snapshot.materialVisible[i] == true)
 			{
+				dx.CommandList()->SetGraphicsRootConstantBufferView(6, mMaterialAddress + i * materialBufferSize);
 				dx.CommandList()->SetGraphicsRootDescriptorTable(2, materialH);
 				dx.CommandList()->DrawIndexedInstanced(numFaceVertices, 1, idxOffset, 0, 0);
 			}
 
-			materialH.ptr += cbvSrvIncSize;
+			materialH.ptr += srvIncSize;
 			idxOffset += numFaceVertices;
 		}
 	}
@@ -177,70 +362,76 @@ void PMXActor::Draw(Dx12Wrapper& dx, bool isShadow = false) const
 
 void PMXActor::DrawReflection(Dx12Wrapper& dx) const
 {
-	dx.CommandList()->IASetVertexBuffers(0, 1, &mVertexBufferView);
-	dx.CommandList()->IASetIndexBuffer(&mIndexBufferView);
-	dx.CommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	if (mReflectionTransformAddress == 0)
+	{
+		return;
+	}
 
-	ID3D12DescriptorHeap* transheap[] = { mTransformHeap.Get() };
-	dx.CommandList()->SetDescriptorHeaps(1, transheap);
+	SetVertexBuffers(dx);
+	dx.CommandList()->IASetIndexBuffer(&mProxyIndexBufferView);
+	dx.CommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	auto transformHandle = mTransformHeap->GetGPUDescriptorHandleForHeapStart();
+	const PMXRenderSnapshot& snapshot = mRenderSnapshots[mRenderSlot];
 	auto incSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	transformHandle.ptr += incSize;
-	dx.CommandList()->SetGraphicsRootDescriptorTable(1, transformHandle);
-
-	ID3D12DescriptorHeap* mdh[] = { mMaterialHeap.Get() };
-
-	dx.CommandList()->SetDescriptorHeaps(1, mdh);
+	dx.CommandList()->SetGraphicsRootConstantBufferView(1, mReflectionTransformAddress);
 
-	auto cbvSrvIncSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) * 4;
+	auto srvIncSize = incSize * 3;
+	size_t materialBufferSize = (sizeof(MaterialForShader) + 0xff) & ~0xff;
 
-	auto materialH = mMaterialHeap->GetGPUDescriptorHandleForHeapStart();
+	auto materialH = dx.GetDescriptorHeap().GetGpuHandle(mMaterialDescriptors.index);
 	unsigned int idxOffset = 0;
 
 	for (int i = 0; i < mPmxFileData.materials.size(); i++)
 	{
-		unsigned int numFaceVertices = mPmxFileData.materials[i].numFaceVertices;
+		unsigned int numFaceVertices = mProxyIndexCounts[i];
 
-		if (mLoadedMaterial[i].visible == true)
+		if (snapshot.materialVisible[i] == true)
 		{
+			dx.CommandList()->SetGraphicsRootConstantBufferView(6, mMaterialAddress + i * materialBufferSize);
 			dx.CommandList()->SetGraphicsRootDescriptorTable(2, materialH);
 			dx.CommandList()->DrawIndexedInstanced(numFaceVertices, 1, idxOffset, 0, 0);
 		}
 
-		materialH.ptr += cbvSrvIncSize;
+		materialH.ptr += srvIncSize;
 		idxOffset += numFaceVertices;
 	}
 }
 
 void PMXActor::DrawOpaque(Dx12Wrapper& dx) const
 {
-	dx.CommandList()->IASetVertexBuffers(0, 1, &mVertexBufferView);
+	if (mTransformAddress == 0)
+	{
+		return;
+	}
+
+	SetVertexBuffers(dx);
 	dx.CommandList()->IASetIndexBuffer(&mIndexBufferView);
 	dx.CommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	dx.CommandList()->SetDescriptorHeaps(1, mTransformHeap.GetAddressOf());
-	dx.CommandList()->SetGraphicsRootDescriptorTable(1, mTransformHeap->GetGPUDescriptorHandleForHeapStart());
+	const PMXRenderSnapshot& snapshot = mRenderSnapshots[mRenderSlot];
+	auto incSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	dx.CommandList()->SetDescriptorHeaps(1, mMaterialHeap.GetAddressOf());
+	dx.CommandList()->SetGraphicsRootConstantBufferView(1, mTransformAddress);
 
-	auto cbvSrvIncSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) * 4;
+	auto srvIncSize = incSize * 3;
+	size_t materialBufferSize = (sizeof(MaterialForShader) + 0xff) & ~0xff;
 
-	auto materialH = mMaterialHeap->GetGPUDescriptorHandleForHeapStart();
+	auto materialH = dx.GetDescriptorHeap().GetGpuHandle(mMaterialDescriptors.index);
 	unsigned int idxOffset = 0;
 
 	for (int i = 0; i < mPmxFileData.materials.size(); i++)
 	{
 		unsigned int numFaceVertices = mPmxFileData.materials[i].numFaceVertices;
 
-		if (mLoadedMaterial[i].isTransparent == false)
+		if (snapshot.materialVisible[i] == true && mLoadedMaterial[i].isTransparent == false)
 		{
+			dx.CommandList()->SetGraphicsRootConstantBufferView(6, mMaterialAddress + i * materialBufferSize);
 			dx.CommandList()->SetGraphicsRootDescriptorTable(2, materialH);
 			dx.CommandList()->DrawIndexedInstanced(numFaceVertices, 1, idxOffset, 0, 0);
 		}
 
-		materialH.ptr += cbvSrvIncSize;
+		materialH.ptr += srvIncSize;
 		idxOffset += numFaceVertices;
 	}
 }
@@ -252,6 +443,8 @@ const std::vector<LoadMaterial>& PMXActor::GetMaterials() const
 
 void PMXActor::SetMaterials(const std::vector<LoadMaterial>& setMaterials)
 {
+	bool isVisibilityChanged = false;
+
 	for (int i = 0; i < setMaterials.size(); i++)
 	{
 		if (mLoadedMaterial.size() <= i)
@@ -259,12 +452,19 @@ void PMXActor::SetMaterials(const std::vector<LoadMaterial>& setMaterials)
 			break;
 		}
 
+		isVisibilityChanged |= mLoadedMaterial[i].visible != setMaterials[i].visible;
+
 		mLoadedMaterial[i].visible = setMaterials[i].visible;
 		mLoadedMaterial[i].ambient = setMaterials[i].ambient;
 		mLoadedMaterial[i].diffuse = setMaterials[i].diffuse;
 		mLoadedMaterial[i].specular = setMaterials[i].specular;
 		mLoadedMaterial[i].specularPower = setMaterials[i].specularPower;
 	}
+
+	if (isVisibilityChanged == true)
+	{
+		UpdateVisibleVertexRuns();
+	}
 }
 
 Transform& PMXActor::GetTransform()
@@ -286,6 +486,28 @@ void PMXActor::UpdateImGui(Dx12Wrapper& dx)
 {
 	ImguiManager::Instance().DrawTransformUI(mTransform);
 
+	bool isDualQuaternionMode = mSkinningMode == SkinningMode::DualQuaternion;
+	if (ImGui::Checkbox("Dual Quaternion Skinning", &isDualQuaternionMode) == true)
+	{
+		SetSkinningMode(isDualQuaternionMode == true ? SkinningMode::DualQuaternion : SkinningMode::Default);
+	}
+
+	bool isGpuSkinningMode = mSkinningMode == SkinningMode::Gpu;
+	if (ImGui::Checkbox("GPU Skinning", &isGpuSkinningMode) == true)
+	{
+		SetSkinningMode(isGpuSkinningMode == true ? SkinningMode::Gpu : SkinningMode::Default);
+	}
+
+	ImGui::Text("Weight Pruning : cost %u -> %u, demoted BDEF2 %u BDEF4 %u SDEF %u, max error %f",
+		mWeightPruningResult.skinningCostBefore, mWeightPruningResult.skinningCostAfter,
+		mWeightPruningResult.demotedVertexCount[static_cast<int>(PMXVertexWeight::BDEF2)],
+		mWeightPruningResult.demotedVertexCount[static_cast<int>(PMXVertexWeight::BDEF4)],
+		mWeightPruningResult.demotedVertexCount[static_cast<int>(PMXVertexWeight::SDEF)],
+		mWeightPruningResult.maxError);
+
+	ImGui::Text("Proxy Mesh : faces %u -> %u, vertices %u",
+		mProxyMeshResult.faceCount, mProxyMeshResult.proxyFaceCount, mProxyMeshResult.proxyVertexCount);
+
 	int i = 0;
 	for (LoadMaterial& curMat : mLoadedMaterial)
 	{
@@ -301,6 +523,7 @@ void PMXActor::UpdateImGui(Dx12Wrapper& dx)
 			if (ImGui::Checkbox(("Visible ## mat" + matIndexString).c_str(), &visible) == true)
 			{
 				curMat.visible = visible;
+				UpdateVisibleVertexRuns();
 			}
 
 			if (ImGui::ColorEdit4(("Diffuse ## mat" + matIndexString).c_str(), diffuseColor) == true)
@@ -335,6 +558,13 @@ void PMXActor::UpdateImGui(Dx12Wrapper& dx)
 			{
 				curMat.isTransparent = isTransparent;
 			}
+
+			bool dualQuaternionSkinning = curMat.dualQuaternionSkinning;
+			if (ImGui::Checkbox(("DualQuaternion ## mat" + matIndexString).c_str(), &dualQuaternionSkinning) == true)
+			{
+				curMat.dualQuaternionSkinning = dualQuaternionSkinning;
+				UpdateSkinningBuckets();
+			}
 		}
 
 		++i;
@@ -351,10 +581,11 @@ HRESULT PMXActor::CreateVbAndIb(Dx12Wrapper& dx)
 
 	D3D12_RESOURCE_DESC resdesc = {};
 
-	size_t vertexSize = sizeof(UploadVertex);
+	size_t vertexSize = sizeof(QuantizedVertex);
+	size_t vertexCount = mPmxFileData.vertices.size();
 
 	resdesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-	resdesc.Width = mUploadVertices.size() * vertexSize;
+	resdesc.Width = vertexCount * vertexSize * frame_buffer_slots;
 	resdesc.Height = 1;
 	resdesc.DepthOrArraySize = 1;
 	resdesc.MipLevels = 1;
@@ -375,12 +606,24 @@ HRESULT PMXActor::CreateVbAndIb(Dx12Wrapper& dx)
 		return result;
 	}
 
-	std::copy(std::begin(mUploadVertices), std::end(mUploadVertices), mMappedVertex);
-	//mVertexBuffer->Unmap(0, nullptr);
+	// Bind pose bounds, the palette is still identity here
+	UpdateVertexQuantization();
+
+	// One slot per frame in flight, kept mapped so skinning writes straight into it
+	for (unsigned int slot = 0; slot < frame_buffer_slots; slot++)
+	{
+		QuantizedVertex* slotVertex = mMappedVertex + slot * vertexCount;
+		for (size_t index = 0; index < vertexCount; ++index)
+		{
+			const PMXVertex& currentPmxVertex = mPmxFileData.vertices[index];
+			SkinningKernel::EncodeVertex(&currentPmxVertex.position.x, &currentPmxVertex.normal.x, mSkinningStream.uv[index], mVertexQuantization, slotVertex[index]);
+		}
 
-	mVertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress();
-	mVertexBufferView.SizeInBytes = vertexSize * mUploadVertices.size();
-	mVertexBufferView.StrideInBytes = vertexSize;
+		D3D12_VERTEX_BUFFER_VIEW& vertexBufferView = mVertexBufferViews[slot];
+		vertexBufferView.BufferLocation = mVertexBuffer->GetGPUVirtualAddress() + slot * vertexCount * vertexSize;
+		vertexBufferView.SizeInBytes = vertexSize * vertexCount;
+		vertexBufferView.StrideInBytes = vertexSize;
+	}
 
 	size_t faceSize = sizeof(PMXFace);
 	resdesc.Width = mPmxFileData.faces.size() * faceSize;
@@ -401,6 +644,27 @@ HRESULT PMXActor::CreateVbAndIb(Dx12Wrapper& dx)
 	mIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
 	mIndexBufferView.SizeInBytes = mPmxFileData.faces.size() * faceSize;
 
+	mProxyIndexBufferView = mIndexBufferView;
+
+	if (mProxyFaces.empty() == false)
+	{
+		resdesc.Width = mProxyFaces.size() * faceSize;
+
+		result = dx.Device()->CreateCommittedResource(&heapprop, D3D12_HEAP_FLAG_NONE, &resdesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(mProxyIndexBuffer.ReleaseAndGetAddressOf()));
+
+		if (FAILED(result)) {
+			assert(SUCCEEDED(result));
+			return result;
+		}
+
+		mProxyIndexBuffer->Map(0, nullptr, (void**)&mappedFace);
+		std::copy(std::begin(mProxyFaces), std::end(mProxyFaces), mappedFace);
+		mProxyIndexBuffer->Unmap(0, nullptr);
+
+		mProxyIndexBufferView.BufferLocation = mProxyIndexBuffer->GetGPUVirtualAddress();
+		mProxyIndexBufferView.SizeInBytes = mProxyFaces.size() * faceSize;
+	}
+
 	const size_t materialNum = mPmxFileData.materials.size();
 	mTextureResources.resize(materialNum);
 	mToonResources.resize(materialNum);
@@ -453,21 +717,23 @@ HRESULT PMXActor::CreateVbAndIb(Dx12Wrapper& dx)
 	return S_OK;
 }
 
-HRESULT PMXActor::CreateTransformView(Dx12Wrapper& dx)
+HRESULT PMXActor::CreateGpuSkinningBuffers(Dx12Wrapper& dx)
 {
-	mBoneMatrices.resize(mPmxFileData.bones.size());
-	std::fill(mBoneMatrices.begin(), mBoneMatrices.end(), XMMatrixIdentity());
+	unsigned int boneCount = mPmxFileData.bones.size();
+	if (boneCount > maxGpuSkinningBoneCount)
+	{
+		return S_OK;
+	}
 
-	auto buffSize = sizeof(XMMATRIX);
-	buffSize = (buffSize + 0xff) & ~0xff;
+	size_t vertexCount = mPmxFileData.vertices.size();
 
 	auto result = dx.Device()->CreateCommittedResource(
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
 		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(buffSize),
+		&CD3DX12_RESOURCE_DESC::Buffer(vertexCount * sizeof(GpuSkinningVertex)),
 		D3D12_RESOURCE_STATE_GENERIC_READ,
 		nullptr,
-		IID_PPV_ARGS(mTransformBuff.ReleaseAndGetAddressOf())
+		IID_PPV_ARGS(mGpuSkinningVertexBuffer.ReleaseAndGetAddressOf())
 	);
 
 	if (FAILED(result)) {
@@ -475,22 +741,31 @@ HRESULT PMXActor::CreateTransformView(Dx12Wrapper& dx)
 		return result;
 	}
 
-	result = mTransformBuff->Map(0, nullptr, (void**)&mMappedMatrices);
-
+	GpuSkinningVertex* mappedVertex = nullptr;
+	result = mGpuSkinningVertexBuffer->Map(0, nullptr, (void**)&mappedVertex);
 	if (FAILED(result)) {
 		assert(SUCCEEDED(result));
 		return result;
 	}
 
-	mMappedMatrices[0] = mTransform.GetTransformMatrix();
+	for (size_t index = 0; index < vertexCount; ++index)
+	{
+		VertexSkinning::PackGpuVertex(mPmxFileData.vertices[index], mSkinningStream, index, mappedVertex[index]);
+	}
+
+	mGpuSkinningVertexBuffer->Unmap(0, nullptr);
+
+	mGpuSkinningVertexBufferView.BufferLocation = mGpuSkinningVertexBuffer->GetGPUVirtualAddress();
+	mGpuSkinningVertexBufferView.SizeInBytes = vertexCount * sizeof(GpuSkinningVertex);
+	mGpuSkinningVertexBufferView.StrideInBytes = sizeof(GpuSkinningVertex);
 
 	result = dx.Device()->CreateCommittedResource(
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
 		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(buffSize),
+		&CD3DX12_RESOURCE_DESC::Buffer(vertexCount * sizeof(GpuMorphVertex) * frame_buffer_slots),
 		D3D12_RESOURCE_STATE_GENERIC_READ,
 		nullptr,
-		IID_PPV_ARGS(mReflectionTransformBuff.ReleaseAndGetAddressOf())
+		IID_PPV_ARGS(mMorphVertexBuffer.ReleaseAndGetAddressOf())
 	);
 
 	if (FAILED(result)) {
@@ -498,74 +773,67 @@ HRESULT PMXActor::CreateTransformView(Dx12Wrapper& dx)
 		return result;
 	}
 
-	result = mReflectionTransformBuff->Map(0, nullptr, (void**)&mMappedReflectionMatrices);
-
+	result = mMorphVertexBuffer->Map(0, nullptr, (void**)&mMappedMorphVertex);
 	if (FAILED(result)) {
 		assert(SUCCEEDED(result));
 		return result;
 	}
 
-	mMappedReflectionMatrices[0] = mTransform.GetPlanarReflectionsTransform(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
-
-	D3D12_DESCRIPTOR_HEAP_DESC transformDescHeapDesc = {};
+	std::fill(mMappedMorphVertex, mMappedMorphVertex + vertexCount * frame_buffer_slots, GpuMorphVertex{});
 
-	transformDescHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	transformDescHeapDesc.NodeMask = 0;
-	transformDescHeapDesc.NumDescriptors = 2;
-	transformDescHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	result = dx.Device()->CreateDescriptorHeap(&transformDescHeapDesc, IID_PPV_ARGS(mTransformHeap.ReleaseAndGetAddressOf()));
-	if (FAILED(result)) {
-		assert(SUCCEEDED(result));
-		return result;
+	for (unsigned int slot = 0; slot < frame_buffer_slots; slot++)
+	{
+		D3D12_VERTEX_BUFFER_VIEW& morphVertexBufferView = mMorphVertexBufferViews[slot];
+		morphVertexBufferView.BufferLocation = mMorphVertexBuffer->GetGPUVirtualAddress() + slot * vertexCount * sizeof(GpuMorphVertex);
+		morphVertexBufferView.SizeInBytes = vertexCount * sizeof(GpuMorphVertex);
+		morphVertexBufferView.StrideInBytes = sizeof(GpuMorphVertex);
 	}
 
-	D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-	cbvDesc.BufferLocation = mTransformBuff->GetGPUVirtualAddress();
-	cbvDesc.SizeInBytes = buffSize;
-
-	auto handle = mTransformHeap->GetCPUDescriptorHandleForHeapStart();
-	auto incSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-	dx.Device()->CreateConstantBufferView(&cbvDesc, handle);
-
-	cbvDesc.BufferLocation = mReflectionTransformBuff->GetGPUVirtualAddress();
-	handle.ptr+= incSize;
-
-	dx.Device()->CreateConstantBufferView(&cbvDesc, handle);
+	mBonePaletteSlotSize = (std::max)(boneCount, 1u) * gpuSkinningPaletteStride * sizeof(float);
+	mBonePaletteSlotSize = (mBonePaletteSlotSize + 0xff) & ~0xff;
 
-	return S_OK;
-}
-
-HRESULT PMXActor::CreateMaterialData(Dx12Wrapper& dx)
-{
-	int materialBufferSize = sizeof(MaterialForShader);
-	materialBufferSize = (materialBufferSize + 0xff) & ~0xff;
-
-	auto result = dx.Device()->CreateCommittedResource(
+	result = dx.Device()->CreateCommittedResource(
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
 		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(materialBufferSize * mPmxFileData.materials.size()),
+		&CD3DX12_RESOURCE_DESC::Buffer(mBonePaletteSlotSize * frame_buffer_slots),
 		D3D12_RESOURCE_STATE_GENERIC_READ,
 		nullptr,
-		IID_PPV_ARGS(mMaterialBuff.ReleaseAndGetAddressOf())
+		IID_PPV_ARGS(mBonePaletteBuffer.ReleaseAndGetAddressOf())
 	);
-	if (FAILED(result))
-	{
+
+	if (FAILED(result)) {
 		assert(SUCCEEDED(result));
 		return result;
 	}
 
-	result = mMaterialBuff->Map(0, nullptr, (void**)&mMappedMaterial);
-	if (FAILED(result))
-	{
+	result = mBonePaletteBuffer->Map(0, nullptr, (void**)&mMappedBonePalette);
+	if (FAILED(result)) {
 		assert(SUCCEEDED(result));
 		return result;
 	}
 
+	return S_OK;
+}
+
+void PMXActor::InitTransforms()
+{
+	for (unsigned int slot = 0; slot < frame_buffer_slots; slot++)
+	{
+		mTransforms[slot].world = mTransform.GetTransformMatrix();
+		mReflectionTransforms[slot].world = mTransform.GetPlanarReflectionsTransform(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	}
+
+	WriteVertexQuantization();
+}
+
+HRESULT PMXActor::CreateMaterialData(Dx12Wrapper& dx)
+{
 	mLoadedMaterial.resize(mPmxFileData.materials.size());
 
-	char* mappedMaterialPtr = mMappedMaterial;
+	for (std::vector<MaterialForShader>& materials : mMaterials)
+	{
+		materials.resize(mPmxFileData.materials.size());
+	}
 
 	int materialIndex = 0;
 	for (const auto& material : mPmxFileData.materials)
@@ -577,59 +845,51 @@ HRESULT PMXActor::CreateMaterialData(Dx12Wrapper& dx)
 		mLoadedMaterial[materialIndex].specularPower = material.specularPower;
 		mLoadedMaterial[materialIndex].ambient = material.ambient;
 		mLoadedMaterial[materialIndex].isTransparent = false;
-		materialIndex++;
+		mLoadedMaterial[materialIndex].dualQuaternionSkinning = false;
 
-		MaterialForShader* uploadMat = reinterpret_cast<MaterialForShader*>(mappedMaterialPtr);
-		uploadMat->diffuse = material.diffuse;
-		uploadMat->specular = material.specular;
-		uploadMat->specularPower = material.specularPower;
-		uploadMat->ambient = material.ambient;
+		for (std::vector<MaterialForShader>& materials : mMaterials)
+		{
+			MaterialForShader& uploadMat = materials[materialIndex];
+			uploadMat.diffuse = material.diffuse;
+			uploadMat.specular = material.specular;
+			uploadMat.specularPower = material.specularPower;
+			uploadMat.ambient = material.ambient;
+		}
 
-		mappedMaterialPtr += materialBufferSize;
+		materialIndex++;
 	}
 
-	//mMaterialBuff->Unmap(0, nullptr);
+	for (PMXRenderSnapshot& snapshot : mRenderSnapshots)
+	{
+		snapshot.materialVisible.assign(mLoadedMaterial.size(), true);
+	}
 
 	return S_OK;
 }
 
 HRESULT PMXActor::CreateMaterialAndTextureView(Dx12Wrapper& dx)
 {
-	D3D12_DESCRIPTOR_HEAP_DESC matDescHeapDesc = {};
-	matDescHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	matDescHeapDesc.NodeMask = 0;
-	matDescHeapDesc.NumDescriptors = mPmxFileData.materials.size() * 4;
-	matDescHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	auto result = dx.Device()->CreateDescriptorHeap(&matDescHeapDesc, IID_PPV_ARGS(mMaterialHeap.ReleaseAndGetAddressOf()));
-	if (FAILED(result)) {
-		assert(SUCCEEDED(result));
-		return result;
+	mMaterialDescriptors = dx.AllocateDescriptors(static_cast<unsigned int>(mPmxFileData.materials.size() * 3));
+	if (mMaterialDescriptors.IsValid() == false)
+	{
+		return E_OUTOFMEMORY;
 	}
 
-	auto materialBuffSize = sizeof(MaterialForShader);
-	materialBuffSize = (materialBuffSize + 0xff) & ~0xff;
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC matCBVDesc = {};
-	matCBVDesc.BufferLocation = mMaterialBuff->GetGPUVirtualAddress();
-	matCBVDesc.SizeInBytes = materialBuffSize;
+	const DescriptorHeap& descriptorHeap = dx.GetDescriptorHeap();
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 	srvDesc.Texture2D.MipLevels = 1;
 
-	auto matDescHeapH = mMaterialHeap->GetCPUDescriptorHandleForHeapStart();
+	auto matDescHeapH = descriptorHeap.GetStagingHandle(mMaterialDescriptors.index);
 	auto incSize = dx.Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	for (int i = 0; i < mPmxFileData.materials.size(); ++i)
+	// Texture, toon and sphere texture of each material
+	for (int materialIndex = 0; materialIndex < mPmxFileData.materials.size(); ++materialIndex)
 	{
-		dx.Device()->CreateConstantBufferView(&matCBVDesc, matDescHeapH);
-
-		matDescHeapH.ptr += incSize;
-		matCBVDesc.BufferLocation += materialBuffSize;
 
-		if (mTextureResources[i] == nullptr)
+		if (mTextureResources[materialIndex] == nullptr)
 		{
 			ComPtr<ID3D12Resource> whiteTexture = dx.GetWhiteTexture();
 			srvDesc.Format = whiteTexture->GetDesc().Format;
@@ -637,13 +897,13 @@ HRESULT PMXActor::CreateMaterialAndTextureView(Dx12Wrapper& dx)
 		}
 		else
 		{
-			srvDesc.Format = mTextureResources[i]->GetDesc().Format;
-			dx.Device()->CreateShaderResourceView(mTextureResources[i].Get(),&srvDesc,matDescHeapH);
+			srvDesc.Format = mTextureResources[materialIndex]->GetDesc().Format;
+			dx.Device()->CreateShaderResourceView(mTextureResources[materialIndex].Get(),&srvDesc,matDescHeapH);
 		}
 
 		matDescHeapH.ptr += incSize;
 
-		if (mToonResources[i] == nullptr)
+		if (mToonResources[materialIndex] == nullptr)
 		{
 			ComPtr<ID3D12Resource> gradTexture = dx.GetWhiteTexture();
 			srvDesc.Format = gradTexture->GetDesc().Format;
@@ -651,13 +911,13 @@ HRESULT PMXActor::CreateMaterialAndTextureView(Dx12Wrapper& dx)
 		}
 		else
 		{
-			srvDesc.Format = mToonResources[i]->GetDesc().Format;
-			dx.Device()->CreateShaderResourceView(mToonResources[i].Get(), &srvDesc, matDescHeapH);
+			srvDesc.Format = mToonResources[materialIndex]->GetDesc().Format;
+			dx.Device()->CreateShaderResourceView(mToonResources[materialIndex].Get(), &srvDesc, matDescHeapH);
 		}
 
 		matDescHeapH.ptr += incSize;
 
-		if (mSphereTextureResources[i] == nullptr)
+		if (mSphereTextureResources[materialIndex] == nullptr)
 		{
 			ComPtr<ID3D12Resource> whiteTexture = dx.GetWhiteTexture();
 			srvDesc.Format = whiteTexture->GetDesc().Format;
@@ -665,29 +925,16 @@ HRESULT PMXActor::CreateMaterialAndTextureView(Dx12Wrapper& dx)
 		}
 		else
 		{
-			srvDesc.Format = mSphereTextureResources[i]->GetDesc().Format;
-			dx.Device()->CreateShaderResourceView(mSphereTextureResources[i].Get(), &srvDesc, matDescHeapH);
+			srvDesc.Format = mSphereTextureResources[materialIndex]->GetDesc().Format;
+			dx.Device()->CreateShaderResourceView(mSphereTextureResources[materialIndex].Get(), &srvDesc, matDescHeapH);
 		}
 
 		matDescHeapH.ptr += incSize;
 	}
 
-	return result;
-}
-
-void PMXActor::LoadVertexData(const std::vector<PMXVertex>& vertices)
-{
-	mUploadVertices.resize(vertices.size());
-
-	for (int index = 0; index < vertices.size(); ++index)
-	{
-		const PMXVertex& currentPmxVertex = vertices[index];
-		UploadVertex& currentUploadVertex = mUploadVertices[index];
+	descriptorHeap.Commit(mMaterialDescriptors);
 
-		currentUploadVertex.position = currentPmxVertex.position;
-		currentUploadVertex.normal = currentPmxVertex.normal;
-		currentUploadVertex.uv = currentPmxVertex.uv;
-	}
+	return S_OK;
 }
 
 void PMXActor::InitAnimation(VMDFileData& vmdFileData)
@@ -796,187 +1043,971 @@ void PMXActor::InitPhysics(const PMXFileData& pmxFileData)
 	PhysicsManager::ActivePhysics(true);
 }
 
-void PMXActor::InitParallelVertexSkinningSetting()
+void PMXActor::PruneVertexWeights()
 {
-	unsigned int threadCount = std::thread::hardware_concurrency() * 2 + 1;
-	unsigned int divNum = threadCount - 1;
-
-	mSkinningRanges.resize(threadCount);
-	mParallelUpdateFutures.resize(threadCount);
+	mWeightPruningResult = WeightPruningResult();
 
-	unsigned int divVertexCount = mPmxFileData.vertices.size() / divNum;
-	unsigned int remainder = mPmxFileData.vertices.size() % divNum;
+	const std::vector<PMXBone>& bones = mPmxFileData.bones;
+	int boneCount = static_cast<int>(bones.size());
+	double errorSum = 0.0;
 
-	int startIndex = 0;
-	for (int i = 0; i < mSkinningRanges.size() - 1; i++)
+	for (PMXVertex& vertex : mPmxFileData.vertices)
 	{
-		mSkinningRanges[i].startIndex = startIndex;
-		mSkinningRanges[i].vertexCount = divVertexCount;
+		mWeightPruningResult.skinningCostBefore += GetSkinningCost(vertex.weightType);
 
-		startIndex += mSkinningRanges[i].vertexCount;
-	}
+		if (mWeightPruningSetting.enable == false || vertex.weightType == PMXVertexWeight::BDEF1 || vertex.weightType == PMXVertexWeight::QDEF)
+		{
+			mWeightPruningResult.skinningCostAfter += GetSkinningCost(vertex.weightType);
+			continue;
+		}
 
-	mSkinningRanges[mSkinningRanges.size() - 1].startIndex = startIndex;
-	mSkinningRanges[mSkinningRanges.size() - 1].vertexCount = remainder;
-}
+		// Influences as the skinning kernels blend them, BDEF2 and SDEF store only the first weight
+		unsigned int influenceCount = VertexSkinning::GetInfluenceCount(vertex.weightType);
+		int boneIndices[4] = {};
+		float boneWeights[4] = {};
+		for (unsigned int k = 0; k < influenceCount; k++)
+		{
+			boneIndices[k] = vertex.boneIndices[k];
+			boneWeights[k] = vertex.boneWeights[k];
+		}
+		if (influenceCount == 2)
+		{
+			boneWeights[1] = 1.0f - boneWeights[0];
+		}
 
-void PMXActor::VertexSkinning()
-{
-	const int futureCount = mParallelUpdateFutures.size();
+		// Unused slots often hold bone -1 with weight 0
+		bool isValid = true;
+		for (unsigned int k = 0; k < influenceCount; k++)
+		{
+			isValid &= (boneIndices[k] >= 0 && boneIndices[k] < boneCount) || boneWeights[k] == 0.0f;
+		}
 
-	for (int i = 0; i < futureCount; i++)
-	{
-		const SkinningRange& currentRange = mSkinningRanges[i];
-		mParallelUpdateFutures[i] = std::async(std::launch::async, [this, currentRange]()
+		// Merge repeated bones, then drop small influences keeping at least the largest
+		int keptIndices[4] = {};
+		float keptWeights[4] = {};
+		unsigned int keptCount = 0;
+		for (unsigned int k = 0; isValid == true && k < influenceCount; k++)
+		{
+			if (boneIndices[k] < 0 || boneIndices[k] >= boneCount)
 			{
-				this->VertexSkinningByRange(currentRange);
-			});
-	}
+				continue;
+			}
 
-	for (const std::future<void>& future : mParallelUpdateFutures)
-	{
-		future.wait();
-	}
-}
+			unsigned int kept = 0;
+			while (kept < keptCount && keptIndices[kept] != boneIndices[k])
+			{
+				kept++;
+			}
 
-void PMXActor::VertexSkinningByRange(const SkinningRange& range)
-{
-	for (unsigned int i = range.startIndex; i < range.startIndex + range.vertexCount; ++i)
-	{
-		const PMXVertex& currentVertexData = mPmxFileData.vertices[i];
-		XMVECTOR position = XMLoadFloat3(&currentVertexData.position);
-		XMVECTOR morphPosition = XMLoadFloat3(&mMorphManager.GetMorphVertexPosition(i));
+			if (kept == keptCount)
+			{
+				keptIndices[keptCount] = boneIndices[k];
+				keptWeights[keptCount] = 0.0f;
+				keptCount++;
+			}
+			keptWeights[kept] += boneWeights[k];
+		}
 
-		switch (currentVertexData.weightType)
-		{
-		case PMXVertexWeight::BDEF1:
+		for (unsigned int k = 1; k < keptCount; k++)
 		{
-			BoneNode* bone0 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[0]);
-			XMMATRIX m0 = XMMatrixMultiply(bone0->GetInitInverseTransform(), bone0->GetGlobalTransform());
-			position += morphPosition;
-			position = XMVector3Transform(position, m0);
-			break;
+			for (unsigned int j = k; j > 0 && keptWeights[j] > keptWeights[j - 1]; j--)
+			{
+				std::swap(keptWeights[j], keptWeights[j - 1]);
+				std::swap(keptIndices[j], keptIndices[j - 1]);
+			}
 		}
-		case PMXVertexWeight::BDEF2:
-		{
-			float weight0 = currentVertexData.boneWeights[0];
-			float weight1 = 1.0f - weight0;
 
-			BoneNode* bone0 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[0]);
-			BoneNode* bone1 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[1]);
+		unsigned int prunedCount = keptCount;
+		while (prunedCount > 1 && keptWeights[prunedCount - 1] <= mWeightPruningSetting.threshold)
+		{
+			prunedCount--;
+		}
 
-			XMMATRIX m0 = XMMatrixMultiply(bone0->GetInitInverseTransform(), bone0->GetGlobalTransform());
-			XMMATRIX m1 = XMMatrixMultiply(bone1->GetInitInverseTransform(), bone1->GetGlobalTransform());
+		// Untouched vertices keep their weights exactly, SDEF only reduces to a single bone
+		if (prunedCount == 0 || prunedCount == influenceCount || (vertex.weightType == PMXVertexWeight::SDEF && prunedCount > 1))
+		{
+			mWeightPruningResult.skinningCostAfter += GetSkinningCost(vertex.weightType);
+			continue;
+		}
 
-			XMMATRIX mat = m0 * weight0 + m1 * weight1;
-			position += morphPosition;
-			position = XMVector3Transform(position, mat);
-			break;
+		float weightSum = 0.0f;
+		float droppedWeight = 0.0f;
+		for (unsigned int k = 0; k < keptCount; k++)
+		{
+			if (k < prunedCount)
+			{
+				weightSum += keptWeights[k];
+			}
+			else
+			{
+				droppedWeight += keptWeights[k];
+			}
 		}
-		case PMXVertexWeight::BDEF4:
+
+		// Dropping only zero weights and merging repeated bones leaves the weights as they are, but BDEF1 and BDEF2
+		// imply a sum of one, so a vertex whose weights do not sum to one cannot be demoted without changing it
+		if (droppedWeight == 0.0f && prunedCount <= 2 && std::abs(weightSum - 1.0f) > 1e-5f)
 		{
-			float weight0 = currentVertexData.boneWeights[0];
-			float weight1 = currentVertexData.boneWeights[1];
-			float weight2 = currentVertexData.boneWeights[2];
-			float weight3 = currentVertexData.boneWeights[3];
+			mWeightPruningResult.skinningCostAfter += GetSkinningCost(vertex.weightType);
+			continue;
+		}
 
-			BoneNode* bone0 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[0]);
-			BoneNode* bone1 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[1]);
-			BoneNode* bone2 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[2]);
-			BoneNode* bone3 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[3]);
+		mWeightPruningResult.prunedInfluenceCount += influenceCount - prunedCount;
+		mWeightPruningResult.prunedVertexCount++;
 
-			XMMATRIX m0 = XMMatrixMultiply(bone0->GetInitInverseTransform(), bone0->GetGlobalTransform());
-			XMMATRIX m1 = XMMatrixMultiply(bone1->GetInitInverseTransform(), bone1->GetGlobalTransform());
-			XMMATRIX m2 = XMMatrixMultiply(bone2->GetInitInverseTransform(), bone2->GetGlobalTransform());
-			XMMATRIX m3 = XMMatrixMultiply(bone3->GetInitInverseTransform(), bone3->GetGlobalTransform());
+		// Only a real prune renormalizes
+		float weightScale = droppedWeight > 0.0f && weightSum > 0.0f ? 1.0f / weightSum : 1.0f;
+		for (unsigned int k = 0; k < 4; k++)
+		{
+			keptWeights[k] = k < prunedCount ? keptWeights[k] * weightScale : 0.0f;
+		}
+		if (weightSum <= 0.0f)
+		{
+			keptWeights[0] = 1.0f;
+		}
 
-			XMMATRIX mat = m0 * weight0 + m1 * weight1 + m2 * weight2 + m3 * weight3;
-			position += morphPosition;
-			position = XMVector3Transform(position, mat);
-			break;
+		XMVECTOR position = XMLoadFloat3(&vertex.position);
+		XMVECTOR original = BlendByTestPose(bones, boneIndices, boneWeights, influenceCount, position);
+		XMVECTOR pruned = BlendByTestPose(bones, keptIndices, keptWeights, prunedCount, position);
+		float error = XMVectorGetX(XMVector3Length(XMVectorSubtract(original, pruned)));
+		mWeightPruningResult.maxError = (std::max)(mWeightPruningResult.maxError, error);
+		errorSum += error;
+
+		PMXVertexWeight weightType = vertex.weightType;
+		if (prunedCount == 1)
+		{
+			weightType = PMXVertexWeight::BDEF1;
 		}
-		case PMXVertexWeight::SDEF:
+		else if (prunedCount == 2)
 		{
-			float w0 = currentVertexData.boneWeights[0];
-			float w1 = 1.0f - w0;
+			weightType = PMXVertexWeight::BDEF2;
+		}
 
-			XMVECTOR sdefc = XMLoadFloat3(&currentVertexData.sdefC);
-			XMVECTOR sdefr0 = XMLoadFloat3(&currentVertexData.sdefR0);
-			XMVECTOR sdefr1 = XMLoadFloat3(&currentVertexData.sdefR1);
+		if (weightType != vertex.weightType)
+		{
+			mWeightPruningResult.demotedVertexCount[static_cast<int>(vertex.weightType)]++;
+		}
 
-				//rw = sdefr0 * w0 + sdefr1 * w1
-				//r0 = sdefc + sdefr0 - rw
-				//r1 = sdefc + sdefr1 - rw
+		vertex.weightType = weightType;
+		for (unsigned int k = 0; k < 4; k++)
+		{
+			vertex.boneIndices[k] = k < prunedCount ? keptIndices[k] : 0;
+			vertex.boneWeights[k] = keptWeights[k];
+		}
 
-			XMVECTOR rw = XMVectorAdd(sdefr0 * w0, sdefr1 * w1);
-			XMVECTOR r0 = XMVectorSubtract(XMVectorAdd(sdefc, sdefr0), rw);
-			XMVECTOR r1 = XMVectorSubtract(XMVectorAdd(sdefc, sdefr1), rw);
+		mWeightPruningResult.skinningCostAfter += GetSkinningCost(vertex.weightType);
+	}
 
-				// cr0 = (sdefc + r0) * 0.5f
-				// cr1 = (sdefc + r1) * 0.5f
+	if (mWeightPruningResult.prunedVertexCount > 0)
+	{
+		mWeightPruningResult.meanError = static_cast<float>(errorSum / mWeightPruningResult.prunedVertexCount);
+	}
 
-			XMVECTOR cr0 = XMVectorAdd(sdefc, r0) * 0.5f;
-			XMVECTOR cr1 = XMVectorAdd(sdefc, r1) * 0.5f;
+	std::string message = "Weight Pruning : " + std::to_string(mWeightPruningResult.prunedInfluenceCount) + " influences dropped from "
+		+ std::to_string(mWeightPruningResult.prunedVertexCount) + " vertices, demoted BDEF2 "
+		+ std::to_string(mWeightPruningResult.demotedVertexCount[static_cast<int>(PMXVertexWeight::BDEF2)]) + ", BDEF4 "
+		+ std::to_string(mWeightPruningResult.demotedVertexCount[static_cast<int>(PMXVertexWeight::BDEF4)]) + ", SDEF "
+		+ std::to_string(mWeightPruningResult.demotedVertexCount[static_cast<int>(PMXVertexWeight::SDEF)]) + ", skinning cost "
+		+ std::to_string(mWeightPruningResult.skinningCostBefore) + " -> " + std::to_string(mWeightPruningResult.skinningCostAfter)
+		+ ", max error " + std::to_string(mWeightPruningResult.maxError) + ", mean error " + std::to_string(mWeightPruningResult.meanError) + "\n";
+	OutputDebugStringA(message.c_str());
+}
 
-			BoneNode* bone0 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[0]);
-			BoneNode* bone1 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[1]);
+void PMXActor::SortVerticesByWeightType()
+{
+	std::vector<PMXVertex>& vertices = mPmxFileData.vertices;
 
-			XMVECTOR q0 = XMQuaternionRotationMatrix(bone0->GetGlobalTransform());
-			XMVECTOR q1 = XMQuaternionRotationMatrix(bone1->GetGlobalTransform());
+	std::vector<unsigned int> order(vertices.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
 
-			XMMATRIX m0 = XMMatrixMultiply(bone0->GetInitInverseTransform(), bone0->GetGlobalTransform());
-			XMMATRIX m1 = XMMatrixMultiply(bone1->GetInitInverseTransform(), bone1->GetGlobalTransform());
+	std::stable_sort(order.begin(), order.end(),
+		[&vertices](unsigned int left, unsigned int right)
+		{
+			return vertices[left].weightType < vertices[right].weightType;
+		});
 
-			XMMATRIX rotation = XMMatrixRotationQuaternion(XMQuaternionSlerp(q0, q1, w1));
+	std::vector<unsigned int> newIndexByOld(vertices.size());
+	std::vector<PMXVertex> sortedVertices(vertices.size());
+	for (unsigned int newIndex = 0; newIndex < order.size(); newIndex++)
+	{
+		newIndexByOld[order[newIndex]] = newIndex;
+		sortedVertices[newIndex] = vertices[order[newIndex]];
+	}
+	vertices.swap(sortedVertices);
 
-			position += morphPosition;
+	auto remap = [&newIndexByOld](unsigned int& vertexIndex)
+	{
+		if (vertexIndex < newIndexByOld.size())
+		{
+			vertexIndex = newIndexByOld[vertexIndex];
+		}
+	};
 
-				// XMVector3Transform(position - sdefc, rotation) + XMVector3Transform(cr0, m0) * w0 + XMVector3Transform(cr1, m1) * w1
+	for (PMXFace& face : mPmxFileData.faces)
+	{
+		for (int& vertexIndex : face.vertices)
+		{
+			vertexIndex = newIndexByOld[vertexIndex];
+		}
+	}
 
-			XMVECTOR a = XMVector3Transform(XMVectorSubtract(position, sdefc), rotation);
-			XMVECTOR b = XMVector3Transform(cr0, m0) * w0;
-			XMVECTOR c = XMVector3Transform(cr1, m1) * w1;
+	for (PMXMorph& morph : mPmxFileData.morphs)
+	{
+		for (PMXMorph::PositionMorph& data : morph.positionMorph)
+		{
+			remap(data.vertexIndex);
+		}
 
-			position = XMVectorAdd(XMVectorAdd(a, b), c);
-			XMVECTOR normal = XMLoadFloat3(&currentVertexData.normal);
-			normal = XMVector3Transform(normal, rotation);
-			XMStoreFloat3(&mUploadVertices[i].normal, normal);
-			break;
+		for (PMXMorph::UVMorph& data : morph.uvMorph)
+		{
+			remap(data.vertexIndex);
 		}
-		case PMXVertexWeight::QDEF:
+	}
+
+	for (PMXSoftBody& softBody : mPmxFileData.softBodies)
+	{
+		for (PMXSoftBody::AnchorRigidBody& anchor : softBody.anchorRigidBodies)
 		{
-			BoneNode* bone0 = mNodeManager.GetBoneNodeByIndex(currentVertexData.boneIndices[0]);
-			XMMATRIX m0 = XMMatrixMultiply(bone0->GetInitInverseTransform(), bone0->GetGlobalTransform());
-			position += morphPosition;
+			remap(anchor.vertexIndex);
+		}
 
-			position = XMVector3Transform(position, m0);
+		for (unsigned int& vertexIndex : softBody.pinVertexIndices)
+		{
+			remap(vertexIndex);
+		}
+	}
 
-			break;
+	UpdateSkinningBuckets();
+}
+
+void PMXActor::UpdateSkinningBuckets()
+{
+	const std::vector<PMXVertex>& vertices = mPmxFileData.vertices;
+	std::vector<bool> isDualQuaternion(vertices.size(), mSkinningMode == SkinningMode::DualQuaternion);
+
+	if (mSkinningMode != SkinningMode::DualQuaternion)
+	{
+		unsigned int indexOffset = 0;
+		for (unsigned int materialIndex = 0; materialIndex < mLoadedMaterial.size(); materialIndex++)
+		{
+			unsigned int numFaceVertices = mPmxFileData.materials[materialIndex].numFaceVertices;
+
+			if (mLoadedMaterial[materialIndex].dualQuaternionSkinning == true)
+			{
+				for (unsigned int index = indexOffset; index < indexOffset + numFaceVertices; index++)
+				{
+					isDualQuaternion[mPmxFileData.faces[index / 3].vertices[index % 3]] = true;
+				}
+			}
+
+			indexOffset += numFaceVertices;
+		}
+	}
+
+	mSkinningBuckets.clear();
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		PMXVertexWeight weightType = vertices[i].weightType;
+		bool dualQuaternion = isDualQuaternion[i] == true && VertexSkinning::GetInfluenceCount(weightType) > 1;
+
+		if (mSkinningBuckets.empty() == true || mSkinningBuckets.back().weightType != weightType || mSkinningBuckets.back().dualQuaternion != dualQuaternion)
+		{
+			mSkinningBuckets.push_back(SkinningBucket{ weightType, dualQuaternion, i, 0 });
 		}
+
+		mSkinningBuckets.back().vertexCount++;
+	}
+}
+
+void PMXActor::SetSkinningMode(SkinningMode mode)
+{
+	if (mSkinningMode == mode)
+	{
+		return;
+	}
+
+	if (mode == SkinningMode::Gpu && mBonePaletteBuffer == nullptr)
+	{
+		OutputDebugStringA(("GPU Skinning needs at most " + std::to_string(maxGpuSkinningBoneCount) + " bones\n").c_str());
+		return;
+	}
+
+	mSkinningMode = mode;
+	UpdateSkinningBuckets();
+}
+
+void PMXActor::InitSkinningStream()
+{
+	const std::vector<PMXVertex>& vertices = mPmxFileData.vertices;
+	VertexSkinning::FillStream(vertices, mSkinningStream);
+
+	mSdefStartIndex = 0;
+	mSdefVertices.clear();
+
+	auto sdefRange = std::equal_range(vertices.begin(), vertices.end(), PMXVertexWeight::SDEF, VertexWeightLess());
+	if (sdefRange.first != sdefRange.second)
+	{
+		mSdefStartIndex = static_cast<unsigned int>(sdefRange.first - vertices.begin());
+		mSdefVertices.resize(sdefRange.second - sdefRange.first);
+
+		for (unsigned int i = 0; i < mSdefVertices.size(); i++)
+		{
+			mSdefVertices[i] = VertexSkinning::CreateSdefData(vertices[mSdefStartIndex + i]);
+		}
+	}
+
+	mBoneMatrices.resize(mPmxFileData.bones.size());
+	std::fill(mBoneMatrices.begin(), mBoneMatrices.end(), XMMatrixIdentity());
+	mSkinningPalette.resize(mPmxFileData.bones.size() * skinningPaletteStride);
+	mBoneRotations.resize(mPmxFileData.bones.size());
+	mBoneDualQuaternions.resize(mPmxFileData.bones.size());
+	mSkinningKernelType = SkinningKernel::DetectKernelType();
+}
+
+void PMXActor::InitSkinningBounds()
+{
+	const std::vector<PMXVertex>& vertices = mPmxFileData.vertices;
+	unsigned int boneCount = static_cast<unsigned int>(mPmxFileData.bones.size());
+
+	// Farthest all position morphs together can push each vertex
+	std::vector<XMFLOAT3> morphReach(vertices.size(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	for (const PMXMorph& morph : mPmxFileData.morphs)
+	{
+		for (const PMXMorph::PositionMorph& data : morph.positionMorph)
+		{
+			if (data.vertexIndex >= vertices.size())
+			{
+				continue;
+			}
+
+			XMFLOAT3& reach = morphReach[data.vertexIndex];
+			reach.x += std::abs(data.position.x);
+			reach.y += std::abs(data.position.y);
+			reach.z += std::abs(data.position.z);
+		}
+	}
+
+	std::vector<XMVECTOR> boundsMin(boneCount, XMVectorReplicate(FLT_MAX));
+	std::vector<XMVECTOR> boundsMax(boneCount, XMVectorReplicate(-FLT_MAX));
+
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		const PMXVertex& vertex = vertices[i];
+		XMVECTOR position = XMLoadFloat3(&vertex.position);
+		XMVECTOR reach = XMLoadFloat3(&morphReach[i]);
+
+		unsigned int influenceCount = VertexSkinning::GetInfluenceCount(vertex.weightType);
+		for (unsigned int k = 0; k < influenceCount; k++)
+		{
+			int boneIndex = vertex.boneIndices[k];
+			if (boneIndex < 0 || boneIndex >= static_cast<int>(boneCount))
+			{
+				continue;
+			}
+
+			boundsMin[boneIndex] = XMVectorMin(boundsMin[boneIndex], XMVectorSubtract(position, reach));
+			boundsMax[boneIndex] = XMVectorMax(boundsMax[boneIndex], XMVectorAdd(position, reach));
+		}
+	}
+
+	mBoneBounds.resize(boneCount);
+	for (unsigned int boneIndex = 0; boneIndex < boneCount; boneIndex++)
+	{
+		BoneBounds& bounds = mBoneBounds[boneIndex];
+		if (XMVector3Greater(boundsMin[boneIndex], boundsMax[boneIndex]) == true)
+		{
+			bounds.center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			bounds.extent = XMFLOAT3(-1.0f, -1.0f, -1.0f);
+			continue;
+		}
+
+		XMStoreFloat3(&bounds.center, XMVectorScale(XMVectorAdd(boundsMin[boneIndex], boundsMax[boneIndex]), 0.5f));
+		XMStoreFloat3(&bounds.extent, XMVectorScale(XMVectorSubtract(boundsMax[boneIndex], boundsMin[boneIndex]), 0.5f));
+	}
+}
+
+void PMXActor::InitMaterialVertices()
+{
+	mMaterialVertices.resize(mPmxFileData.materials.size());
+
+	unsigned int indexOffset = 0;
+	for (unsigned int materialIndex = 0; materialIndex < mPmxFileData.materials.size(); materialIndex++)
+	{
+		unsigned int numFaceVertices = mPmxFileData.materials[materialIndex].numFaceVertices;
+		std::vector<unsigned int>& materialVertices = mMaterialVertices[materialIndex];
+		materialVertices.clear();
+
+		for (unsigned int index = indexOffset; index < indexOffset + numFaceVertices; index++)
+		{
+			materialVertices.push_back(mPmxFileData.faces[index / 3].vertices[index % 3]);
+		}
+
+		std::sort(materialVertices.begin(), materialVertices.end());
+		materialVertices.erase(std::unique(materialVertices.begin(), materialVertices.end()), materialVertices.end());
+
+		indexOffset += numFaceVertices;
+	}
+}
+
+void PMXActor::InitProxyMesh()
+{
+	const std::vector<PMXVertex>& vertices = mPmxFileData.vertices;
+	unsigned int materialCount = static_cast<unsigned int>(mPmxFileData.materials.size());
+
+	mProxyFaces.clear();
+	mProxyIndexCounts.resize(materialCount);
+	mProxyMeshResult = ProxyMeshResult{};
+	mProxyMeshResult.faceCount = static_cast<unsigned int>(mPmxFileData.faces.size());
+
+	if (mProxyMeshSetting.enable == false || vertices.empty() == true)
+	{
+		for (unsigned int materialIndex = 0; materialIndex < materialCount; materialIndex++)
+		{
+			mProxyIndexCounts[materialIndex] = mPmxFileData.materials[materialIndex].numFaceVertices;
+		}
+
+		mProxyMeshResult.proxyFaceCount = mProxyMeshResult.faceCount;
+		mProxyMeshResult.proxyVertexCount = static_cast<unsigned int>(vertices.size());
+		return;
+	}
+
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+	for (const PMXVertex& vertex : vertices)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertex.position);
+		boundsMin = XMVectorMin(boundsMin, position);
+		boundsMax = XMVectorMax(boundsMax, position);
+	}
+
+	XMFLOAT3 size;
+	XMStoreFloat3(&size, XMVectorSubtract(boundsMax, boundsMin));
+	float cellSize = (std::max)({ size.x, size.y, size.z, 0.001f }) / (std::max)(mProxyMeshSetting.gridResolution, 1u);
+	XMVECTOR inverseCellSize = XMVectorReplicate(1.0f / cellSize);
+
+	// Vertices only merge with ones in the same cell driven by the same dominant bone, so joints keep bending apart
+	std::vector<unsigned long long> clusterKeys(vertices.size());
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		unsigned int dominantBone = 0;
+		float dominantWeight = -1.0f;
+		for (unsigned int k = 0; k < VertexSkinning::GetInfluenceCount(vertices[i].weightType); k++)
+		{
+			if (mSkinningStream.boneWeights[k][i] > dominantWeight)
+			{
+				dominantWeight = mSkinningStream.boneWeights[k][i];
+				dominantBone = static_cast<unsigned int>(mSkinningStream.boneIndices[k][i]);
+			}
+		}
+
+		XMFLOAT3 cell;
+		XMStoreFloat3(&cell, XMVectorFloor(XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&vertices[i].position), boundsMin), inverseCellSize)));
+
+		clusterKeys[i] = (static_cast<unsigned long long>(dominantBone) << 48)
+			| (static_cast<unsigned long long>(cell.x) << 32)
+			| (static_cast<unsigned long long>(cell.y) << 16)
+			| static_cast<unsigned long long>(cell.z);
+	}
+
+	std::vector<unsigned int> representatives(vertices.size());
+	std::vector<bool> isRepresentative(vertices.size(), false);
+	std::unordered_map<unsigned long long, unsigned int> clusterIndices;
+	std::vector<XMFLOAT4> clusterSums;
+	std::vector<std::array<int, 3>> materialFaces;
+
+	unsigned int indexOffset = 0;
+	for (unsigned int materialIndex = 0; materialIndex < materialCount; materialIndex++)
+	{
+		const std::vector<unsigned int>& materialVertices = mMaterialVertices[materialIndex];
+		unsigned int numFaceVertices = mPmxFileData.materials[materialIndex].numFaceVertices;
+
+		// Clusters are per material so hidden materials drop their proxy faces too
+		clusterIndices.clear();
+		clusterSums.clear();
+
+		for (unsigned int vertexIndex : materialVertices)
+		{
+			auto cluster = clusterIndices.emplace(clusterKeys[vertexIndex], static_cast<unsigned int>(clusterSums.size()));
+			if (cluster.second == true)
+			{
+				clusterSums.push_back(XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+			}
+
+			XMFLOAT4& sum = clusterSums[cluster.first->second];
+			sum.x += vertices[vertexIndex].position.x;
+			sum.y += vertices[vertexIndex].position.y;
+			sum.z += vertices[vertexIndex].position.z;
+			sum.w += 1.0f;
+		}
+
+		// The representative is the real vertex nearest the cluster mean, so it keeps its own bone weights
+		std::vector<float> nearestDistances(clusterSums.size(), FLT_MAX);
+		std::vector<unsigned int> nearestVertices(clusterSums.size(), 0);
+
+		for (unsigned int vertexIndex : materialVertices)
+		{
+			unsigned int cluster = clusterIndices[clusterKeys[vertexIndex]];
+			const XMFLOAT4& sum = clusterSums[cluster];
+			XMVECTOR mean = XMVectorScale(XMLoadFloat4(&sum), 1.0f / sum.w);
+			float distance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertices[vertexIndex].position), mean)));
+
+			if (distance < nearestDistances[cluster])
+			{
+				nearestDistances[cluster] = distance;
+				nearestVertices[cluster] = vertexIndex;
+			}
+		}
+
+		for (unsigned int vertexIndex : materialVertices)
+		{
+			representatives[vertexIndex] = nearestVertices[clusterIndices[clusterKeys[vertexIndex]]];
+		}
+
+		materialFaces.clear();
+		for (unsigned int index = indexOffset; index < indexOffset + numFaceVertices; index += 3)
+		{
+			const PMXFace& face = mPmxFileData.faces[index / 3];
+			std::array<int, 3> proxyFace = { static_cast<int>(representatives[face.vertices[0]]), static_cast<int>(representatives[face.vertices[1]]), static_cast<int>(representatives[face.vertices[2]]) };
+
+			if (proxyFace[0] == proxyFace[1] || proxyFace[1] == proxyFace[2] || proxyFace[2] == proxyFace[0])
+			{
+				continue;
+			}
+
+			// Rotate the smallest index first to find duplicates without flipping the winding
+			std::rotate(proxyFace.begin(), std::min_element(proxyFace.begin(), proxyFace.end()), proxyFace.end());
+			materialFaces.push_back(proxyFace);
+		}
+
+		std::sort(materialFaces.begin(), materialFaces.end());
+		materialFaces.erase(std::unique(materialFaces.begin(), materialFaces.end()), materialFaces.end());
+
+		for (const std::array<int, 3>& proxyFace : materialFaces)
+		{
+			mProxyFaces.push_back(PMXFace{ { proxyFace[0], proxyFace[1], proxyFace[2] } });
+
+			for (int vertexIndex : proxyFace)
+			{
+				isRepresentative[vertexIndex] = true;
+			}
+		}
+
+		mProxyIndexCounts[materialIndex] = static_cast<unsigned int>(materialFaces.size()) * 3;
+		indexOffset += numFaceVertices;
+	}
+
+	mProxyMeshResult.proxyFaceCount = static_cast<unsigned int>(mProxyFaces.size());
+	mProxyMeshResult.proxyVertexCount = static_cast<unsigned int>(std::count(isRepresentative.begin(), isRepresentative.end(), true));
+}
+
+void PMXActor::UpdateVisibleVertexRuns()
+{
+	unsigned int vertexCount = static_cast<unsigned int>(mPmxFileData.vertices.size());
+	std::vector<bool> isVisible(vertexCount, false);
+
+	// Materials are all visible until CreateMaterialData loads them
+	for (unsigned int materialIndex = 0; materialIndex < mMaterialVertices.size(); materialIndex++)
+	{
+		if (materialIndex < mLoadedMaterial.size() && mLoadedMaterial[materialIndex].visible == false)
+		{
+			continue;
+		}
+
+		for (unsigned int vertexIndex : mMaterialVertices[materialIndex])
+		{
+			isVisible[vertexIndex] = true;
+		}
+	}
+
+	mVisibleVertexRuns.clear();
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		if (isVisible[i] == false)
+		{
+			continue;
+		}
+
+		if (mVisibleVertexRuns.empty() == false && mVisibleVertexRuns.back().startIndex + mVisibleVertexRuns.back().vertexCount == i)
+		{
+			mVisibleVertexRuns.back().vertexCount++;
+		}
+		else
+		{
+			mVisibleVertexRuns.push_back(SkinningRange{ i, 1 });
+		}
+	}
+
+	InitParallelVertexSkinningSetting();
+}
+
+void PMXActor::InitParallelVertexSkinningSetting()
+{
+	// Several cost balanced ranges per thread so the job system can even out what the cost estimate misses
+	unsigned int targetRangeCount = JobSystem::Instance().GetThreadCount() * 4;
+
+	unsigned int totalCost = 0;
+	for (const SkinningRange& run : mVisibleVertexRuns)
+	{
+		for (unsigned int i = run.startIndex; i < run.startIndex + run.vertexCount; i++)
+		{
+			totalCost += GetSkinningCost(mPmxFileData.vertices[i].weightType);
+		}
+	}
+
+	mSkinningRanges.clear();
+
+	// Ranges may span hidden vertices, VertexSkinningByRange only skins the visible runs inside them
+	unsigned int startIndex = mVisibleVertexRuns.empty() == false ? mVisibleVertexRuns.front().startIndex : 0;
+	unsigned int accumulatedCost = 0;
+
+	for (const SkinningRange& run : mVisibleVertexRuns)
+	{
+		for (unsigned int i = run.startIndex; i < run.startIndex + run.vertexCount; i++)
+		{
+			accumulatedCost += GetSkinningCost(mPmxFileData.vertices[i].weightType);
+
+			unsigned int rangeCount = static_cast<unsigned int>(mSkinningRanges.size()) + 1;
+			if (accumulatedCost * targetRangeCount >= totalCost * rangeCount)
+			{
+				mSkinningRanges.push_back(SkinningRange{ startIndex, i + 1 - startIndex });
+				startIndex = i + 1;
+			}
+		}
+	}
+
+	if (mVisibleVertexRuns.empty() == false)
+	{
+		unsigned int visibleEnd = mVisibleVertexRuns.back().startIndex + mVisibleVertexRuns.back().vertexCount;
+		if (startIndex < visibleEnd)
+		{
+			mSkinningRanges.push_back(SkinningRange{ startIndex, visibleEnd - startIndex });
+		}
+	}
+}
+
+QuantizedVertex* PMXActor::GetSkinnedVertices() const
+{
+	return mMappedVertex + mSimulationSlot * mPmxFileData.vertices.size();
+}
+
+void PMXActor::UpdateSkinningPalette()
+{
+	const std::vector<BoneNode*>& boneNodes = mNodeManager.GetAllNodes();
+
+	for (unsigned int boneIndex = 0; boneIndex < boneNodes.size(); boneIndex++)
+	{
+		const BoneNode* boneNode = boneNodes[boneIndex];
+		VertexSkinning::SetPaletteBone(boneNode->GetInitInverseTransform(), boneNode->GetGlobalTransform(), mBoneMatrices[boneIndex], mBoneRotations[boneIndex], mBoneDualQuaternions[boneIndex], &mSkinningPalette[boneIndex * skinningPaletteStride]);
+	}
+}
+
+void PMXActor::UpdateVertexQuantization()
+{
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+
+	for (unsigned int boneIndex = 0; boneIndex < mBoneBounds.size(); boneIndex++)
+	{
+		const BoneBounds& bounds = mBoneBounds[boneIndex];
+		if (bounds.extent.x < 0.0f)
+		{
+			continue;
+		}
+
+		const XMMATRIX& boneMatrix = mBoneMatrices[boneIndex];
+		XMVECTOR center = XMVector3Transform(XMLoadFloat3(&bounds.center), boneMatrix);
+		XMVECTOR extent = XMVectorMultiply(XMVectorAbs(boneMatrix.r[0]), XMVectorReplicate(bounds.extent.x));
+		extent = XMVectorMultiplyAdd(XMVectorAbs(boneMatrix.r[1]), XMVectorReplicate(bounds.extent.y), extent);
+		extent = XMVectorMultiplyAdd(XMVectorAbs(boneMatrix.r[2]), XMVectorReplicate(bounds.extent.z), extent);
+
+		boundsMin = XMVectorMin(boundsMin, XMVectorSubtract(center, extent));
+		boundsMax = XMVectorMax(boundsMax, XMVectorAdd(center, extent));
+	}
+
+	if (XMVector3Greater(boundsMin, boundsMax) == true)
+	{
+		boundsMin = XMVectorZero();
+		boundsMax = XMVectorZero();
+	}
+
+	// Linear blends stay inside the transformed bone boxes, SDEF and dual quaternion blends may bulge slightly out
+	XMVECTOR margin = XMVectorAdd(XMVectorScale(XMVectorSubtract(boundsMax, boundsMin), 1.0f / 16.0f), XMVectorReplicate(0.001f));
+
+	XMFLOAT3 quantizationMin;
+	XMFLOAT3 quantizationMax;
+	XMStoreFloat3(&quantizationMin, XMVectorSubtract(boundsMin, margin));
+	XMStoreFloat3(&quantizationMax, XMVectorAdd(boundsMax, margin));
+
+	mVertexQuantization = SkinningKernel::CreateQuantization(&quantizationMin.x, &quantizationMax.x);
+}
+
+void PMXActor::WriteVertexQuantization()
+{
+	// The shader reads unorm16 in [0, 1], so it scales by the full box size
+	XMFLOAT4 offset(mVertexQuantization.offset[0], mVertexQuantization.offset[1], mVertexQuantization.offset[2], 0.0f);
+	XMFLOAT4 scale(mVertexQuantization.scale[0] * 65535.0f, mVertexQuantization.scale[1] * 65535.0f, mVertexQuantization.scale[2] * 65535.0f, 0.0f);
+
+	mTransforms[mSimulationSlot].positionOffset = offset;
+	mTransforms[mSimulationSlot].positionScale = scale;
+	mReflectionTransforms[mSimulationSlot].positionOffset = offset;
+	mReflectionTransforms[mSimulationSlot].positionScale = scale;
+}
+
+void PMXActor::UpdateGpuSkinning()
+{
+	GpuSkinning::PackPalette(mSkinningPalette.data(), mPmxFileData.bones.size(), reinterpret_cast<float*>(mMappedBonePalette + mSimulationSlot * mBonePaletteSlotSize));
+
+	// Clear what this slot carried frame_buffer_slots frames ago, then write the active morphs merged by vertex
+	GpuMorphVertex* morphVertices = mMappedMorphVertex + mSimulationSlot * mPmxFileData.vertices.size();
+	std::vector<unsigned int>& morphedVertices = mMorphedVertices[mSimulationSlot];
+
+	for (unsigned int vertexIndex : morphedVertices)
+	{
+		morphVertices[vertexIndex] = GpuMorphVertex{};
+	}
+	morphedVertices.clear();
+
+	const VertexMorphTable& morphTable = mMorphManager.GetVertexMorphTable();
+	const std::vector<unsigned int>& morphRows = mMorphManager.GetActiveVertexMorphRows();
+	const MorphBasis& morphBasis = mMorphManager.GetMorphBasis();
+	const std::vector<unsigned int>& basisVertices = morphBasis.GetVertexIndices();
+
+	auto morphRow = morphRows.begin();
+	auto basisVertex = mMorphManager.IsMorphBasisActive() == true ? basisVertices.begin() : basisVertices.end();
+
+	while (morphRow != morphRows.end() || basisVertex != basisVertices.end())
+	{
+		unsigned int rowVertexIndex = morphRow != morphRows.end() ? morphTable.vertexIndices[*morphRow] : UINT_MAX;
+		unsigned int basisVertexIndex = basisVertex != basisVertices.end() ? *basisVertex : UINT_MAX;
+		unsigned int vertexIndex = (std::min)(rowVertexIndex, basisVertexIndex);
+
+		XMVECTOR morphPosition = XMVectorZero();
+		XMVECTOR morphUV = XMVectorZero();
+
+		if (rowVertexIndex == vertexIndex)
+		{
+			mMorphManager.GatherVertexMorph(*morphRow, morphPosition, morphUV);
+			++morphRow;
+		}
+
+		if (basisVertexIndex == vertexIndex)
+		{
+			morphPosition += morphBasis.Evaluate(static_cast<unsigned int>(basisVertex - basisVertices.begin()));
+			++basisVertex;
+		}
+
+		GpuMorphVertex& morphVertex = morphVertices[vertexIndex];
+		XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(morphVertex.position), morphPosition);
+		XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(morphVertex.uv), morphUV);
+		morphedVertices.push_back(vertexIndex);
+	}
+}
+
+void PMXActor::SetVertexBuffers(Dx12Wrapper& dx) const
+{
+	if (IsGpuSkinning() == true)
+	{
+		D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[] = { mGpuSkinningVertexBufferView, mMorphVertexBufferViews[mRenderSlot] };
+		dx.CommandList()->IASetVertexBuffers(0, 2, vertexBufferViews);
+		dx.CommandList()->SetGraphicsRootConstantBufferView(5, mBonePaletteBuffer->GetGPUVirtualAddress() + mRenderSlot * mBonePaletteSlotSize);
+		return;
+	}
+
+	dx.CommandList()->IASetVertexBuffers(0, 1, &mVertexBufferViews[mRenderSlot]);
+}
+
+void PMXActor::VertexSkinning()
+{
+	JobSystem::Instance().ParallelFor(0, mSkinningRanges.size(), 1, [this](unsigned int startIndex, unsigned int endIndex)
+		{
+			for (unsigned int i = startIndex; i < endIndex; i++)
+			{
+				this->VertexSkinningByRange(mSkinningRanges[i]);
+			}
+		});
+}
+
+void PMXActor::VertexSkinningByRange(const SkinningRange& range)
+{
+	const VertexMorphTable& morphTable = mMorphManager.GetVertexMorphTable();
+	const std::vector<unsigned int>& morphRows = mMorphManager.GetActiveVertexMorphRows();
+	const std::vector<unsigned int>& basisVertices = mMorphManager.GetMorphBasis().GetVertexIndices();
+
+	VertexMorphCursor cursor;
+	cursor.morphRow = morphRows.begin();
+	cursor.morphRowEnd = morphRows.end();
+	cursor.basisVertex = mMorphManager.IsMorphBasisActive() == true ? basisVertices.begin() : basisVertices.end();
+	cursor.basisVertexBegin = basisVertices.begin();
+	cursor.basisVertexEnd = basisVertices.end();
+
+	unsigned int rangeEnd = range.startIndex + range.vertexCount;
+
+	auto run = std::upper_bound(mVisibleVertexRuns.begin(), mVisibleVertexRuns.end(), range.startIndex,
+		[](unsigned int vertexIndex, const SkinningRange& visibleRun)
+		{
+			return vertexIndex < visibleRun.startIndex + visibleRun.vertexCount;
+		});
+
+	for (; run != mVisibleVertexRuns.end() && run->startIndex < rangeEnd; ++run)
+	{
+		unsigned int startIndex = (std::max)(range.startIndex, run->startIndex);
+		unsigned int endIndex = (std::min)(rangeEnd, run->startIndex + run->vertexCount);
+
+		// Skip the morphs of the hidden vertices before this run
+		cursor.morphRow = std::lower_bound(cursor.morphRow, cursor.morphRowEnd, startIndex,
+			[&morphTable](unsigned int row, unsigned int vertexIndex)
+			{
+				return morphTable.vertexIndices[row] < vertexIndex;
+			});
+		cursor.basisVertex = std::lower_bound(cursor.basisVertex, cursor.basisVertexEnd, startIndex);
+
+		VertexSkinningByRun(startIndex, endIndex, cursor);
+	}
+}
+
+void PMXActor::VertexSkinningByRun(unsigned int runStart, unsigned int runEnd, VertexMorphCursor& cursor)
+{
+	for (const SkinningBucket& bucket : mSkinningBuckets)
+	{
+		unsigned int startIndex = (std::max)(runStart, bucket.startIndex);
+		unsigned int endIndex = (std::min)(runEnd, bucket.startIndex + bucket.vertexCount);
+
+		if (startIndex >= endIndex)
+		{
+			continue;
+		}
+
+		if (bucket.dualQuaternion == true)
+		{
+			switch (bucket.weightType)
+			{
+			case PMXVertexWeight::BDEF2:
+				VertexSkinningByBucket<PMXVertexWeight::BDEF2, true>(startIndex, endIndex, cursor);
+				break;
+			case PMXVertexWeight::BDEF4:
+				VertexSkinningByBucket<PMXVertexWeight::BDEF4, true>(startIndex, endIndex, cursor);
+				break;
+			case PMXVertexWeight::SDEF:
+				VertexSkinningByBucket<PMXVertexWeight::SDEF, true>(startIndex, endIndex, cursor);
+				break;
+			default:
+				break;
+			}
+
+			continue;
+		}
+
+		switch (bucket.weightType)
+		{
+		case PMXVertexWeight::BDEF1:
+			VertexSkinningBySimd<PMXVertexWeight::BDEF1>(startIndex, endIndex, cursor);
+			break;
+		case PMXVertexWeight::BDEF2:
+			VertexSkinningBySimd<PMXVertexWeight::BDEF2>(startIndex, endIndex, cursor);
+			break;
+		case PMXVertexWeight::BDEF4:
+			VertexSkinningBySimd<PMXVertexWeight::BDEF4>(startIndex, endIndex, cursor);
+			break;
+		case PMXVertexWeight::SDEF:
+			VertexSkinningByBucket<PMXVertexWeight::SDEF, false>(startIndex, endIndex, cursor);
+			break;
+		case PMXVertexWeight::QDEF:
+			VertexSkinningBySimd<PMXVertexWeight::QDEF>(startIndex, endIndex, cursor);
+			break;
 		default:
 			break;
 		}
+	}
+}
+
+template<PMXVertexWeight weightType>
+void PMXActor::VertexSkinningBySimd(unsigned int startIndex, unsigned int endIndex, VertexMorphCursor& cursor)
+{
+	const VertexMorphTable& morphTable = mMorphManager.GetVertexMorphTable();
+	unsigned int width = SkinningKernel::GetKernelWidth(mSkinningKernelType);
+	unsigned int influenceCount = VertexSkinning::GetInfluenceCount(weightType);
+
+	SkinningOutput output = { GetSkinnedVertices(), mVertexQuantization };
+
+	unsigned int blockStart = startIndex;
+	while (blockStart < endIndex)
+	{
+		// Blocks holding a morphed vertex go through the scalar kernel which gathers the morph
+		unsigned int morphVertex = UINT_MAX;
+		if (cursor.morphRow != cursor.morphRowEnd)
+		{
+			morphVertex = morphTable.vertexIndices[*cursor.morphRow];
+		}
+		if (cursor.basisVertex != cursor.basisVertexEnd)
+		{
+			morphVertex = (std::min)(morphVertex, *cursor.basisVertex);
+		}
+
+		unsigned int simdEnd = (std::min)(endIndex, morphVertex);
+		simdEnd = blockStart + (simdEnd - blockStart) / width * width;
+
+		if (simdEnd > blockStart)
+		{
+			SkinningKernel::Skinning(mSkinningKernelType, influenceCount, mSkinningStream, mSkinningPalette.data(), blockStart, simdEnd, output);
+			blockStart = simdEnd;
+			continue;
+		}
+
+		unsigned int scalarEnd = (std::min)(blockStart + width, endIndex);
+		VertexSkinningByBucket<weightType, false>(blockStart, scalarEnd, cursor);
+		blockStart = scalarEnd;
+	}
+}
+
+template<PMXVertexWeight weightType, bool isDualQuaternion>
+void PMXActor::VertexSkinningByBucket(unsigned int startIndex, unsigned int endIndex, VertexMorphCursor& cursor)
+{
+	SkinningPaletteView palette = { mBoneMatrices.data(), mBoneRotations.data(), mBoneDualQuaternions.data(), mSdefVertices.data(), mSdefStartIndex };
+	const VertexMorphTable& morphTable = mMorphManager.GetVertexMorphTable();
+	const MorphBasis& morphBasis = mMorphManager.GetMorphBasis();
+	QuantizedVertex* skinnedVertices = GetSkinnedVertices();
+
+	for (unsigned int i = startIndex; i < endIndex; ++i)
+	{
+		const PMXVertex& currentVertexData = mPmxFileData.vertices[i];
+		XMVECTOR position = XMLoadFloat3(&currentVertexData.position);
+		unsigned int packedUV = mSkinningStream.uv[i];
+
+		if (cursor.morphRow != cursor.morphRowEnd && morphTable.vertexIndices[*cursor.morphRow] == i)
+		{
+			XMVECTOR morphPosition;
+			XMVECTOR morphUV;
+			mMorphManager.GatherVertexMorph(*cursor.morphRow, morphPosition, morphUV);
+
+			position += morphPosition;
+			packedUV = VertexSkinning::PackMorphedUV(currentVertexData, morphUV);
+
+			++cursor.morphRow;
+		}
+
+		if (cursor.basisVertex != cursor.basisVertexEnd && *cursor.basisVertex == i)
+		{
+			position += morphBasis.Evaluate(static_cast<unsigned int>(cursor.basisVertex - cursor.basisVertexBegin));
 
-		XMStoreFloat3(&mUploadVertices[i].position, position);
+			++cursor.basisVertex;
+		}
 
-		const XMFLOAT4& morphUV = mMorphManager.GetMorphUV(i);
-		const XMFLOAT2& originalUV = mUploadVertices[i].uv;
-		mUploadVertices[i].uv = XMFLOAT2(originalUV.x + morphUV.x, originalUV.y + morphUV.y);
+		VertexSkinning::SkinAndEncodeVertex<weightType, isDualQuaternion>(currentVertexData, i, palette, position, packedUV, mVertexQuantization, skinnedVertices[i]);
 	}
 }
 
 void PMXActor::MorphMaterial()
 {
-	size_t bufferSize = sizeof(MaterialForShader);
-	bufferSize = (bufferSize + 0xff) & ~0xff;
-
-	char* mappedMaterialPtr = mMappedMaterial;
+	std::vector<MaterialForShader>& materials = mMaterials[mSimulationSlot];
 
 	for (int i = 0; i < mLoadedMaterial.size(); i++)
 	{
 		LoadMaterial& material = mLoadedMaterial[i];
 
-		MaterialForShader* uploadMat = reinterpret_cast<MaterialForShader*>(mappedMaterialPtr);
+		MaterialForShader* uploadMat = &materials[i];
 
 		XMVECTOR diffuse = XMLoadFloat4(&material.diffuse);
 		XMVECTOR specular = XMLoadFloat3(&material.specular);
@@ -1015,8 +2046,6 @@ void PMXActor::MorphMaterial()
 		uploadMat->diffuse = resultDiffuse;
 		uploadMat->specular = resultSpecular;
 		uploadMat->ambient = resultAmbient;
-
-		mappedMaterialPtr += bufferSize;
 	}
 }
 
@@ -8,7 +8,6 @@
 #include<algorithm>
 #include<unordered_map>
 #include<thread>
-#include<future>
 
 #include "IKSolver.h"
 #include "VMDFileData.h"
@@ -18,27 +17,87 @@
 #include "IGetTransform.h"
 #include "Transform.h"
 #include "IActor.h"
+#include "Define.h"
+#include "SkinningKernel.h"
+#include "VertexSkinning.h"
+#include "GpuSkinning.h"
+#include "DescriptorAllocator.h"
 
 using namespace DirectX;
 
 
-struct UploadVertex
+struct SkinningRange
 {
-	XMFLOAT3 position;
-	XMFLOAT3 normal;
-	XMFLOAT2 uv;
+	unsigned int startIndex;
+	unsigned int vertexCount;
 };
 
-struct SkinningRange
+enum class SkinningMode
+{
+	Default,
+	DualQuaternion,
+	Gpu,		// linear blend in the vertex shader from an uploaded bone palette
+};
+
+struct WeightPruningSetting
+{
+	bool enable = true;
+	float threshold = 0.0f;		// Influences at or below are dropped, 0 only removes zero weight and repeated bones and keeps the blend exact
+};
+
+struct WeightPruningResult
+{
+	unsigned int prunedInfluenceCount = 0;
+	unsigned int prunedVertexCount = 0;
+	unsigned int demotedVertexCount[static_cast<int>(PMXVertexWeight::QDEF) + 1] = {};	// by original weight type
+	unsigned int skinningCostBefore = 0;
+	unsigned int skinningCostAfter = 0;
+	float maxError = 0.0f;		// model units, measured on a test pose
+	float meanError = 0.0f;		// over the pruned vertices only
+};
+
+struct ProxyMeshSetting
+{
+	bool enable = true;
+	unsigned int gridResolution = 48;		// Cells along the longest side of the bind pose bounds
+};
+
+struct ProxyMeshResult
+{
+	unsigned int faceCount = 0;
+	unsigned int proxyFaceCount = 0;
+	unsigned int proxyVertexCount = 0;
+};
+
+struct SkinningBucket
 {
+	PMXVertexWeight weightType;
+	bool dualQuaternion;
 	unsigned int startIndex;
 	unsigned int vertexCount;
 };
 
-struct UpdateRange
+// Bind pose box of the vertices a bone influences, negative extent when it influences none
+struct BoneBounds
 {
-	unsigned int startIndex;
-	unsigned int range;
+	XMFLOAT3 center;
+	XMFLOAT3 extent;
+};
+
+struct VertexMorphCursor
+{
+	std::vector<unsigned int>::const_iterator morphRow;
+	std::vector<unsigned int>::const_iterator morphRowEnd;
+	std::vector<unsigned int>::const_iterator basisVertex;
+	std::vector<unsigned int>::const_iterator basisVertexBegin;
+	std::vector<unsigned int>::const_iterator basisVertexEnd;
+};
+
+// What the draw calls need from the frame a slot was simulated in, so UI changes made since do not mix in
+struct PMXRenderSnapshot
+{
+	SkinningMode skinningMode = SkinningMode::Default;
+	std::vector<bool> materialVisible;
 };
 
 struct LoadMaterial
@@ -50,10 +109,12 @@ struct LoadMaterial
 	float specularPower;
 	XMFLOAT3 ambient;
 	bool isTransparent;
+	bool dualQuaternionSkinning;
 };
 
 class NodeManager;
 class MorphManager;
+class FrameTaskGraph;
 
 class Dx12Wrapper;
 class PMXActor : public IGetTransform,
@@ -65,14 +126,25 @@ public:
 
 	bool Initialize(const std::wstring& filePath, Dx12Wrapper& dx);
 	void Update();
-	void UpdateAnimation();
+	// Morph, bone evaluation, IK, physics sync, skinning and upload as a chain of tasks
+	void AddFrameTasks(FrameTaskGraph& graph);
+	// Draws switch to the slot the last frame tasks wrote, only call while they are not running
+	void PublishFrame();
 	void Draw(Dx12Wrapper& dx, bool isShadow) const;
 	void DrawReflection(Dx12Wrapper& dx) const;
 	void DrawOpaque(Dx12Wrapper& dx) const;
+	// Copies the transforms and materials of the published slot to the upload memory of the frame being recorded
+	void UploadConstants(Dx12Wrapper& dx);
 
 	const std::vector<LoadMaterial>& GetMaterials() const;
 	void SetMaterials(const std::vector<LoadMaterial>& setMaterials);
 
+	void SetSkinningMode(SkinningMode mode);
+	bool IsGpuSkinning() const { return mRenderSnapshots[mRenderSlot].skinningMode == SkinningMode::Gpu; }
+	void SetMorphCompressionSetting(const MorphCompressionSetting& setting) { mMorphCompressionSetting = setting; }
+	void SetWeightPruningSetting(const WeightPruningSetting& setting) { mWeightPruningSetting = setting; }
+	void SetProxyMeshSetting(const ProxyMeshSetting& setting) { mProxyMeshSetting = setting; }
+
 	Transform& GetTransform() override;
 	std::string GetName() const override;
 	void SetName(std::string name) override;
@@ -80,20 +152,45 @@ public:
 
 private:
 	HRESULT CreateVbAndIb(Dx12Wrapper& dx);
-	HRESULT CreateTransformView(Dx12Wrapper& dx);
+	HRESULT CreateGpuSkinningBuffers(Dx12Wrapper& dx);
+	void InitTransforms();
 	HRESULT CreateMaterialData(Dx12Wrapper& dx);
 	HRESULT CreateMaterialAndTextureView(Dx12Wrapper& dx);
 
-	void LoadVertexData(const std::vector<PMXVertex>& vertices);
-
 	void InitAnimation(VMDFileData& vmdFileData);
 
 	void InitPhysics(const PMXFileData& pmxFileData);
 
+	void UpdateMorph();
+	void EvaluateBones();
+	void SolveIK();
+	void SyncPhysics();
+	void UpdateSkinning();
+	void UploadFrameData();
+
+	void PruneVertexWeights();
+	void SortVerticesByWeightType();
+	void UpdateSkinningBuckets();
+	void InitSkinningStream();
+	void InitSkinningBounds();
+	void InitMaterialVertices();
+	void InitProxyMesh();
+	void UpdateVisibleVertexRuns();
 	void InitParallelVertexSkinningSetting();
 
+	QuantizedVertex* GetSkinnedVertices() const;
+	void UpdateSkinningPalette();
+	void UpdateVertexQuantization();
+	void WriteVertexQuantization();
+	void UpdateGpuSkinning();
+	void SetVertexBuffers(Dx12Wrapper& dx) const;
 	void VertexSkinning();
 	void VertexSkinningByRange(const SkinningRange& range);
+	void VertexSkinningByRun(unsigned int runStart, unsigned int runEnd, VertexMorphCursor& cursor);
+	template<PMXVertexWeight weightType>
+	void VertexSkinningBySimd(unsigned int startIndex, unsigned int endIndex, VertexMorphCursor& cursor);
+	template<PMXVertexWeight weightType, bool isDualQuaternion>
+	void VertexSkinningByBucket(unsigned int startIndex, unsigned int endIndex, VertexMorphCursor& cursor);
 
 	void MorphMaterial();
 	void MorphBone();
@@ -110,33 +207,65 @@ private:
 
 	NodeManager mNodeManager;
 	MorphManager mMorphManager;
+	MorphCompressionSetting mMorphCompressionSetting;
+	WeightPruningSetting mWeightPruningSetting;
+	WeightPruningResult mWeightPruningResult;
+	ProxyMeshSetting mProxyMeshSetting;
+	ProxyMeshResult mProxyMeshResult;
 
 	ComPtr<ID3D12Resource> mVertexBuffer = nullptr;
 	ComPtr<ID3D12Resource> mIndexBuffer = nullptr;
-	D3D12_VERTEX_BUFFER_VIEW mVertexBufferView = {};
+	std::array<D3D12_VERTEX_BUFFER_VIEW, frame_buffer_slots> mVertexBufferViews = {};
 	D3D12_INDEX_BUFFER_VIEW mIndexBufferView = {};
 
-	UploadVertex* mMappedVertex;
-	std::vector<UploadVertex> mUploadVertices;
+	// Clustered faces over the same skinned vertices for the shadow and reflection passes
+	std::vector<PMXFace> mProxyFaces;
+	std::vector<unsigned int> mProxyIndexCounts;
+	ComPtr<ID3D12Resource> mProxyIndexBuffer = nullptr;
+	D3D12_INDEX_BUFFER_VIEW mProxyIndexBufferView = {};
+
+	QuantizedVertex* mMappedVertex;
+
+	// Every per frame buffer is a ring of frame_buffer_slots slots, the frame tasks write one while the draws read another
+	// and the GPU may still read the ones of the frames in flight
+	unsigned int mSimulationSlot = 0;
+	unsigned int mRenderSlot = 0;
+	std::array<PMXRenderSnapshot, frame_buffer_slots> mRenderSnapshots;
+
+	// GPU skinning : static bind pose vertices, plus a morph offset stream and a bone palette per slot
+	ComPtr<ID3D12Resource> mGpuSkinningVertexBuffer = nullptr;
+	D3D12_VERTEX_BUFFER_VIEW mGpuSkinningVertexBufferView = {};
+	ComPtr<ID3D12Resource> mMorphVertexBuffer = nullptr;
+	std::array<D3D12_VERTEX_BUFFER_VIEW, frame_buffer_slots> mMorphVertexBufferViews = {};
+	GpuMorphVertex* mMappedMorphVertex = nullptr;
+	std::array<std::vector<unsigned int>, frame_buffer_slots> mMorphedVertices;
+	ComPtr<ID3D12Resource> mBonePaletteBuffer = nullptr;
+	char* mMappedBonePalette = nullptr;
+	unsigned int mBonePaletteSlotSize = 0;
 
 	std::vector<ComPtr<ID3D12Resource>> mTextureResources;
 	std::vector<ComPtr<ID3D12Resource>> mToonResources;
 	std::vector<ComPtr<ID3D12Resource>> mSphereTextureResources;
 
 	Transform mTransform;
-	ComPtr<ID3D12Resource> mTransformMat = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mTransformHeap = nullptr;
 	std::vector<XMMATRIX> mBoneMatrices;
+	std::vector<float> mSkinningPalette;
+	std::vector<XMVECTOR> mBoneRotations;
+	std::vector<XMVECTOR> mBoneDualQuaternions;
 	std::vector<XMMATRIX> mBoneLocalMatrices;
 
-	DirectX::XMMATRIX* mMappedMatrices;
-	DirectX::XMMATRIX* mMappedReflectionMatrices;
-	ComPtr<ID3D12Resource> mTransformBuff = nullptr;
-	ComPtr<ID3D12Resource> mReflectionTransformBuff = nullptr;
+	struct TransformForShader
+	{
+		XMMATRIX world;
+		XMFLOAT4 positionOffset;
+		XMFLOAT4 positionScale;
+	};
 
-	ComPtr<ID3D12Resource> mMaterialBuff = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mMaterialHeap = nullptr;
-	char* mMappedMaterial = nullptr;
+	std::array<TransformForShader, frame_buffer_slots> mTransforms;
+	std::array<TransformForShader, frame_buffer_slots> mReflectionTransforms;
+
+	// Texture views only, the material constants are root constant buffer views
+	DescriptorRange mMaterialDescriptors;
 	std::vector<LoadMaterial> mLoadedMaterial;
 
 	struct MaterialForShader
@@ -147,17 +276,29 @@ private:
 		XMFLOAT3 ambient;
 	};
 
+	std::array<std::vector<MaterialForShader>, frame_buffer_slots> mMaterials;
+
+	// Written by UploadConstants for the frame being recorded, materials follow each other 256 bytes apart
+	D3D12_GPU_VIRTUAL_ADDRESS mTransformAddress = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS mReflectionTransformAddress = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS mMaterialAddress = 0;
+
 	unsigned int mDuration;
 	unsigned int mStartTime = 0;
-
+	unsigned int mElapsedTime = 0;
+	unsigned int mFrameNo = 0;
+
+	SkinningMode mSkinningMode = SkinningMode::Default;
+	std::vector<SkinningBucket> mSkinningBuckets;
+	SkinningStream mSkinningStream;
+	std::vector<SdefSkinningData> mSdefVertices;
+	std::vector<BoneBounds> mBoneBounds;
+	VertexQuantization mVertexQuantization = {};
+	unsigned int mSdefStartIndex = 0;
+	SkinningKernelType mSkinningKernelType = SkinningKernelType::SSE2;
+	std::vector<std::vector<unsigned int>> mMaterialVertices;
+	std::vector<SkinningRange> mVisibleVertexRuns;
 	std::vector<SkinningRange> mSkinningRanges;
-	std::vector<std::future<void>> mParallelUpdateFutures;
-
-	std::vector<UpdateRange> mMorphMaterialRanges;
-	std::vector<std::future<void>> mParallelMorphMaterialUpdateFutures;
-
-	std::vector<UpdateRange> mMorphBoneRanges;
-	std::vector<std::future<void>> mParallelMorphBoneUpdateFutures;
 
 	std::vector<std::unique_ptr<RigidBody>> mRigidBodies;
 	std::vector<std::unique_ptr<Joint>> mJoints;
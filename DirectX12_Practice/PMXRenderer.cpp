@@ -9,7 +9,6 @@
 
 #include "ImguiManager.h"
 
-
 HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 {
 	ComPtr<ID3DBlob> errorBlob = nullptr;
@@ -37,9 +36,48 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 		return result;
 	}
 
+	D3D_SHADER_MACRO gpuSkinningDefines[] = { { "GPU_SKINNING", "1" }, { nullptr, nullptr } };
+
+	ComPtr<ID3DBlob> gpuSkinningVertexShader = nullptr;
+
+	result = D3DCompileFromFile(L"PMXVertexShader.hlsl",
+		gpuSkinningDefines,
+		D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"VS",
+		"vs_5_0",
+		flags,
+		0,
+		&gpuSkinningVertexShader,
+		&errorBlob);
+
+	if (!CheckShaderCompileResult(result, errorBlob.Get()))
+	{
+		assert(0);
+		return result;
+	}
 
 	//ǲ ̾ƿ
 	D3D12_INPUT_ELEMENT_DESC inputLayout[] =
+	{
+		{
+			"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0,
+			D3D12_APPEND_ALIGNED_ELEMENT,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+		},
+		{
+			"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0,
+			D3D12_APPEND_ALIGNED_ELEMENT,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+		},
+		{
+			"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0,
+			D3D12_APPEND_ALIGNED_ELEMENT,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+		}
+	};
+
+	//GPU Ű ǲ ̾ƿ,  1  Ӻ  
+	D3D12_INPUT_ELEMENT_DESC gpuSkinningInputLayout[] =
 	{
 		{
 			"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,
@@ -55,6 +93,26 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 			"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0,
 			D3D12_APPEND_ALIGNED_ELEMENT,
 			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+		},
+		{
+			"BLENDINDICES", 0, DXGI_FORMAT_R16G16B16A16_UINT, 0,
+			D3D12_APPEND_ALIGNED_ELEMENT,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+		},
+		{
+			"BLENDWEIGHT", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0,
+			D3D12_APPEND_ALIGNED_ELEMENT,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+		},
+		{
+			"MORPHPOSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1,
+			D3D12_APPEND_ALIGNED_ELEMENT,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+		},
+		{
+			"MORPHUV", 0, DXGI_FORMAT_R32G32_FLOAT, 1,
+			D3D12_APPEND_ALIGNED_ELEMENT,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
 		}
 	};
 
@@ -136,6 +194,12 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 		assert(SUCCEEDED(result));
 	}
 
+	result = CreateGpuSkinningPipeline(gpipeline, gpuSkinningVertexShader.Get(), gpuSkinningInputLayout, _countof(gpuSkinningInputLayout), mGpuSkinningForwardPipeline);
+	if (FAILED(result))
+	{
+		return result;
+	}
+
 	ComPtr<ID3DBlob> deferredPixelShader;
 
 	result = D3DCompileFromFile(L"PMXPixelShaderDeferred.hlsl",
@@ -165,6 +229,12 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 		assert(SUCCEEDED(result));
 	}
 
+	result = CreateGpuSkinningPipeline(gpipeline, gpuSkinningVertexShader.Get(), gpuSkinningInputLayout, _countof(gpuSkinningInputLayout), mGpuSkinningDeferredPipeline);
+	if (FAILED(result))
+	{
+		return result;
+	}
+
 	gpipeline.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL;
 	gpipeline.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
 	result = _dx12.Device()->CreateGraphicsPipelineState(&gpipeline, IID_PPV_ARGS(mNotDepthWriteForwardPipeline.ReleaseAndGetAddressOf()));
@@ -173,6 +243,12 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 		assert(SUCCEEDED(result));
 	}
 
+	result = CreateGpuSkinningPipeline(gpipeline, gpuSkinningVertexShader.Get(), gpuSkinningInputLayout, _countof(gpuSkinningInputLayout), mGpuSkinningNotDepthWriteForwardPipeline);
+	if (FAILED(result))
+	{
+		return result;
+	}
+
 	gpipeline.NumRenderTargets = 0;
 	gpipeline.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
 	gpipeline.RTVFormats[1] = DXGI_FORMAT_UNKNOWN;
@@ -186,6 +262,12 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 		assert(SUCCEEDED(result));
 	}
 
+	result = CreateGpuSkinningPipeline(gpipeline, gpuSkinningVertexShader.Get(), gpuSkinningInputLayout, _countof(gpuSkinningInputLayout), mGpuSkinningOnlyDepthPipeline);
+	if (FAILED(result))
+	{
+		return result;
+	}
+
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC reflectionPipelineDesc = {};
 
 	reflectionPipelineDesc.pRootSignature = mRootSignature.Get();
@@ -246,6 +328,12 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 		assert(SUCCEEDED(result));
 	}
 
+	result = CreateGpuSkinningPipeline(reflectionPipelineDesc, gpuSkinningVertexShader.Get(), gpuSkinningInputLayout, _countof(gpuSkinningInputLayout), mGpuSkinningReflectionPipeline);
+	if (FAILED(result))
+	{
+		return result;
+	}
+
 	ComPtr<ID3DBlob> shadowVertexShader;
 
 	result = D3DCompileFromFile(L"PMXVertexShader.hlsl",
@@ -273,70 +361,104 @@ HRESULT PMXRenderer::CreateGraphicsPipelineForPMX()
 		assert(SUCCEEDED(result));
 	}
 
+	ComPtr<ID3DBlob> gpuSkinningShadowVertexShader;
+
+	result = D3DCompileFromFile(L"PMXVertexShader.hlsl",
+		gpuSkinningDefines,
+		D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"ShadowVS",
+		"vs_5_0",
+		flags,
+		0,
+		&gpuSkinningShadowVertexShader,
+		&errorBlob);
+
+	if (!CheckShaderCompileResult(result, errorBlob.Get()))
+	{
+		assert(0);
+		return result;
+	}
+
+	result = CreateGpuSkinningPipeline(gpipeline, gpuSkinningShadowVertexShader.Get(), gpuSkinningInputLayout, _countof(gpuSkinningInputLayout), mGpuSkinningShadowPipeline);
+	if (FAILED(result))
+	{
+		return result;
+	}
+
+	return result;
+}
+
+HRESULT PMXRenderer::CreateGpuSkinningPipeline(D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc, ID3DBlob* vertexShader, const D3D12_INPUT_ELEMENT_DESC* inputLayout, UINT inputElementCount, ComPtr<ID3D12PipelineState>& pipeline)
+{
+	pipelineDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader);
+	pipelineDesc.InputLayout.pInputElementDescs = inputLayout;
+	pipelineDesc.InputLayout.NumElements = inputElementCount;
+
+	auto result = _dx12.Device()->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(pipeline.ReleaseAndGetAddressOf()));
+	if (FAILED(result))
+	{
+		assert(SUCCEEDED(result));
+	}
+
 	return result;
 }
 
 HRESULT PMXRenderer::CreateRootSignature()
 {
 	//ũ  
-	D3D12_DESCRIPTOR_RANGE descTblRange[6] = {};
-	descTblRange[0].NumDescriptors = 1;
-	descTblRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+	D3D12_DESCRIPTOR_RANGE descTblRange[2] = {};
+	descTblRange[0].NumDescriptors = 3;
+	descTblRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
 	descTblRange[0].BaseShaderRegister = 0;
 	descTblRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
 
-	descTblRange[1].NumDescriptors = 1;
-	descTblRange[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	descTblRange[1].BaseShaderRegister = 1;
-	descTblRange[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-	descTblRange[2].NumDescriptors = 1;
-	descTblRange[2].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-	descTblRange[2].BaseShaderRegister = 2;
-	descTblRange[2].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-	descTblRange[3].NumDescriptors = 3;
-	descTblRange[3].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-	descTblRange[3].BaseShaderRegister = 0;
-	descTblRange[3].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-	descTblRange[4] = CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 4);
+	descTblRange[1] = CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 4);
 
-	descTblRange[5] = CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 3);
-
-	//Ʈ Ķ
-	D3D12_ROOT_PARAMETER rootparam[5] = {};
-	rootparam[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	//Ʈ Ķ,  ۴ Ӹ ε  Ҵ ּҸ  ѱ
+	D3D12_ROOT_PARAMETER rootparam[7] = {};
+	rootparam[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 	rootparam[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-	rootparam[0].DescriptorTable.pDescriptorRanges = &descTblRange[0];
-	rootparam[0].DescriptorTable.NumDescriptorRanges = 1;
+	rootparam[0].Descriptor.ShaderRegister = 0;
+	rootparam[0].Descriptor.RegisterSpace = 0;
 
-	rootparam[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rootparam[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 	rootparam[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-	rootparam[1].DescriptorTable.pDescriptorRanges = &descTblRange[1];
-	rootparam[1].DescriptorTable.NumDescriptorRanges = 1;
+	rootparam[1].Descriptor.ShaderRegister = 1;
+	rootparam[1].Descriptor.RegisterSpace = 0;
 
 	rootparam[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 	rootparam[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-	rootparam[2].DescriptorTable.pDescriptorRanges = &descTblRange[2];
-	rootparam[2].DescriptorTable.NumDescriptorRanges = 2;
+	rootparam[2].DescriptorTable.pDescriptorRanges = &descTblRange[0];
+	rootparam[2].DescriptorTable.NumDescriptorRanges = 1;
 
 	rootparam[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 	rootparam[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-	rootparam[3].DescriptorTable.pDescriptorRanges = &descTblRange[4];
+	rootparam[3].DescriptorTable.pDescriptorRanges = &descTblRange[1];
 	rootparam[3].DescriptorTable.NumDescriptorRanges = 1;
 
-	rootparam[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rootparam[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 	rootparam[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-	rootparam[4].DescriptorTable.pDescriptorRanges = &descTblRange[5];
-	rootparam[4].DescriptorTable.NumDescriptorRanges = 1;
+	rootparam[4].Descriptor.ShaderRegister = 3;
+	rootparam[4].Descriptor.RegisterSpace = 0;
+
+	//GPU Ű  ȷƮ, Ͱ Ӹ   ּҸ  ѱ
+	rootparam[5].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	rootparam[5].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+	rootparam[5].Descriptor.ShaderRegister = 4;
+	rootparam[5].Descriptor.RegisterSpace = 0;
+
+	//Ƽ , ؽó 2 ̺ ´
+	rootparam[6].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	rootparam[6].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+	rootparam[6].Descriptor.ShaderRegister = 2;
+	rootparam[6].Descriptor.RegisterSpace = 0;
 
 	//Ʈ ñ״
 	D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
 
 	rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 	rootSignatureDesc.pParameters = rootparam;
-	rootSignatureDesc.NumParameters = 5;
+	rootSignatureDesc.NumParameters = 7;
 
 	D3D12_STATIC_SAMPLER_DESC samplerDesc[3] = {};
 
@@ -391,59 +513,6 @@ HRESULT PMXRenderer::CreateRootSignature()
 	return result;
 }
 
-HRESULT PMXRenderer::CreateParameterBufferAndHeap()
-{
-	int parameterBufferSize = sizeof(ParameterBuffer);
-	parameterBufferSize = (parameterBufferSize + 0xff) & ~0xff;
-
-	auto result = _dx12.Device()->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(parameterBufferSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(mParameterBuffer.ReleaseAndGetAddressOf())
-	);
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	result = mParameterBuffer->Map(0, nullptr, (void**)&mMappedParameterBuffer);
-
-	if (FAILED(result))
-	{
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	mMappedParameterBuffer->bloomThreshold = 1.0f;
-
-	D3D12_DESCRIPTOR_HEAP_DESC parameterDescHeapDesc = {};
-	parameterDescHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	parameterDescHeapDesc.NodeMask = 0;
-	parameterDescHeapDesc.NumDescriptors = 1;
-	parameterDescHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-
-	result = _dx12.Device()->CreateDescriptorHeap(&parameterDescHeapDesc, IID_PPV_ARGS(mParameterHeap.ReleaseAndGetAddressOf()));
-	if (FAILED(result)) {
-		assert(SUCCEEDED(result));
-		return result;
-	}
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC parameterConstantBufferViewDesc = {};
-	parameterConstantBufferViewDesc.BufferLocation = mParameterBuffer->GetGPUVirtualAddress();
-	parameterConstantBufferViewDesc.SizeInBytes = parameterBufferSize;
-
-	auto parameterDescHeapHandle = mParameterHeap->GetCPUDescriptorHandleForHeapStart();
-
-	_dx12.Device()->CreateConstantBufferView(&parameterConstantBufferViewDesc, parameterDescHeapHandle);
-
-	return S_OK;
-}
-
 bool PMXRenderer::CheckShaderCompileResult(HRESULT result, ID3DBlob* error)
 {
 	if (FAILED(result)) {
@@ -469,67 +538,92 @@ PMXRenderer::PMXRenderer(Dx12Wrapper& dx12):
 {
 	assert(SUCCEEDED(CreateRootSignature()));
 	assert(SUCCEEDED(CreateGraphicsPipelineForPMX()));
-	assert(SUCCEEDED(CreateParameterBufferAndHeap()));
+
+	mParameter.bloomThreshold = 1.0f;
 }
 
 PMXRenderer::~PMXRenderer()
 {
 }
 
+void PMXRenderer::AddFrameTasks(FrameTaskGraph& graph)
+{
+	for (auto& actor : mActors)
+	{
+		actor->AddFrameTasks(graph);
+	}
+}
+
+void PMXRenderer::PublishFrame()
+{
+	for (auto& actor : mActors)
+	{
+		actor->PublishFrame();
+	}
+}
+
 void PMXRenderer::Update()
 {
+	mParameterAddress = _dx12.UploadConstantBuffer(&mParameter, sizeof(ParameterBuffer));
+
 	for (auto& actor : mActors)
 	{
-		actor -> Update();
-		actor-> UpdateAnimation();
+		actor->UploadConstants(_dx12);
 	}
 }
 
-void PMXRenderer::BeforeDrawFromLight() const
+PMXPassPipelines PMXRenderer::BeforeDrawFromLight() const
 {
 	auto cmdList = _dx12.CommandList();
-	cmdList->SetPipelineState(mShadowPipeline.Get());
+	PMXPassPipelines pipelines = SetPipelineState(mShadowPipeline.Get(), mGpuSkinningShadowPipeline.Get());
 	cmdList->SetGraphicsRootSignature(mRootSignature.Get());
+
+	return pipelines;
 }
 
-void PMXRenderer::BeforeDrawAtForwardPipeline()
+PMXPassPipelines PMXRenderer::BeforeDrawAtForwardPipeline()
 {
 	auto cmdList = _dx12.CommandList();
-	cmdList->SetPipelineState(mForwardPipeline.Get());
+	PMXPassPipelines pipelines = SetPipelineState(mForwardPipeline.Get(), mGpuSkinningForwardPipeline.Get());
 	cmdList->SetGraphicsRootSignature(mRootSignature.Get());
+
+	return pipelines;
 }
 
-void PMXRenderer::BeforeDrawAtDeferredPipeline()
+PMXPassPipelines PMXRenderer::BeforeDrawAtDeferredPipeline()
 {
 	auto cmdList = _dx12.CommandList();
-	cmdList->SetPipelineState(mDeferredPipeline.Get());
+	PMXPassPipelines pipelines = SetPipelineState(mDeferredPipeline.Get(), mGpuSkinningDeferredPipeline.Get());
 	cmdList->SetGraphicsRootSignature(mRootSignature.Get());
 
-	cmdList->SetDescriptorHeaps(1, mParameterHeap.GetAddressOf());
-	cmdList->SetGraphicsRootDescriptorTable(4, mParameterHeap->GetGPUDescriptorHandleForHeapStart());
+	cmdList->SetGraphicsRootConstantBufferView(4, mParameterAddress);
+
+	return pipelines;
 }
 
-void PMXRenderer::BeforeDrawReflection()
+PMXPassPipelines PMXRenderer::BeforeDrawReflection()
 {
 	auto cmdList = _dx12.CommandList();
-	cmdList->SetPipelineState(mReflectionPipeline.Get());
+	PMXPassPipelines pipelines = SetPipelineState(mReflectionPipeline.Get(), mGpuSkinningReflectionPipeline.Get());
 	cmdList->SetGraphicsRootSignature(mRootSignature.Get());
 
-
+	return pipelines;
 }
 
-void PMXRenderer::DrawFromLight() const
+void PMXRenderer::DrawFromLight(const PMXPassPipelines& pipelines) const
 {
 	for (auto& actor : mActors)
 	{
+		SetPipelineStateForActor(pipelines, *actor);
 		actor->Draw(_dx12, true);
 	}
 }
 
-void PMXRenderer::Draw() const
+void PMXRenderer::Draw(const PMXPassPipelines& pipelines) const
 {
 	for (auto& actor : mActors)
 	{
+		SetPipelineStateForActor(pipelines, *actor);
 		actor->Draw(_dx12, false);
 	}
 }
@@ -537,7 +631,7 @@ void PMXRenderer::Draw() const
 void PMXRenderer::DrawOnlyDepth() const
 {
 	auto cmdList = _dx12.CommandList();
-	cmdList->SetPipelineState(mOnlyDepthPipeline.Get());
+	PMXPassPipelines pipelines = SetPipelineState(mOnlyDepthPipeline.Get(), mGpuSkinningOnlyDepthPipeline.Get());
 	cmdList->SetGraphicsRootSignature(mRootSignature.Get());
 
 	_dx12.SetOnlyDepthBuffer();
@@ -547,6 +641,7 @@ void PMXRenderer::DrawOnlyDepth() const
 
 	for (auto& actor : mActors)
 	{
+		SetPipelineStateForActor(pipelines, *actor);
 		actor->DrawOpaque(_dx12);
 	}
 }
@@ -556,7 +651,7 @@ void PMXRenderer::DrawForwardNotDepthWrite() const
 	_dx12.SetFinalRenderTarget();
 
 	auto cmdList = _dx12.CommandList();
-	cmdList->SetPipelineState(mNotDepthWriteForwardPipeline.Get());
+	PMXPassPipelines pipelines = SetPipelineState(mNotDepthWriteForwardPipeline.Get(), mGpuSkinningNotDepthWriteForwardPipeline.Get());
 	cmdList->SetGraphicsRootSignature(mRootSignature.Get());
 
 	_dx12.SetRSSetViewportsAndScissorRectsByScreenSize();
@@ -564,23 +659,39 @@ void PMXRenderer::DrawForwardNotDepthWrite() const
 	_dx12.SetSceneBuffer(0);
 	_dx12.SetLightDepthTexture(3);
 
-	cmdList->SetDescriptorHeaps(1, mParameterHeap.GetAddressOf());
-	cmdList->SetGraphicsRootDescriptorTable(4, mParameterHeap->GetGPUDescriptorHandleForHeapStart());
+	cmdList->SetGraphicsRootConstantBufferView(4, mParameterAddress);
 
 	for (auto& actor : mActors)
 	{
+		SetPipelineStateForActor(pipelines, *actor);
 		actor->Draw(_dx12, false);
 	}
 }
 
-void PMXRenderer::DrawReflection() const
+void PMXRenderer::DrawReflection(const PMXPassPipelines& pipelines) const
 {
 	for (auto& actor : mActors)
 	{
+		SetPipelineStateForActor(pipelines, *actor);
 		actor->DrawReflection(_dx12);
 	}
 }
 
+PMXPassPipelines PMXRenderer::SetPipelineState(ID3D12PipelineState* pipeline, ID3D12PipelineState* gpuSkinningPipeline) const
+{
+	_dx12.CommandList()->SetPipelineState(pipeline);
+
+	PMXPassPipelines pipelines;
+	pipelines.pipeline = pipeline;
+	pipelines.gpuSkinningPipeline = gpuSkinningPipeline;
+	return pipelines;
+}
+
+void PMXRenderer::SetPipelineStateForActor(const PMXPassPipelines& pipelines, const PMXActor& actor) const
+{
+	_dx12.CommandList()->SetPipelineState(actor.IsGpuSkinning() == true ? pipelines.gpuSkinningPipeline : pipelines.pipeline);
+}
+
 void PMXRenderer::AddActor(std::shared_ptr<PMXActor> actor)
 {
 	mActors.push_back(actor);
@@ -595,22 +706,12 @@ const PMXActor* PMXRenderer::GetActor()
 
 void PMXRenderer::SetBloomThreshold(float threshold)
 {
-	if (mMappedParameterBuffer == nullptr)
-	{
-		return;
-	}
-
-	mMappedParameterBuffer->bloomThreshold = threshold;
+	mParameter.bloomThreshold = threshold;
 }
 
 float PMXRenderer::GetBloomThreshold() const
 {
-	if (mMappedParameterBuffer == nullptr)
-	{
-		return 1.0f;
-	}
-
-	return mMappedParameterBuffer->bloomThreshold;
+	return mParameter.bloomThreshold;
 }
 
 ID3D12PipelineState* PMXRenderer::GetPipelineState()
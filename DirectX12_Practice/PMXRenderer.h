@@ -7,6 +7,15 @@
 
 class Dx12Wrapper;
 class PMXActor;
+class FrameTaskGraph;
+
+// Normal and GPU skinning twins of one pass, each actor draws with the one matching its skinning mode
+struct PMXPassPipelines
+{
+	ID3D12PipelineState* pipeline = nullptr;
+	ID3D12PipelineState* gpuSkinningPipeline = nullptr;
+};
+
 class PMXRenderer
 {
 private:
@@ -20,6 +29,12 @@ private:
 	ComPtr<ID3D12PipelineState> mForwardPipeline = nullptr;
 	ComPtr<ID3D12PipelineState> mShadowPipeline = nullptr;
 	ComPtr<ID3D12PipelineState> mReflectionPipeline = nullptr;
+	ComPtr<ID3D12PipelineState> mGpuSkinningDeferredPipeline = nullptr;
+	ComPtr<ID3D12PipelineState> mGpuSkinningOnlyDepthPipeline = nullptr;
+	ComPtr<ID3D12PipelineState> mGpuSkinningNotDepthWriteForwardPipeline = nullptr;
+	ComPtr<ID3D12PipelineState> mGpuSkinningForwardPipeline = nullptr;
+	ComPtr<ID3D12PipelineState> mGpuSkinningShadowPipeline = nullptr;
+	ComPtr<ID3D12PipelineState> mGpuSkinningReflectionPipeline = nullptr;
 	ComPtr<ID3D12RootSignature> mRootSignature = nullptr;
 
 	struct ParameterBuffer
@@ -28,36 +43,41 @@ private:
 		DirectX::XMFLOAT3 padding;
 	};
 
-	ComPtr<ID3D12Resource> mParameterBuffer = nullptr;
-	ComPtr<ID3D12DescriptorHeap> mParameterHeap = nullptr;
-	ParameterBuffer* mMappedParameterBuffer = nullptr;
+	ParameterBuffer mParameter = {};
+	D3D12_GPU_VIRTUAL_ADDRESS mParameterAddress = 0;
 
 	HRESULT CreateGraphicsPipelineForPMX();
+	HRESULT CreateGpuSkinningPipeline(D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc, ID3DBlob* vertexShader, const D3D12_INPUT_ELEMENT_DESC* inputLayout, UINT inputElementCount, ComPtr<ID3D12PipelineState>& pipeline);
 
 	HRESULT CreateRootSignature();
 
-	HRESULT CreateParameterBufferAndHeap();
-
 	bool CheckShaderCompileResult(HRESULT result, ID3DBlob* error = nullptr);
 
+	PMXPassPipelines SetPipelineState(ID3D12PipelineState* pipeline, ID3D12PipelineState* gpuSkinningPipeline) const;
+	void SetPipelineStateForActor(const PMXPassPipelines& pipelines, const PMXActor& actor) const;
+
 	std::vector<std::shared_ptr<PMXActor>> mActors;
 
 
 public:
 	PMXRenderer(Dx12Wrapper& dx12);
 	~PMXRenderer();
+	void AddFrameTasks(FrameTaskGraph& graph);
+	void PublishFrame();
+	// Uploads the parameters and the constants of the published slot of each actor for the frame being recorded
 	void Update();
 
-	void BeforeDrawFromLight() const;
-	void BeforeDrawAtForwardPipeline();
-	void BeforeDrawAtDeferredPipeline();
-	void BeforeDrawReflection();
+	// Each returns the pipelines of its pass, which the pass hands to the draw it records
+	PMXPassPipelines BeforeDrawFromLight() const;
+	PMXPassPipelines BeforeDrawAtForwardPipeline();
+	PMXPassPipelines BeforeDrawAtDeferredPipeline();
+	PMXPassPipelines BeforeDrawReflection();
 
-	void DrawFromLight() const;
-	void Draw() const;
+	void DrawFromLight(const PMXPassPipelines& pipelines) const;
+	void Draw(const PMXPassPipelines& pipelines) const;
 	void DrawOnlyDepth() const;
 	void DrawForwardNotDepthWrite() const;
-	void DrawReflection() const;
+	void DrawReflection(const PMXPassPipelines& pipelines) const;
 
 	void AddActor(std::shared_ptr<PMXActor> actor);
 	const PMXActor* GetActor();
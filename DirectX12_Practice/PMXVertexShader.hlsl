@@ -1,21 +1,73 @@
 #include "PmxShaderHeader.hlsli"
 
+struct VertexInput
+{
+#ifdef GPU_SKINNING
+	float3 pos : POSITION;
+	float3 normal : NORMAL;
+	float2 uv : TEXCOORD;
+	uint4 boneIndices : BLENDINDICES;
+	float4 boneWeights : BLENDWEIGHT;
+	float3 morphPosition : MORPHPOSITION;
+	float2 morphUV : MORPHUV;
+#else
+	float4 pos : POSITION;
+	float2 normal : NORMAL;
+	float2 uv : TEXCOORD;
+#endif
+};
+
+struct ModelVertex
+{
+	float4 pos;
+	float3 normal;
+	float2 uv;
+};
+
+ModelVertex LoadVertex(VertexInput input)
+{
+	ModelVertex vertex;
+
+#ifdef GPU_SKINNING
+	float4 pos = float4(input.pos + input.morphPosition, 1.0);
+	float3 skinnedPos = float3(0, 0, 0);
+	float3 skinnedNormal = float3(0, 0, 0);
+
+	[unroll]
+	for (uint i = 0; i < 4; i++)
+	{
+		float3x4 bone = GetBoneMatrix(input.boneIndices[i]);
+		skinnedPos += input.boneWeights[i] * mul(bone, pos);
+		skinnedNormal += input.boneWeights[i] * mul((float3x3)bone, input.normal);
+	}
+
+	vertex.pos = float4(skinnedPos, 1.0);
+	vertex.normal = normalize(skinnedNormal);
+	vertex.uv = input.uv + input.morphUV;
+#else
+	vertex.pos = DecodePosition(input.pos);
+	vertex.normal = DecodeNormal(input.normal);
+	vertex.uv = input.uv;
+#endif
+
+	return vertex;
+}
+
 Output VS(
-	float4 pos : POSITION,
-	float3 normal : NORMAL,
-	float2 uv : TEXCOORD,
+	VertexInput input,
 	uint instNo : SV_InstanceID)
 {
 	Output output;
 
-	pos = mul(world, pos);
+	ModelVertex vertex = LoadVertex(input);
+	float4 pos = mul(world, vertex.pos);
 
 	output.pos = pos;
 	output.svpos = mul(mul(proj, view), output.pos);
 	output.tpos = mul(lightCamera, output.pos);
-	output.normal = mul((float3x3)world, normal);
+	output.normal = mul((float3x3)world, vertex.normal);
 	output.vnormal = mul(view, output.normal);
-	output.uv = uv;
+	output.uv = vertex.uv;
 	output.ray = normalize(pos.xyz - eye);
 	output.instNo = instNo;
 
@@ -23,12 +75,10 @@ Output VS(
 }
 
 float4 ShadowVS(
-	float4 pos : POSITION,
-	float4 normal : NORMAL,
-	float2 uv : TEXCOORD,
+	VertexInput input,
 	uint instNo : SV_InstanceID) : SV_POSITION
 {
-	pos = mul(world, pos);
+	float4 pos = mul(world, LoadVertex(input).pos);
 
 	return mul(lightCamera, pos);
 }
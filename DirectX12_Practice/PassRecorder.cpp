@@ -0,0 +1,45 @@
+#include "PassRecorder.h"
+#include <cassert>
+
+#include "CommandBackend.h"
+
+void PassRecorder::Clear()
+{
+	mTaskGraph.Clear();
+}
+
+unsigned int PassRecorder::AddPass(const std::string& name, std::function<void()> function)
+{
+	unsigned int pass = mTaskGraph.GetTaskCount();
+
+	// No dependencies between passes, the submission order alone orders them on the GPU
+	return mTaskGraph.AddTask(name, [this, pass, function]()
+		{
+			mBackend->BeginPass(pass);
+			function();
+			mBackend->EndPass(pass);
+		});
+}
+
+void PassRecorder::Record(ICommandBackend& backend)
+{
+	assert(mBackend == nullptr);
+
+	mBackend = &backend;
+	backend.BeginFrame(mTaskGraph.GetTaskCount());
+
+	mTaskGraph.Run();
+
+	backend.Submit();
+	mBackend = nullptr;
+}
+
+bool PassRecorder::IsEmpty() const
+{
+	return mTaskGraph.IsEmpty();
+}
+
+const FrameTaskGraph& PassRecorder::GetTaskGraph() const
+{
+	return mTaskGraph;
+}
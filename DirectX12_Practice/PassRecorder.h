@@ -0,0 +1,26 @@
+#pragma once
+#include <functional>
+#include <string>
+
+#include "FrameTaskGraph.h"
+
+class ICommandBackend;
+
+// Render passes recorded in parallel on the JobSystem, each into its own command list of an ICommandBackend
+class PassRecorder
+{
+public:
+	void Clear();
+	// Passes are submitted in the order they are added, a pass must set every state it draws with
+	unsigned int AddPass(const std::string& name, std::function<void()> function);
+	// Returns once every pass is recorded and submitted
+	void Record(ICommandBackend& backend);
+
+	bool IsEmpty() const;
+	// Recording times of the last Record
+	const FrameTaskGraph& GetTaskGraph() const;
+
+private:
+	FrameTaskGraph mTaskGraph;
+	ICommandBackend* mBackend = nullptr;
+};
@@ -42,6 +42,8 @@ cbuffer SceneBuffer : register(b0)
 cbuffer Transform: register(b1)
 {
 	matrix world;
+	float4 positionOffset;
+	float4 positionScale;
 };
 
 cbuffer Material : register(b2)
@@ -57,6 +59,33 @@ cbuffer Parameter : register(b3)
     float3 padding;
 }
 
+#ifdef GPU_SKINNING
+// Three rows per bone, see GpuSkinning.h
+cbuffer BonePalette : register(b4)
+{
+    float4 bonePalette[4095];
+};
+
+float3x4 GetBoneMatrix(uint bone)
+{
+    return float3x4(bonePalette[bone * 3 + 0], bonePalette[bone * 3 + 1], bonePalette[bone * 3 + 2]);
+}
+#endif
+
+// Skinned vertices are quantized on the CPU : unorm16 position inside the frame bounds, octahedral normal
+float4 DecodePosition(float4 position)
+{
+    return float4(positionOffset.xyz + position.xyz * positionScale.xyz, 1.0);
+}
+
+float3 DecodeNormal(float2 octahedral)
+{
+    float3 normal = float3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+    float fold = saturate(-normal.z);
+    normal.xy += normal.xy >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
+
 float4 matrix_to_quaternion(matrix m)
 {
     float tr = m[0][0] + m[1][1] + m[2][2];
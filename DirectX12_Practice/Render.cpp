@@ -9,6 +9,10 @@
 #include "GeometryInstancingActor.h"
 #include "GeometryActor.h"
 #include "ImguiManager.h"
+#include "BitFlag.h"
+
+#include <cassert>
+#include <chrono>
 
 Render::Render(std::shared_ptr<Dx12Wrapper>& dx):
 mDx12(dx)
@@ -16,47 +20,235 @@ mDx12(dx)
 	mPmxRenderer.reset(new PMXRenderer(*mDx12));
 	mFbxRenderer.reset(new FBXRenderer(*mDx12));
 	mInstancingRenderer.reset(new InstancingRenderer(*mDx12));
+
+	BuildPasses();
 }
 
 void Render::Frame()
 {
+	// UI changes land before the simulation starts, so nothing edits actor state while it runs
+	UpdateImGui();
+
+	// Turning a post process off culls its passes, so the graph is compiled again
+	if (mDx12->GetPostProcessingFlag() != mRenderGraphPostProcessFlag)
+	{
+		BuildPasses();
+	}
+
+	if (mIsFrameTaskGraphDirty == true)
+	{
+		BuildFrameTaskGraph();
+	}
+
+	// Until there is a simulated frame to draw, the first one runs before recording in both modes
+	if (mIsPipelinedSimulation == false || mHasSimulatedFrame == false)
+	{
+		mFrameTaskGraph.Run();
+		PublishFrame();
+	}
+
+	if (mIsPipelinedSimulation == true)
+	{
+		mFrameTaskGraph.Start();
+	}
+
 	Update();
-	DrawStencil();
-	DrawPlanerReflection();
-	DrawShadowMap();
-	DrawOpaque();
-	PostProcess();
-	DrawFrame();
-	DrawImGui();
+	mPassRecorder.Record(*mDx12);
 	EndOfFrame();
+
+	if (mIsPipelinedSimulation == true)
+	{
+		WaitSimulation();
+	}
 }
 
 void Render::AddPMXActor(const std::shared_ptr<PMXActor>& actor) 
 {
 	mPmxRenderer->AddActor(actor);
 	mActorList.push_back(actor);
+	mIsFrameTaskGraphDirty = true;
 }
 
 void Render::AddFBXActor(const std::shared_ptr<FBXActor>& actor) 
 {
 	mFbxRenderer->AddActor(actor);
 	mActorList.push_back(actor);
+	mIsFrameTaskGraphDirty = true;
 }
 
 void Render::AddGeometryInstancingActor(const std::shared_ptr<GeometryInstancingActor>& actor) 
 {
 	mInstancingRenderer->AddActor(actor);
 	mActorList.push_back(actor);
+	mIsFrameTaskGraphDirty = true;
 }
 
 void Render::AddSSRActor(const std::shared_ptr<GeometryActor>& actor)
 {
 	mInstancingRenderer->AddActor(actor);
 	mActorList.push_back(actor);
+	mIsFrameTaskGraphDirty = true;
+}
+
+void Render::BuildPasses()
+{
+	mRenderGraphPostProcessFlag = mDx12->GetPostProcessingFlag();
+
+	const RenderGraphState renderTarget = D3D12_RESOURCE_STATE_RENDER_TARGET;
+	const RenderGraphState shaderResource = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	const RenderGraphState depthWrite = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+
+	const unsigned int backBuffer = static_cast<unsigned int>(FrameResource::BackBuffer);
+	const unsigned int color = static_cast<unsigned int>(FrameResource::Color);
+	const unsigned int normal = static_cast<unsigned int>(FrameResource::Normal);
+	const unsigned int highLuminance = static_cast<unsigned int>(FrameResource::HighLuminance);
+	const unsigned int shrinkHighLuminance = static_cast<unsigned int>(FrameResource::ShrinkHighLuminance);
+	const unsigned int shrink = static_cast<unsigned int>(FrameResource::Shrink);
+	const unsigned int bloomResult = static_cast<unsigned int>(FrameResource::BloomResult);
+	const unsigned int reflection = static_cast<unsigned int>(FrameResource::Reflection);
+	const unsigned int ssrMask = static_cast<unsigned int>(FrameResource::SsrMask);
+	const unsigned int ssr = static_cast<unsigned int>(FrameResource::Ssr);
+	const unsigned int ambientOcclusion = static_cast<unsigned int>(FrameResource::AmbientOcclusion);
+	const unsigned int depth = static_cast<unsigned int>(FrameResource::Depth);
+	const unsigned int lightDepth = static_cast<unsigned int>(FrameResource::LightDepth);
+	const unsigned int stencil = static_cast<unsigned int>(FrameResource::Stencil);
+
+	mRenderGraph.Clear();
+	mDx12->AddFrameResources(mRenderGraph);
+
+	mRenderGraph.SetOutput(backBuffer);
+	// The opaque FBX pass of the next frame reads it
+	mRenderGraph.SetOutput(ssr);
+
+	unsigned int group = mRenderGraph.AddGroup("Stencil");
+	unsigned int pass = mRenderGraph.AddPass("Stencil", group, [this]() { DrawStencil(); });
+	mRenderGraph.Write(pass, stencil, depthWrite);
+
+	group = mRenderGraph.AddGroup("Planar Reflection");
+	pass = mRenderGraph.AddPass("Planar Reflection", group, [this]() { DrawPlanerReflection(); });
+	mRenderGraph.Modify(pass, stencil, depthWrite);
+	mRenderGraph.Write(pass, reflection, renderTarget);
+
+	group = mRenderGraph.AddGroup("Shadow");
+	pass = mRenderGraph.AddPass("Shadow", group, [this]() { DrawShadowMap(); });
+	mRenderGraph.Write(pass, lightDepth, depthWrite);
+
+	group = mRenderGraph.AddGroup("Opaque FBX");
+	pass = mRenderGraph.AddPass("Opaque FBX", group, [this]() { DrawOpaqueFbx(); });
+	mRenderGraph.Read(pass, lightDepth, shaderResource);
+	mRenderGraph.Read(pass, ssr, shaderResource);
+	mRenderGraph.Write(pass, color, renderTarget);
+	mRenderGraph.Write(pass, normal, renderTarget);
+	mRenderGraph.Write(pass, highLuminance, renderTarget);
+	mRenderGraph.Write(pass, depth, depthWrite);
+
+	group = mRenderGraph.AddGroup("Instancing");
+	pass = mRenderGraph.AddPass("Instancing", group, [this]() { DrawInstancing(); });
+	mRenderGraph.Modify(pass, color, renderTarget);
+	mRenderGraph.Modify(pass, normal, renderTarget);
+	mRenderGraph.Modify(pass, highLuminance, renderTarget);
+	mRenderGraph.Modify(pass, depth, depthWrite);
+
+	pass = mRenderGraph.AddPass("SSR Mask", group, [this]() { DrawSsrMask(); });
+	mRenderGraph.Write(pass, ssrMask, renderTarget);
+	mRenderGraph.Read(pass, depth, depthWrite);
+
+	pass = mRenderGraph.AddPass("SSR", group, [this]() { DrawScreenSpaceReflection(); });
+	mRenderGraph.Read(pass, color, shaderResource);
+	mRenderGraph.Read(pass, normal, shaderResource);
+	mRenderGraph.Read(pass, ssrMask, shaderResource);
+	mRenderGraph.Read(pass, reflection, shaderResource);
+	mRenderGraph.Read(pass, depth, shaderResource);
+	mRenderGraph.Write(pass, ssr, renderTarget);
+
+	group = mRenderGraph.AddGroup("PMX");
+	pass = mRenderGraph.AddPass("PMX", group, [this]() { DrawPmx(); });
+	mRenderGraph.Read(pass, lightDepth, shaderResource);
+	mRenderGraph.Modify(pass, color, renderTarget);
+	mRenderGraph.Modify(pass, normal, renderTarget);
+	mRenderGraph.Modify(pass, highLuminance, renderTarget);
+	mRenderGraph.Modify(pass, depth, depthWrite);
+
+	group = mRenderGraph.AddGroup("Post Process");
+	pass = mRenderGraph.AddPass("Ambient Occlusion", group, [this]() { DrawAmbientOcclusion(); });
+	mRenderGraph.Read(pass, normal, shaderResource);
+	mRenderGraph.Read(pass, depth, shaderResource);
+	mRenderGraph.Write(pass, ambientOcclusion, renderTarget);
+
+	pass = mRenderGraph.AddPass("Bloom Shrink", group, [this]() { DrawBloomShrink(); });
+	mRenderGraph.Read(pass, color, shaderResource);
+	mRenderGraph.Read(pass, highLuminance, shaderResource);
+	mRenderGraph.Write(pass, shrinkHighLuminance, renderTarget);
+	mRenderGraph.Write(pass, shrink, renderTarget);
+
+	pass = mRenderGraph.AddPass("Bloom Result", group, [this]() { DrawBloomResult(); });
+	mRenderGraph.Read(pass, highLuminance, shaderResource);
+	mRenderGraph.Read(pass, shrinkHighLuminance, shaderResource);
+	mRenderGraph.Write(pass, bloomResult, renderTarget);
+
+	// Only what the screen shader samples for the enabled effects keeps their passes
+	pass = mRenderGraph.AddPass("Frame", group, [this]() { DrawFrame(); });
+	mRenderGraph.Read(pass, color, shaderResource);
+	if ((mRenderGraphPostProcessFlag & SSAO) == SSAO)
+	{
+		mRenderGraph.Read(pass, ambientOcclusion, shaderResource);
+	}
+	if ((mRenderGraphPostProcessFlag & BLOOM) == BLOOM)
+	{
+		mRenderGraph.Read(pass, bloomResult, shaderResource);
+	}
+	mRenderGraph.Write(pass, backBuffer, renderTarget);
+
+	pass = mRenderGraph.AddPass("ImGui", group, [this]() { DrawImGui(); });
+	mRenderGraph.Modify(pass, backBuffer, renderTarget);
+
+	if (mRenderGraph.Compile() == false)
+	{
+		assert(0);
+		return;
+	}
+
+	mPassRecorder.Clear();
+
+	// Submitted in the order the graph sorted the groups, each group records into its own command list on a worker
+	for (unsigned int graphGroup : mRenderGraph.GetGroupOrder())
+	{
+		mPassRecorder.AddPass(mRenderGraph.GetGroupName(graphGroup), [this, graphGroup]()
+			{
+				mRenderGraph.ExecuteGroup(graphGroup, [this](const std::vector<RenderGraphBarrier>& barriers) { mDx12->ResourceBarrier(barriers); });
+			});
+	}
 }
 
-void Render::Update() const
+void Render::BuildFrameTaskGraph()
 {
+	mFrameTaskGraph.Clear();
+
+	// Each PMX actor is its own dependency chain writing its own buffer slots
+	mPmxRenderer->AddFrameTasks(mFrameTaskGraph);
+
+	mIsFrameTaskGraphDirty = false;
+	mHasSimulatedFrame = false;
+}
+
+void Render::WaitSimulation()
+{
+	auto waitStartTime = std::chrono::steady_clock::now();
+	mFrameTaskGraph.Wait();
+	mSimulationWaitTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitStartTime).count();
+
+	PublishFrame();
+}
+
+void Render::PublishFrame()
+{
+	mPmxRenderer->PublishFrame();
+	mHasSimulatedFrame = true;
+}
+
+void Render::Update()
+{
+	// Every constant the passes read is uploaded here for the frame about to be recorded, the PMX ones from the published slot
 	mDx12->Update();
 	mPmxRenderer->Update();
 	mFbxRenderer->Update();
@@ -72,67 +264,95 @@ void Render::DrawStencil() const
 
 void Render::DrawPlanerReflection() const
 {
-	mPmxRenderer->BeforeDrawReflection();
+	PMXPassPipelines pipelines = mPmxRenderer->BeforeDrawReflection();
 	mDx12->PreDrawReflection();
-	mPmxRenderer->DrawReflection();
+	mPmxRenderer->DrawReflection(pipelines);
 }
 
 void Render::DrawShadowMap() const
 {
-	mPmxRenderer->BeforeDrawFromLight();
+	PMXPassPipelines pipelines = mPmxRenderer->BeforeDrawFromLight();
 	mDx12->PreDrawShadow();
-	mPmxRenderer->DrawFromLight();
+	mPmxRenderer->DrawFromLight(pipelines);
 }
 
-void Render::DrawOpaque() const
+void Render::DrawOpaqueFbx() const
 {
 	mDx12->PreDrawToPera1();
 
 	mFbxRenderer->BeforeDrawAtForwardPipeline();
 	mDx12->DrawToPera1ForFbx();
 	mFbxRenderer->Draw();
+}
+
+void Render::DrawInstancing() const
+{
+	// Render targets set by the opaque FBX pass do not carry over between command lists
+	mDx12->SetFinalRenderTarget();
 
 	mInstancingRenderer->BeforeDrawAtForwardPipeline();
 	mInstancingRenderer->Draw();
+}
 
-	//Draw SSR Mask
+void Render::DrawSsrMask() const
+{
 	mInstancingRenderer->BeforeDrawAtSSRMask();
 	mInstancingRenderer->DrawSSR();
+}
 
+void Render::DrawScreenSpaceReflection() const
+{
 	mDx12->DrawScreenSpaceReflection();
 
 	//Draw SSR Object
 	//mInstancingRenderer->BeforeDrawAtSSRPipeline();
 	//mInstancingRenderer->DrawSSR();
+}
 
+void Render::DrawPmx() const
+{
 	mDx12->SetFinalRenderTarget();
 
-	mPmxRenderer->BeforeDrawAtDeferredPipeline();
+	PMXPassPipelines pipelines = mPmxRenderer->BeforeDrawAtDeferredPipeline();
 	mDx12->DrawToPera1();
-	mPmxRenderer->Draw();
+	mPmxRenderer->Draw(pipelines);
 }
 
-void Render::PostProcess() const
+void Render::DrawAmbientOcclusion() const
 {
-	mDx12->PostDrawToPera1();
 	mDx12->DrawAmbientOcclusion();
+}
+
+void Render::DrawBloomShrink() const
+{
 	mDx12->DrawShrinkTextureForBlur();
 }
 
+void Render::DrawBloomResult() const
+{
+	mDx12->DrawBloomResult();
+}
+
 void Render::DrawFrame() const
 {
 	mDx12->Clear();
 	mDx12->Draw();
 }
 
-void Render::DrawImGui()
+void Render::UpdateImGui()
 {
 	ImguiManager::Instance().StartUI();
 	ImguiManager::Instance().UpdateAndSetDrawData(mDx12);
+	ImguiManager::Instance().UpdateFrameTaskGraphWindow(mFrameTaskGraph, mIsPipelinedSimulation, mSimulationWaitTime);
+	ImguiManager::Instance().UpdateCommandRecordingWindow(mPassRecorder.GetTaskGraph(), mRenderGraph, mDx12->GetFrameWaitTime(), mDx12->GetUploadUsedSize(), mDx12->GetUploadRegionSize());
 	ImguiManager::Instance().UpdatePostProcessMenu(mDx12, mPmxRenderer);
 	ImguiManager::Instance().UpdateSaveMenu(mDx12, mFbxRenderer);
 	ImguiManager::Instance().UpdateMaterialManagerWindow(mDx12);
 	ImguiManager::Instance().UpdateActorManager(mDx12, mActorList);
+}
+
+void Render::DrawImGui() const
+{
 	ImguiManager::Instance().EndUI(mDx12);
 }
 
@@ -2,6 +2,10 @@
 #include <memory>
 #include <vector>
 
+#include "FrameTaskGraph.h"
+#include "PassRecorder.h"
+#include "RenderGraph.h"
+
 class Dx12Wrapper;
 class PMXRenderer;
 class PMXActor;
@@ -24,14 +28,25 @@ public:
 	void AddSSRActor(const std::shared_ptr<GeometryActor>& actor);
 
 private:
-	void Update() const;
+	void BuildPasses();
+	void BuildFrameTaskGraph();
+	void WaitSimulation();
+	void PublishFrame();
+	void Update();
 	void DrawStencil() const;
 	void DrawPlanerReflection() const;
 	void DrawShadowMap() const;
-	void DrawOpaque() const;
-	void PostProcess() const;
+	void DrawOpaqueFbx() const;
+	void DrawInstancing() const;
+	void DrawSsrMask() const;
+	void DrawScreenSpaceReflection() const;
+	void DrawPmx() const;
+	void DrawAmbientOcclusion() const;
+	void DrawBloomShrink() const;
+	void DrawBloomResult() const;
 	void DrawFrame() const;
-	void DrawImGui();
+	void UpdateImGui();
+	void DrawImGui() const;
 	void EndOfFrame() const;
 
 private:
@@ -41,5 +56,18 @@ private:
 	std::shared_ptr<InstancingRenderer> mInstancingRenderer = nullptr;
 
 	std::vector<std::shared_ptr<IActor>> mActorList;
+
+	FrameTaskGraph mFrameTaskGraph;
+	bool mIsFrameTaskGraphDirty = true;
+	PassRecorder mPassRecorder;
+
+	// Compiled for the post process flag it was built with, each group of it is one pass of mPassRecorder
+	RenderGraph mRenderGraph;
+	int mRenderGraphPostProcessFlag = 0;
+
+	// Frame N + 1 simulates on the workers while frame N records and executes, drawing one frame behind the simulation
+	bool mIsPipelinedSimulation = true;
+	bool mHasSimulatedFrame = false;
+	float mSimulationWaitTime = 0.0f;
 };
 
@@ -0,0 +1,481 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <cassert>
+
+const unsigned int RenderGraph::no_pass;
+
+void RenderGraph::Clear()
+{
+	mResources.clear();
+	mPasses.clear();
+	mGroups.clear();
+
+	mGroupOrder.clear();
+	mExecutionOrder.clear();
+	mFinalBarriers.clear();
+	mBarrierCount = 0;
+	mSplitBarrierCount = 0;
+}
+
+unsigned int RenderGraph::AddResource(const std::string& name, RenderGraphState state)
+{
+	Resource resource;
+	resource.name = name;
+	resource.state = state;
+	mResources.push_back(resource);
+
+	return static_cast<unsigned int>(mResources.size() - 1);
+}
+
+void RenderGraph::SetOutput(unsigned int resource)
+{
+	assert(resource < mResources.size());
+
+	mResources[resource].isOutput = true;
+}
+
+unsigned int RenderGraph::AddGroup(const std::string& name)
+{
+	Group group;
+	group.name = name;
+	mGroups.push_back(group);
+
+	return static_cast<unsigned int>(mGroups.size() - 1);
+}
+
+unsigned int RenderGraph::AddPass(const std::string& name, unsigned int group, std::function<void()> function)
+{
+	assert(group < mGroups.size());
+
+	Pass pass;
+	pass.name = name;
+	pass.group = group;
+	pass.function = std::move(function);
+	mPasses.push_back(std::move(pass));
+
+	return static_cast<unsigned int>(mPasses.size() - 1);
+}
+
+void RenderGraph::Read(unsigned int pass, unsigned int resource, RenderGraphState state)
+{
+	AddAccess(pass, resource, state, true, false);
+}
+
+void RenderGraph::Write(unsigned int pass, unsigned int resource, RenderGraphState state)
+{
+	AddAccess(pass, resource, state, false, true);
+}
+
+void RenderGraph::Modify(unsigned int pass, unsigned int resource, RenderGraphState state)
+{
+	AddAccess(pass, resource, state, true, true);
+}
+
+void RenderGraph::AddAccess(unsigned int pass, unsigned int resource, RenderGraphState state, bool isRead, bool isWrite)
+{
+	assert(pass < mPasses.size());
+	assert(resource < mResources.size());
+
+	for (Access& access : mPasses[pass].accesses)
+	{
+		if (access.resource != resource)
+		{
+			continue;
+		}
+
+		// A resource is in one state for the whole pass
+		assert(access.state == state);
+
+		access.isRead = access.isRead || isRead;
+		access.isWrite = access.isWrite || isWrite;
+		return;
+	}
+
+	Access access;
+	access.resource = resource;
+	access.state = state;
+	access.isRead = isRead;
+	access.isWrite = isWrite;
+	access.producer = no_pass;
+	mPasses[pass].accesses.push_back(access);
+}
+
+bool RenderGraph::Compile()
+{
+	AddDependencies();
+	CullPasses();
+
+	if (OrderPasses() == false)
+	{
+		return false;
+	}
+
+	AddBarriers();
+
+	return true;
+}
+
+void RenderGraph::AddDependencies()
+{
+	std::vector<unsigned int> lastWriters(mResources.size(), no_pass);
+	std::vector<std::vector<unsigned int>> readersSinceWrite(mResources.size());
+
+	auto addEdge = [this](unsigned int from, unsigned int to)
+	{
+		auto& successors = mPasses[from].successors;
+		if (std::find(successors.begin(), successors.end(), to) == successors.end())
+		{
+			successors.push_back(to);
+		}
+	};
+
+	for (Pass& pass : mPasses)
+	{
+		pass.successors.clear();
+	}
+
+	for (unsigned int i = 0; i < mPasses.size(); i++)
+	{
+		for (Access& access : mPasses[i].accesses)
+		{
+			unsigned int lastWriter = lastWriters[access.resource];
+			access.producer = lastWriter;
+
+			// Read after write and write after write
+			if (lastWriter != no_pass)
+			{
+				addEdge(lastWriter, i);
+			}
+
+			// Write after read, the readers must be done before the content is replaced
+			if (access.isWrite == true)
+			{
+				for (unsigned int reader : readersSinceWrite[access.resource])
+				{
+					if (reader != i)
+					{
+						addEdge(reader, i);
+					}
+				}
+			}
+		}
+
+		for (const Access& access : mPasses[i].accesses)
+		{
+			if (access.isWrite == true)
+			{
+				lastWriters[access.resource] = i;
+				readersSinceWrite[access.resource].clear();
+			}
+			else
+			{
+				readersSinceWrite[access.resource].push_back(i);
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < mResources.size(); i++)
+	{
+		mResources[i].lastWriter = lastWriters[i];
+	}
+}
+
+void RenderGraph::CullPasses()
+{
+	for (Pass& pass : mPasses)
+	{
+		pass.isCulled = true;
+	}
+
+	std::vector<unsigned int> pending;
+
+	for (const Resource& resource : mResources)
+	{
+		if (resource.isOutput == true && resource.lastWriter != no_pass)
+		{
+			pending.push_back(resource.lastWriter);
+		}
+	}
+
+	// A pass is kept when something kept reads what it wrote, a write that is replaced before anyone reads it keeps nothing
+	while (pending.empty() == false)
+	{
+		unsigned int index = pending.back();
+		pending.pop_back();
+
+		Pass& pass = mPasses[index];
+		if (pass.isCulled == false)
+		{
+			continue;
+		}
+
+		pass.isCulled = false;
+
+		for (const Access& access : pass.accesses)
+		{
+			if (access.isRead == true && access.producer != no_pass)
+			{
+				pending.push_back(access.producer);
+			}
+		}
+	}
+}
+
+bool RenderGraph::OrderPasses()
+{
+	mGroupOrder.clear();
+	mExecutionOrder.clear();
+
+	// Every edge goes from an earlier pass to a later one, so the order the passes were added in is already
+	// a valid order inside a group and only the groups need sorting
+	for (Group& group : mGroups)
+	{
+		group.passes.clear();
+	}
+
+	for (unsigned int i = 0; i < mPasses.size(); i++)
+	{
+		if (mPasses[i].isCulled == false)
+		{
+			mGroups[mPasses[i].group].passes.push_back(i);
+		}
+	}
+
+	std::vector<std::vector<unsigned int>> groupSuccessors(mGroups.size());
+	std::vector<unsigned int> dependencyCounts(mGroups.size(), 0);
+
+	for (const Pass& pass : mPasses)
+	{
+		if (pass.isCulled == true)
+		{
+			continue;
+		}
+
+		for (unsigned int successor : pass.successors)
+		{
+			unsigned int successorGroup = mPasses[successor].group;
+			if (mPasses[successor].isCulled == true || successorGroup == pass.group)
+			{
+				continue;
+			}
+
+			auto& successors = groupSuccessors[pass.group];
+			if (std::find(successors.begin(), successors.end(), successorGroup) == successors.end())
+			{
+				successors.push_back(successorGroup);
+				dependencyCounts[successorGroup]++;
+			}
+		}
+	}
+
+	std::vector<bool> isOrdered(mGroups.size(), false);
+	unsigned int groupCount = 0;
+
+	for (const Group& group : mGroups)
+	{
+		if (group.passes.empty() == false)
+		{
+			groupCount++;
+		}
+	}
+
+	// Kahn's algorithm, of the groups that are ready the one added first goes first so the order is stable
+	while (mGroupOrder.size() < groupCount)
+	{
+		unsigned int next = no_pass;
+
+		for (unsigned int i = 0; i < mGroups.size(); i++)
+		{
+			if (isOrdered[i] == false && mGroups[i].passes.empty() == false && dependencyCounts[i] == 0)
+			{
+				next = i;
+				break;
+			}
+		}
+
+		if (next == no_pass)
+		{
+			return false;
+		}
+
+		isOrdered[next] = true;
+		mGroupOrder.push_back(next);
+
+		for (unsigned int successor : groupSuccessors[next])
+		{
+			dependencyCounts[successor]--;
+		}
+	}
+
+	for (unsigned int group : mGroupOrder)
+	{
+		mExecutionOrder.insert(mExecutionOrder.end(), mGroups[group].passes.begin(), mGroups[group].passes.end());
+	}
+
+	return true;
+}
+
+void RenderGraph::AddBarriers()
+{
+	for (Pass& pass : mPasses)
+	{
+		pass.barriers.clear();
+	}
+
+	mFinalBarriers.clear();
+	mBarrierCount = 0;
+	mSplitBarrierCount = 0;
+
+	const unsigned int passCount = static_cast<unsigned int>(mExecutionOrder.size());
+	if (passCount == 0)
+	{
+		return;
+	}
+
+	// Position passCount is the batch after the last pass
+	auto getBatch = [this, passCount](unsigned int position) -> std::vector<RenderGraphBarrier>&
+	{
+		return position < passCount ? mPasses[mExecutionOrder[position]].barriers : mFinalBarriers;
+	};
+
+	auto getGroup = [this, passCount](unsigned int position)
+	{
+		return mPasses[mExecutionOrder[std::min(position, passCount - 1)]].group;
+	};
+
+	auto addTransition = [&](unsigned int resource, RenderGraphState before, RenderGraphState after, unsigned int lastUse, unsigned int position)
+	{
+		RenderGraphBarrier barrier;
+		barrier.resource = resource;
+		barrier.before = before;
+		barrier.after = after;
+
+		mBarrierCount++;
+
+		// With a pass in between, the transition can run alongside it. Not across groups, the halves must be in one command list
+		if (lastUse != no_pass && lastUse + 1 < position && getGroup(lastUse) == getGroup(position))
+		{
+			barrier.type = RenderGraphBarrierType::BeginOnly;
+			getBatch(lastUse + 1).push_back(barrier);
+
+			barrier.type = RenderGraphBarrierType::EndOnly;
+			getBatch(position).push_back(barrier);
+
+			mSplitBarrierCount++;
+			return;
+		}
+
+		barrier.type = RenderGraphBarrierType::Transition;
+		getBatch(position).push_back(barrier);
+	};
+
+	std::vector<RenderGraphState> states(mResources.size());
+	std::vector<unsigned int> lastUses(mResources.size(), no_pass);
+
+	for (unsigned int i = 0; i < mResources.size(); i++)
+	{
+		states[i] = mResources[i].state;
+	}
+
+	for (unsigned int position = 0; position < passCount; position++)
+	{
+		for (const Access& access : mPasses[mExecutionOrder[position]].accesses)
+		{
+			if (states[access.resource] != access.state)
+			{
+				addTransition(access.resource, states[access.resource], access.state, lastUses[access.resource], position);
+			}
+
+			states[access.resource] = access.state;
+			lastUses[access.resource] = position;
+		}
+	}
+
+	for (unsigned int i = 0; i < mResources.size(); i++)
+	{
+		if (states[i] != mResources[i].state)
+		{
+			addTransition(i, states[i], mResources[i].state, lastUses[i], passCount);
+		}
+	}
+}
+
+const std::vector<unsigned int>& RenderGraph::GetGroupOrder() const
+{
+	return mGroupOrder;
+}
+
+void RenderGraph::ExecuteGroup(unsigned int group, const std::function<void(const std::vector<RenderGraphBarrier>&)>& recordBarriers) const
+{
+	assert(group < mGroups.size());
+
+	for (unsigned int index : mGroups[group].passes)
+	{
+		const Pass& pass = mPasses[index];
+
+		if (pass.barriers.empty() == false)
+		{
+			recordBarriers(pass.barriers);
+		}
+
+		if (pass.function)
+		{
+			pass.function();
+		}
+	}
+
+	if (mGroupOrder.empty() == false && mGroupOrder.back() == group && mFinalBarriers.empty() == false)
+	{
+		recordBarriers(mFinalBarriers);
+	}
+}
+
+const std::string& RenderGraph::GetGroupName(unsigned int group) const
+{
+	return mGroups[group].name;
+}
+
+const std::string& RenderGraph::GetPassName(unsigned int pass) const
+{
+	return mPasses[pass].name;
+}
+
+const std::string& RenderGraph::GetResourceName(unsigned int resource) const
+{
+	return mResources[resource].name;
+}
+
+unsigned int RenderGraph::GetPassCount() const
+{
+	return static_cast<unsigned int>(mPasses.size());
+}
+
+bool RenderGraph::IsCulled(unsigned int pass) const
+{
+	return mPasses[pass].isCulled;
+}
+
+const std::vector<unsigned int>& RenderGraph::GetExecutionOrder() const
+{
+	return mExecutionOrder;
+}
+
+const std::vector<RenderGraphBarrier>& RenderGraph::GetBarriers(unsigned int pass) const
+{
+	return mPasses[pass].barriers;
+}
+
+const std::vector<RenderGraphBarrier>& RenderGraph::GetFinalBarriers() const
+{
+	return mFinalBarriers;
+}
+
+unsigned int RenderGraph::GetBarrierCount() const
+{
+	return mBarrierCount;
+}
+
+unsigned int RenderGraph::GetSplitBarrierCount() const
+{
+	return mSplitBarrierCount;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// Opaque to the graph, D3D12_RESOURCE_STATES in the renderer
+using RenderGraphState = unsigned int;
+
+enum class RenderGraphBarrierType
+{
+	Transition,
+	// Split barrier halves, the begin half right after the last use and the end half right before the next one
+	BeginOnly,
+	EndOnly,
+};
+
+struct RenderGraphBarrier
+{
+	unsigned int resource;
+	RenderGraphState before;
+	RenderGraphState after;
+	RenderGraphBarrierType type;
+};
+
+// Passes declare the resources they read and write, Compile culls the passes nothing reads from,
+// orders the rest by their dependencies and derives one barrier batch per pass.
+// A group of passes is recorded into one command list, so split barriers never leave a group
+class RenderGraph
+{
+public:
+	void Clear();
+
+	// Resources live across frames and are in state between them, the graph puts them back after their last use
+	unsigned int AddResource(const std::string& name, RenderGraphState state);
+	// Read after the frame, like the back buffer, so the passes writing it are never culled
+	void SetOutput(unsigned int resource);
+
+	unsigned int AddGroup(const std::string& name);
+	// What a pass reads is what the passes added before it wrote
+	unsigned int AddPass(const std::string& name, unsigned int group, std::function<void()> function);
+	void Read(unsigned int pass, unsigned int resource, RenderGraphState state);
+	// Replaces the whole content, like a cleared render target
+	void Write(unsigned int pass, unsigned int resource, RenderGraphState state);
+	// Reads what earlier passes wrote and writes on top of it, like blending into a render target
+	void Modify(unsigned int pass, unsigned int resource, RenderGraphState state);
+
+	// False when the groups depend on each other in a cycle
+	bool Compile();
+
+	// Groups with a pass left after culling, in the order their command lists are submitted
+	const std::vector<unsigned int>& GetGroupOrder() const;
+	// Runs the passes of group in order, each after handing its barrier batch to recordBarriers.
+	// The last group also hands over the batch that puts every resource back in its state
+	void ExecuteGroup(unsigned int group, const std::function<void(const std::vector<RenderGraphBarrier>&)>& recordBarriers) const;
+
+	const std::string& GetGroupName(unsigned int group) const;
+	const std::string& GetPassName(unsigned int pass) const;
+	const std::string& GetResourceName(unsigned int resource) const;
+	unsigned int GetPassCount() const;
+	bool IsCulled(unsigned int pass) const;
+	const std::vector<unsigned int>& GetExecutionOrder() const;
+	const std::vector<RenderGraphBarrier>& GetBarriers(unsigned int pass) const;
+	const std::vector<RenderGraphBarrier>& GetFinalBarriers() const;
+	unsigned int GetBarrierCount() const;
+	unsigned int GetSplitBarrierCount() const;
+
+private:
+	static const unsigned int no_pass = ~0u;
+
+	struct Resource
+	{
+		std::string name;
+		RenderGraphState state;
+		bool isOutput = false;
+		// Pass whose write is what the resource holds at the end of the frame
+		unsigned int lastWriter = no_pass;
+	};
+
+	struct Access
+	{
+		unsigned int resource;
+		RenderGraphState state;
+		bool isRead = false;
+		bool isWrite = false;
+		// Pass that wrote what this access reads, no_pass when it was written before the frame
+		unsigned int producer;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		unsigned int group;
+		std::function<void()> function;
+		std::vector<Access> accesses;
+		std::vector<unsigned int> successors;
+		bool isCulled = false;
+		std::vector<RenderGraphBarrier> barriers;
+	};
+
+	struct Group
+	{
+		std::string name;
+		std::vector<unsigned int> passes;
+	};
+
+	void AddAccess(unsigned int pass, unsigned int resource, RenderGraphState state, bool isRead, bool isWrite);
+	void AddDependencies();
+	void CullPasses();
+	bool OrderPasses();
+	void AddBarriers();
+
+	std::vector<Resource> mResources;
+	std::vector<Pass> mPasses;
+	std::vector<Group> mGroups;
+
+	std::vector<unsigned int> mGroupOrder;
+	std::vector<unsigned int> mExecutionOrder;
+	std::vector<RenderGraphBarrier> mFinalBarriers;
+	unsigned int mBarrierCount = 0;
+	unsigned int mSplitBarrierCount = 0;
+};
@@ -3,11 +3,14 @@
 
 float4 ps(Output input) : SV_TARGET
 {
+#ifdef BLOOM
+	// The bloom pass is culled without BLOOM, so the inset only reads it when it was drawn this frame
 	if (input.uv.x < 0.2 && input.uv.y >= 0.6 && input.uv.y < 0.8)
 	{
 		float3 texBloom = texBloomResult.Sample(smp, (input.uv - float2(0, 0.6)) * 5);
 		return float4(texBloom, 1);
 	}
+#endif
 
 	float w, h, levels;
 	tex.GetDimensions(0, w, h, levels);
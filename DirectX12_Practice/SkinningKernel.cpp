@@ -0,0 +1,436 @@
+#include "SkinningKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include <intrin.h>
+#include <DirectXPackedVector.h>
+
+namespace
+{
+	struct SSE2Traits
+	{
+		using Vector = __m128;
+		static constexpr unsigned int width = 4;
+
+		static Vector Zero() { return _mm_setzero_ps(); }
+		static Vector Load(const float* source) { return _mm_loadu_ps(source); }
+		static void StoreInt(int* destination, Vector value) { _mm_store_si128(reinterpret_cast<__m128i*>(destination), _mm_cvtps_epi32(value)); }
+		static Vector MultiplyAdd(Vector a, Vector b, Vector c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+		static Vector Multiply(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+		static Vector Add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+		static Vector Subtract(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+		static Vector Divide(Vector a, Vector b) { return _mm_div_ps(a, b); }
+		static Vector Min(Vector a, Vector b) { return _mm_min_ps(a, b); }
+		static Vector Max(Vector a, Vector b) { return _mm_max_ps(a, b); }
+		static Vector Set(float value) { return _mm_set1_ps(value); }
+		static Vector Abs(Vector a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+		static Vector CopySign(Vector magnitude, Vector sign) { return _mm_or_ps(magnitude, _mm_and_ps(_mm_set1_ps(-0.0f), sign)); }
+		static Vector SelectNegative(Vector condition, Vector a, Vector b)
+		{
+			Vector mask = _mm_cmplt_ps(condition, _mm_setzero_ps());
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		static void GatherPalette(const float* palette, const int* boneIndices, Vector(&rows)[skinningPaletteStride])
+		{
+			const float* m0 = palette + boneIndices[0] * skinningPaletteStride;
+			const float* m1 = palette + boneIndices[1] * skinningPaletteStride;
+			const float* m2 = palette + boneIndices[2] * skinningPaletteStride;
+			const float* m3 = palette + boneIndices[3] * skinningPaletteStride;
+
+			for (unsigned int c = 0; c < skinningPaletteStride; c++)
+			{
+				rows[c] = _mm_setr_ps(m0[c], m1[c], m2[c], m3[c]);
+			}
+		}
+	};
+
+	struct AVX2Traits
+	{
+		using Vector = __m256;
+		static constexpr unsigned int width = 8;
+
+		static Vector Zero() { return _mm256_setzero_ps(); }
+		static Vector Load(const float* source) { return _mm256_loadu_ps(source); }
+		static void StoreInt(int* destination, Vector value) { _mm256_store_si256(reinterpret_cast<__m256i*>(destination), _mm256_cvtps_epi32(value)); }
+		static Vector MultiplyAdd(Vector a, Vector b, Vector c) { return _mm256_fmadd_ps(a, b, c); }
+		static Vector Multiply(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+		static Vector Add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+		static Vector Subtract(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+		static Vector Divide(Vector a, Vector b) { return _mm256_div_ps(a, b); }
+		static Vector Min(Vector a, Vector b) { return _mm256_min_ps(a, b); }
+		static Vector Max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+		static Vector Set(float value) { return _mm256_set1_ps(value); }
+		static Vector Abs(Vector a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		static Vector CopySign(Vector magnitude, Vector sign) { return _mm256_or_ps(magnitude, _mm256_and_ps(_mm256_set1_ps(-0.0f), sign)); }
+		static Vector SelectNegative(Vector condition, Vector a, Vector b) { return _mm256_blendv_ps(b, a, _mm256_cmp_ps(condition, _mm256_setzero_ps(), _CMP_LT_OQ)); }
+
+		static void GatherPalette(const float* palette, const int* boneIndices, Vector(&rows)[skinningPaletteStride])
+		{
+			__m256i index = _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(boneIndices)), _mm256_set1_epi32(skinningPaletteStride));
+
+			for (unsigned int c = 0; c < skinningPaletteStride; c++)
+			{
+				rows[c] = _mm256_i32gather_ps(palette + c, index, 4);
+			}
+		}
+	};
+
+	struct AVX512Traits
+	{
+		using Vector = __m512;
+		static constexpr unsigned int width = 16;
+
+		static Vector Zero() { return _mm512_setzero_ps(); }
+		static Vector Load(const float* source) { return _mm512_loadu_ps(source); }
+		static void StoreInt(int* destination, Vector value) { _mm512_store_si512(destination, _mm512_cvtps_epi32(value)); }
+		static Vector MultiplyAdd(Vector a, Vector b, Vector c) { return _mm512_fmadd_ps(a, b, c); }
+		static Vector Multiply(Vector a, Vector b) { return _mm512_mul_ps(a, b); }
+		static Vector Add(Vector a, Vector b) { return _mm512_add_ps(a, b); }
+		static Vector Subtract(Vector a, Vector b) { return _mm512_sub_ps(a, b); }
+		static Vector Divide(Vector a, Vector b) { return _mm512_div_ps(a, b); }
+		static Vector Min(Vector a, Vector b) { return _mm512_min_ps(a, b); }
+		static Vector Max(Vector a, Vector b) { return _mm512_max_ps(a, b); }
+		static Vector Set(float value) { return _mm512_set1_ps(value); }
+		// Float bitwise operations need AVX-512DQ, the integer ones are AVX-512F
+		static Vector Abs(Vector a) { return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff))); }
+		static Vector CopySign(Vector magnitude, Vector sign)
+		{
+			__m512i signBit = _mm512_and_epi32(_mm512_castps_si512(sign), _mm512_set1_epi32(0x80000000));
+			return _mm512_castsi512_ps(_mm512_or_epi32(_mm512_castps_si512(magnitude), signBit));
+		}
+		static Vector SelectNegative(Vector condition, Vector a, Vector b) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(condition, _mm512_setzero_ps(), _CMP_LT_OQ), b, a); }
+
+		static void GatherPalette(const float* palette, const int* boneIndices, Vector(&rows)[skinningPaletteStride])
+		{
+			__m512i index = _mm512_mullo_epi32(_mm512_loadu_si512(boneIndices), _mm512_set1_epi32(skinningPaletteStride));
+
+			for (unsigned int c = 0; c < skinningPaletteStride; c++)
+			{
+				rows[c] = _mm512_i32gather_ps(index, palette + c, 4);
+			}
+		}
+	};
+
+	// Projects onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the diagonals
+	// Dividing by the L1 length also renormalizes normals shortened by blending
+	template<typename Traits>
+	void EncodeOctahedral(typename Traits::Vector x, typename Traits::Vector y, typename Traits::Vector z, typename Traits::Vector& outX, typename Traits::Vector& outY)
+	{
+		using Vector = typename Traits::Vector;
+
+		Vector length = Traits::Add(Traits::Abs(x), Traits::Add(Traits::Abs(y), Traits::Add(Traits::Abs(z), Traits::Set(1e-20f))));
+		Vector inverseLength = Traits::Divide(Traits::Set(1.0f), length);
+		Vector octX = Traits::Multiply(x, inverseLength);
+		Vector octY = Traits::Multiply(y, inverseLength);
+
+		Vector foldX = Traits::CopySign(Traits::Subtract(Traits::Set(1.0f), Traits::Abs(octY)), octX);
+		Vector foldY = Traits::CopySign(Traits::Subtract(Traits::Set(1.0f), Traits::Abs(octX)), octY);
+
+		outX = Traits::SelectNegative(z, foldX, octX);
+		outY = Traits::SelectNegative(z, foldY, octY);
+	}
+
+	template<typename Traits, unsigned int influenceCount, bool skinNormal>
+	void SkinningByTraits(const SkinningStream& stream, const float* palette, unsigned int startIndex, unsigned int endIndex, const SkinningOutput& output)
+	{
+		using Vector = typename Traits::Vector;
+		constexpr unsigned int width = Traits::width;
+
+		alignas(64) int lanes[5][width];
+
+		const VertexQuantization& quantization = output.quantization;
+		Vector inverseScale[3];
+		Vector bias[3];
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			float inverse = 1.0f / quantization.scale[c];
+			inverseScale[c] = Traits::Set(inverse);
+			bias[c] = Traits::Set(-quantization.offset[c] * inverse);
+		}
+
+		for (unsigned int i = startIndex; i < endIndex; i += width)
+		{
+			Vector px = Traits::Load(&stream.positionX[i]);
+			Vector py = Traits::Load(&stream.positionY[i]);
+			Vector pz = Traits::Load(&stream.positionZ[i]);
+			Vector nx = Traits::Load(&stream.normalX[i]);
+			Vector ny = Traits::Load(&stream.normalY[i]);
+			Vector nz = Traits::Load(&stream.normalZ[i]);
+
+			Vector resultPx = Traits::Zero();
+			Vector resultPy = Traits::Zero();
+			Vector resultPz = Traits::Zero();
+			Vector resultNx = Traits::Zero();
+			Vector resultNy = Traits::Zero();
+			Vector resultNz = Traits::Zero();
+
+			for (unsigned int k = 0; k < influenceCount; k++)
+			{
+				Vector m[skinningPaletteStride];
+				Traits::GatherPalette(palette, &stream.boneIndices[k][i], m);
+
+				Vector tx = Traits::MultiplyAdd(px, m[0], Traits::MultiplyAdd(py, m[3], Traits::MultiplyAdd(pz, m[6], m[9])));
+				Vector ty = Traits::MultiplyAdd(px, m[1], Traits::MultiplyAdd(py, m[4], Traits::MultiplyAdd(pz, m[7], m[10])));
+				Vector tz = Traits::MultiplyAdd(px, m[2], Traits::MultiplyAdd(py, m[5], Traits::MultiplyAdd(pz, m[8], m[11])));
+				Vector tnx = nx;
+				Vector tny = ny;
+				Vector tnz = nz;
+
+				if (skinNormal == true)
+				{
+					tnx = Traits::MultiplyAdd(nx, m[0], Traits::MultiplyAdd(ny, m[3], Traits::Multiply(nz, m[6])));
+					tny = Traits::MultiplyAdd(nx, m[1], Traits::MultiplyAdd(ny, m[4], Traits::Multiply(nz, m[7])));
+					tnz = Traits::MultiplyAdd(nx, m[2], Traits::MultiplyAdd(ny, m[5], Traits::Multiply(nz, m[8])));
+				}
+
+				if (influenceCount == 1)
+				{
+					resultPx = tx;
+					resultPy = ty;
+					resultPz = tz;
+					resultNx = tnx;
+					resultNy = tny;
+					resultNz = tnz;
+					continue;
+				}
+
+				Vector weight = Traits::Load(&stream.boneWeights[k][i]);
+				resultPx = Traits::MultiplyAdd(weight, tx, resultPx);
+				resultPy = Traits::MultiplyAdd(weight, ty, resultPy);
+				resultPz = Traits::MultiplyAdd(weight, tz, resultPz);
+				resultNx = Traits::MultiplyAdd(weight, tnx, resultNx);
+				resultNy = Traits::MultiplyAdd(weight, tny, resultNy);
+				resultNz = Traits::MultiplyAdd(weight, tnz, resultNz);
+			}
+
+			Vector limit = Traits::Set(65535.0f);
+			Traits::StoreInt(lanes[0], Traits::Min(Traits::Max(Traits::MultiplyAdd(resultPx, inverseScale[0], bias[0]), Traits::Zero()), limit));
+			Traits::StoreInt(lanes[1], Traits::Min(Traits::Max(Traits::MultiplyAdd(resultPy, inverseScale[1], bias[1]), Traits::Zero()), limit));
+			Traits::StoreInt(lanes[2], Traits::Min(Traits::Max(Traits::MultiplyAdd(resultPz, inverseScale[2], bias[2]), Traits::Zero()), limit));
+
+			Vector octX;
+			Vector octY;
+			EncodeOctahedral<Traits>(resultNx, resultNy, resultNz, octX, octY);
+			Traits::StoreInt(lanes[3], Traits::Multiply(octX, Traits::Set(32767.0f)));
+			Traits::StoreInt(lanes[4], Traits::Multiply(octY, Traits::Set(32767.0f)));
+
+			for (unsigned int lane = 0; lane < width; lane++)
+			{
+				QuantizedVertex& vertex = output.vertices[i + lane];
+				vertex.position[0] = static_cast<unsigned short>(lanes[0][lane]);
+				vertex.position[1] = static_cast<unsigned short>(lanes[1][lane]);
+				vertex.position[2] = static_cast<unsigned short>(lanes[2][lane]);
+				vertex.position[3] = 0;
+				vertex.normal[0] = static_cast<short>(lanes[3][lane]);
+				vertex.normal[1] = static_cast<short>(lanes[4][lane]);
+				std::memcpy(vertex.uv, &stream.uv[i + lane], sizeof(vertex.uv));
+			}
+		}
+	}
+
+	template<typename Traits, bool skinNormal>
+	void SkinningByInfluence(unsigned int influenceCount, const SkinningStream& stream, const float* palette, unsigned int startIndex, unsigned int endIndex, const SkinningOutput& output)
+	{
+		switch (influenceCount)
+		{
+		case 1:
+			SkinningByTraits<Traits, 1, skinNormal>(stream, palette, startIndex, endIndex, output);
+			break;
+		case 2:
+			SkinningByTraits<Traits, 2, skinNormal>(stream, palette, startIndex, endIndex, output);
+			break;
+		default:
+			SkinningByTraits<Traits, 4, skinNormal>(stream, palette, startIndex, endIndex, output);
+			break;
+		}
+	}
+
+	template<typename Traits>
+	void SkinningByNormal(bool skinNormal, unsigned int influenceCount, const SkinningStream& stream, const float* palette, unsigned int startIndex, unsigned int endIndex, const SkinningOutput& output)
+	{
+		if (skinNormal == true)
+		{
+			SkinningByInfluence<Traits, true>(influenceCount, stream, palette, startIndex, endIndex, output);
+		}
+		else
+		{
+			SkinningByInfluence<Traits, false>(influenceCount, stream, palette, startIndex, endIndex, output);
+		}
+	}
+}
+
+namespace SkinningKernel
+{
+	SkinningKernelType DetectKernelType()
+	{
+		static const SkinningKernelType detectedType = []()
+		{
+			int info[4];
+			__cpuid(info, 0);
+			int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			bool fma = (info[2] & (1 << 12)) != 0;
+
+			if (osxsave == false || avx == false || maxLeaf < 7)
+			{
+				return SkinningKernelType::SSE2;
+			}
+
+			// The OS has to save YMM (and opmask / ZMM) state on context switch
+			unsigned long long xcr0 = _xgetbv(0);
+			if ((xcr0 & 0x6) != 0x6)
+			{
+				return SkinningKernelType::SSE2;
+			}
+
+			__cpuidex(info, 7, 0);
+			bool avx2 = (info[1] & (1 << 5)) != 0;
+			bool avx512f = (info[1] & (1 << 16)) != 0;
+
+			if (avx512f == true && (xcr0 & 0xe6) == 0xe6)
+			{
+				return SkinningKernelType::AVX512;
+			}
+
+			if (avx2 == true && fma == true)
+			{
+				return SkinningKernelType::AVX2;
+			}
+
+			return SkinningKernelType::SSE2;
+		}();
+
+		return detectedType;
+	}
+
+	unsigned int GetKernelWidth(SkinningKernelType type)
+	{
+		switch (type)
+		{
+		case SkinningKernelType::AVX2:
+			return AVX2Traits::width;
+		case SkinningKernelType::AVX512:
+			return AVX512Traits::width;
+		default:
+			return SSE2Traits::width;
+		}
+	}
+
+	const char* GetKernelName(SkinningKernelType type)
+	{
+		switch (type)
+		{
+		case SkinningKernelType::AVX2:
+			return "AVX2";
+		case SkinningKernelType::AVX512:
+			return "AVX-512";
+		default:
+			return "SSE2";
+		}
+	}
+
+	void ResizeStream(SkinningStream& stream, unsigned int vertexCount)
+	{
+		unsigned int paddedCount = (vertexCount + skinningStreamAlignment - 1) / skinningStreamAlignment * skinningStreamAlignment;
+
+		stream.vertexCount = vertexCount;
+		stream.positionX.assign(paddedCount, 0.0f);
+		stream.positionY.assign(paddedCount, 0.0f);
+		stream.positionZ.assign(paddedCount, 0.0f);
+		stream.normalX.assign(paddedCount, 0.0f);
+		stream.normalY.assign(paddedCount, 0.0f);
+		stream.normalZ.assign(paddedCount, 0.0f);
+		stream.uv.assign(paddedCount, 0);
+
+		for (unsigned int k = 0; k < 4; k++)
+		{
+			stream.boneIndices[k].assign(paddedCount, 0);
+			stream.boneWeights[k].assign(paddedCount, 0.0f);
+		}
+	}
+
+	VertexQuantization CreateQuantization(const float* boundsMin, const float* boundsMax)
+	{
+		VertexQuantization quantization;
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			quantization.offset[c] = boundsMin[c];
+			quantization.scale[c] = (std::max)(boundsMax[c] - boundsMin[c], 1e-6f) / 65535.0f;
+		}
+
+		return quantization;
+	}
+
+	unsigned int PackUV(float u, float v)
+	{
+		return DirectX::PackedVector::XMConvertFloatToHalf(u) | (static_cast<unsigned int>(DirectX::PackedVector::XMConvertFloatToHalf(v)) << 16);
+	}
+
+	void EncodeVertex(const float* position, const float* normal, unsigned int packedUV, const VertexQuantization& quantization, QuantizedVertex& vertex)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			float inverse = 1.0f / quantization.scale[c];
+			float value = position[c] * inverse - quantization.offset[c] * inverse;
+			vertex.position[c] = static_cast<unsigned short>(std::nearbyint((std::min)((std::max)(value, 0.0f), 65535.0f)));
+		}
+		vertex.position[3] = 0;
+
+		float length = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]) + 1e-20f;
+		float octX = normal[0] / length;
+		float octY = normal[1] / length;
+
+		if (normal[2] < 0.0f)
+		{
+			float foldX = std::copysign(1.0f - std::abs(octY), octX);
+			float foldY = std::copysign(1.0f - std::abs(octX), octY);
+			octX = foldX;
+			octY = foldY;
+		}
+
+		vertex.normal[0] = static_cast<short>(std::nearbyint(octX * 32767.0f));
+		vertex.normal[1] = static_cast<short>(std::nearbyint(octY * 32767.0f));
+		std::memcpy(vertex.uv, &packedUV, sizeof(vertex.uv));
+	}
+
+	void DecodeVertex(const QuantizedVertex& vertex, const VertexQuantization& quantization, float* position, float* normal)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			position[c] = quantization.offset[c] + vertex.position[c] * quantization.scale[c];
+		}
+
+		float x = (std::max)(vertex.normal[0] / 32767.0f, -1.0f);
+		float y = (std::max)(vertex.normal[1] / 32767.0f, -1.0f);
+		float z = 1.0f - std::abs(x) - std::abs(y);
+		float fold = (std::max)(-z, 0.0f);
+		x += x >= 0.0f ? -fold : fold;
+		y += y >= 0.0f ? -fold : fold;
+
+		float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+		normal[0] = x * inverseLength;
+		normal[1] = y * inverseLength;
+		normal[2] = z * inverseLength;
+	}
+
+	void Skinning(SkinningKernelType type, unsigned int influenceCount, const SkinningStream& stream, const float* palette, unsigned int startIndex, unsigned int endIndex, const SkinningOutput& output, bool skinNormal)
+	{
+		switch (type)
+		{
+		case SkinningKernelType::AVX2:
+			SkinningByNormal<AVX2Traits>(skinNormal, influenceCount, stream, palette, startIndex, endIndex, output);
+			break;
+		case SkinningKernelType::AVX512:
+			SkinningByNormal<AVX512Traits>(skinNormal, influenceCount, stream, palette, startIndex, endIndex, output);
+			break;
+		default:
+			SkinningByNormal<SSE2Traits>(skinNormal, influenceCount, stream, palette, startIndex, endIndex, output);
+			break;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+
+enum class SkinningKernelType
+{
+	SSE2,
+	AVX2,
+	AVX512,
+};
+
+// Linear blend vertices in structure of arrays layout, padded to a multiple of the widest kernel
+struct SkinningStream
+{
+	unsigned int vertexCount = 0;
+
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> normalX;
+	std::vector<float> normalY;
+	std::vector<float> normalZ;
+	std::vector<unsigned int> uv;		// half x | half y << 16
+
+	std::vector<int> boneIndices[4];
+	std::vector<float> boneWeights[4];
+};
+
+// 16 byte skinned vertex : unorm16 position inside the frame bounds, octahedral snorm16 normal, half uv
+struct QuantizedVertex
+{
+	unsigned short position[4];
+	short normal[2];
+	unsigned short uv[2];
+};
+
+// Decoded position = offset + unorm16 * scale
+struct VertexQuantization
+{
+	float offset[3];
+	float scale[3];
+};
+
+struct SkinningOutput
+{
+	QuantizedVertex* vertices;
+	VertexQuantization quantization;
+};
+
+// Palette entry per bone : row0.xyz row1.xyz row2.xyz row3.xyz of the row vector skinning matrix
+constexpr unsigned int skinningPaletteStride = 12;
+constexpr unsigned int skinningStreamAlignment = 16;
+
+namespace SkinningKernel
+{
+	SkinningKernelType DetectKernelType();
+	unsigned int GetKernelWidth(SkinningKernelType type);
+	const char* GetKernelName(SkinningKernelType type);
+
+	void ResizeStream(SkinningStream& stream, unsigned int vertexCount);
+
+	VertexQuantization CreateQuantization(const float* boundsMin, const float* boundsMax);
+	unsigned int PackUV(float u, float v);
+	// Positions outside the bounds are clamped to them
+	void EncodeVertex(const float* position, const float* normal, unsigned int packedUV, const VertexQuantization& quantization, QuantizedVertex& vertex);
+	void DecodeVertex(const QuantizedVertex& vertex, const VertexQuantization& quantization, float* position, float* normal);
+
+	// [startIndex, endIndex) must be whole blocks of GetKernelWidth(type) vertices
+	// Blended normals are renormalized, skinNormal = false passes the bind normal through for measurement
+	void Skinning(SkinningKernelType type, unsigned int influenceCount, const SkinningStream& stream, const float* palette, unsigned int startIndex, unsigned int endIndex, const SkinningOutput& output, bool skinNormal = true);
+}
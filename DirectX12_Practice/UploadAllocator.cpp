@@ -0,0 +1,132 @@
+#include "UploadAllocator.h"
+#include <cassert>
+#include <algorithm>
+#include <d3dx12.h>
+
+HRESULT UploadAllocator::Initialize(ID3D12Device* device, size_t regionSize, unsigned int regionCount)
+{
+	size_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	mRegionSize = (regionSize + alignment - 1) & ~(alignment - 1);
+	mRegionCount = regionCount;
+	mDevice = device;
+	mOverflowPages.clear();
+	mOverflowPages.resize(regionCount);
+
+	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(mRegionSize * mRegionCount);
+
+	auto result = device->CreateCommittedResource(
+		&heapProp,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(mBuffer.ReleaseAndGetAddressOf()));
+	if (FAILED(result))
+	{
+		assert(SUCCEEDED(result));
+		return result;
+	}
+
+	// Stays mapped, writes go straight to memory the GPU reads
+	result = mBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedBuffer));
+	if (FAILED(result))
+	{
+		assert(SUCCEEDED(result));
+		return result;
+	}
+
+	mBufferAddress = mBuffer->GetGPUVirtualAddress();
+
+	BeginFrame(0);
+
+	return result;
+}
+
+void UploadAllocator::BeginFrame(unsigned int region)
+{
+	assert(region < mRegionCount);
+
+	mRegion = region;
+	mOffset.store(0, std::memory_order_relaxed);
+	mOverflowPages[region].clear();
+}
+
+UploadAllocation UploadAllocator::Allocate(size_t size)
+{
+	size_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	size_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
+
+	size_t offset = mOffset.fetch_add(alignedSize, std::memory_order_relaxed);
+
+	// Checked in every build, writing past the region would overwrite a frame the GPU may still be reading
+	if (offset + alignedSize > mRegionSize)
+	{
+		return AllocateOverflow(alignedSize);
+	}
+
+	size_t bufferOffset = mRegion * mRegionSize + offset;
+
+	UploadAllocation allocation;
+	allocation.cpuAddress = mMappedBuffer + bufferOffset;
+	allocation.gpuAddress = mBufferAddress + bufferOffset;
+
+	return allocation;
+}
+
+UploadAllocation UploadAllocator::AllocateOverflow(size_t alignedSize)
+{
+	std::lock_guard<std::mutex> lock(mOverflowMutex);
+
+	std::vector<OverflowPage>& pages = mOverflowPages[mRegion];
+	if (pages.empty() == true || pages.back().offset + alignedSize > pages.back().size)
+	{
+		OverflowPage page;
+		page.size = (std::max)(mRegionSize, alignedSize);
+
+		auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(page.size);
+
+		auto result = mDevice->CreateCommittedResource(
+			&heapProp,
+			D3D12_HEAP_FLAG_NONE,
+			&resourceDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(page.buffer.ReleaseAndGetAddressOf()));
+		if (FAILED(result))
+		{
+			assert(SUCCEEDED(result));
+			return UploadAllocation();
+		}
+
+		result = page.buffer->Map(0, nullptr, reinterpret_cast<void**>(&page.mappedBuffer));
+		if (FAILED(result))
+		{
+			assert(SUCCEEDED(result));
+			return UploadAllocation();
+		}
+
+		pages.push_back(page);
+	}
+
+	OverflowPage& page = pages.back();
+
+	UploadAllocation allocation;
+	allocation.cpuAddress = page.mappedBuffer + page.offset;
+	allocation.gpuAddress = page.buffer->GetGPUVirtualAddress() + page.offset;
+
+	page.offset += alignedSize;
+
+	return allocation;
+}
+
+size_t UploadAllocator::GetUsedSize() const
+{
+	return mOffset.load(std::memory_order_relaxed);
+}
+
+size_t UploadAllocator::GetRegionSize() const
+{
+	return mRegionSize;
+}
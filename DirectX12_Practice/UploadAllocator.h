@@ -0,0 +1,58 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+struct UploadAllocation
+{
+	char* cpuAddress = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+};
+
+// One persistently mapped upload buffer cut into a region per frame in flight.
+// Per frame data is bump allocated from the region of the frame being recorded, then the whole region is reused once its fence passed.
+// A frame that outgrows its region spills into overflow pages, which live until the region comes around again
+class UploadAllocator
+{
+public:
+	HRESULT Initialize(ID3D12Device* device, size_t regionSize, unsigned int regionCount);
+
+	// The GPU must be done with the frame that last allocated from this region
+	void BeginFrame(unsigned int region);
+	// Constant buffer aligned, may be called from several recording threads at once.
+	// Returns a null cpuAddress when no overflow page could be created, callers must not bind or write it
+	UploadAllocation Allocate(size_t size);
+
+	size_t GetUsedSize() const;
+	size_t GetRegionSize() const;
+
+private:
+	template<typename T>
+	using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+	struct OverflowPage
+	{
+		ComPtr<ID3D12Resource> buffer = nullptr;
+		char* mappedBuffer = nullptr;
+		size_t size = 0;
+		size_t offset = 0;
+	};
+
+	UploadAllocation AllocateOverflow(size_t alignedSize);
+
+	ComPtr<ID3D12Device> mDevice = nullptr;
+	ComPtr<ID3D12Resource> mBuffer = nullptr;
+	char* mMappedBuffer = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS mBufferAddress = 0;
+
+	size_t mRegionSize = 0;
+	unsigned int mRegionCount = 0;
+	unsigned int mRegion = 0;
+	std::atomic<size_t> mOffset{ 0 };
+
+	// Per region, only touched once the region is full
+	std::mutex mOverflowMutex;
+	std::vector<std::vector<OverflowPage>> mOverflowPages;
+};
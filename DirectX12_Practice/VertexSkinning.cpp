@@ -0,0 +1,98 @@
+#include "VertexSkinning.h"
+
+namespace VertexSkinning
+{
+	void FillStream(const std::vector<PMXVertex>& vertices, SkinningStream& stream)
+	{
+		SkinningKernel::ResizeStream(stream, vertices.size());
+
+		for (unsigned int i = 0; i < vertices.size(); i++)
+		{
+			const PMXVertex& vertex = vertices[i];
+
+			stream.positionX[i] = vertex.position.x;
+			stream.positionY[i] = vertex.position.y;
+			stream.positionZ[i] = vertex.position.z;
+			stream.normalX[i] = vertex.normal.x;
+			stream.normalY[i] = vertex.normal.y;
+			stream.normalZ[i] = vertex.normal.z;
+			stream.uv[i] = SkinningKernel::PackUV(vertex.uv.x, vertex.uv.y);
+
+			unsigned int influenceCount = GetInfluenceCount(vertex.weightType);
+			for (unsigned int k = 0; k < influenceCount; k++)
+			{
+				stream.boneIndices[k][i] = vertex.boneIndices[k];
+				stream.boneWeights[k][i] = vertex.boneWeights[k];
+			}
+
+			if (influenceCount == 2)
+			{
+				stream.boneWeights[1][i] = 1.0f - vertex.boneWeights[0];
+			}
+		}
+	}
+
+	SdefSkinningData CreateSdefData(const PMXVertex& vertex)
+	{
+		float w0 = vertex.boneWeights[0];
+		float w1 = 1.0f - w0;
+
+		XMVECTOR sdefc = XMLoadFloat3(&vertex.sdefC);
+		XMVECTOR sdefr0 = XMLoadFloat3(&vertex.sdefR0);
+		XMVECTOR sdefr1 = XMLoadFloat3(&vertex.sdefR1);
+
+			//rw = sdefr0 * w0 + sdefr1 * w1
+			//r0 = sdefc + sdefr0 - rw
+			//r1 = sdefc + sdefr1 - rw
+
+		XMVECTOR rw = XMVectorAdd(sdefr0 * w0, sdefr1 * w1);
+		XMVECTOR r0 = XMVectorSubtract(XMVectorAdd(sdefc, sdefr0), rw);
+		XMVECTOR r1 = XMVectorSubtract(XMVectorAdd(sdefc, sdefr1), rw);
+
+			// cr0 = (sdefc + r0) * 0.5f
+			// cr1 = (sdefc + r1) * 0.5f
+
+		SdefSkinningData sdef;
+		sdef.sdefC = vertex.sdefC;
+		XMStoreFloat3(&sdef.cr0, XMVectorAdd(sdefc, r0) * 0.5f);
+		XMStoreFloat3(&sdef.cr1, XMVectorAdd(sdefc, r1) * 0.5f);
+		sdef.weight0 = w0;
+
+		return sdef;
+	}
+
+	void PackGpuVertex(const PMXVertex& vertex, const SkinningStream& stream, unsigned int vertexIndex, GpuSkinningVertex& gpuVertex)
+	{
+		int boneIndices[4] = {};
+		float boneWeights[4] = {};
+		unsigned int influenceCount = GetInfluenceCount(vertex.weightType);
+
+		for (unsigned int k = 0; k < influenceCount; k++)
+		{
+			boneIndices[k] = stream.boneIndices[k][vertexIndex];
+			boneWeights[k] = stream.boneWeights[k][vertexIndex];
+		}
+
+		GpuSkinning::PackVertex(&vertex.position.x, &vertex.normal.x, &vertex.uv.x, influenceCount, boneIndices, boneWeights, gpuVertex);
+	}
+
+	void SetPaletteBone(FXMMATRIX initInverseTransform, CXMMATRIX globalTransform, XMMATRIX& boneMatrix, XMVECTOR& rotation, XMVECTOR& dualQuaternion, float* paletteRow)
+	{
+		boneMatrix = XMMatrixMultiply(initInverseTransform, globalTransform);
+		rotation = XMQuaternionRotationMatrix(globalTransform);
+
+		// dual = 0.5 * translation * rotation
+		XMVECTOR translation = XMVectorSetW(boneMatrix.r[3], 0.0f);
+		dualQuaternion = XMVectorScale(XMQuaternionMultiply(rotation, translation), 0.5f);
+
+		XMFLOAT4X4 rows;
+		XMStoreFloat4x4(&rows, boneMatrix);
+
+		for (unsigned int row = 0; row < 4; row++)
+		{
+			paletteRow[row * 3 + 0] = rows.m[row][0];
+			paletteRow[row * 3 + 1] = rows.m[row][1];
+			paletteRow[row * 3 + 2] = rows.m[row][2];
+		}
+	}
+}
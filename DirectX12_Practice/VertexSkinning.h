@@ -0,0 +1,198 @@
+#pragma once
+#include <DirectXMath.h>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "PmxFileData.h"
+#include "SkinningKernel.h"
+#include "GpuSkinning.h"
+
+using namespace DirectX;
+
+struct SdefSkinningData
+{
+	XMFLOAT3 sdefC;
+	XMFLOAT3 cr0;
+	XMFLOAT3 cr1;
+	float weight0;
+};
+
+// Per bone arrays of the current pose, sdefData holds the SDEF vertices from sdefStartIndex on
+struct SkinningPaletteView
+{
+	const XMMATRIX* matrices;
+	const XMVECTOR* rotations;
+	const XMVECTOR* dualQuaternions;
+	const SdefSkinningData* sdefData;
+	unsigned int sdefStartIndex;
+};
+
+// Scalar skinning of PMX vertices, the path PMXActor takes for morphed, SDEF and dual quaternion vertices
+namespace VertexSkinning
+{
+	inline unsigned int GetInfluenceCount(PMXVertexWeight weightType)
+	{
+		switch (weightType)
+		{
+		case PMXVertexWeight::BDEF2:
+		case PMXVertexWeight::SDEF:
+			return 2;
+		case PMXVertexWeight::BDEF4:
+			return 4;
+		default:
+			return 1;
+		}
+	}
+
+	// BDEF2 and SDEF get their implicit second weight written out for the SIMD kernels and the GPU path
+	void FillStream(const std::vector<PMXVertex>& vertices, SkinningStream& stream);
+	SdefSkinningData CreateSdefData(const PMXVertex& vertex);
+	// Pruned weights from the skinning stream, SDEF and QDEF fall back to their linear blend
+	void PackGpuVertex(const PMXVertex& vertex, const SkinningStream& stream, unsigned int vertexIndex, GpuSkinningVertex& gpuVertex);
+	// Writes the bone's skinning matrix, rotation, dual quaternion and its skinningPaletteStride floats of palette
+	void SetPaletteBone(FXMMATRIX initInverseTransform, CXMMATRIX globalTransform, XMMATRIX& boneMatrix, XMVECTOR& rotation, XMVECTOR& dualQuaternion, float* paletteRow);
+
+	template<PMXVertexWeight weightType>
+	XMVECTOR SkinVertex(const PMXVertex& vertex, unsigned int vertexIndex, const SkinningPaletteView& palette, FXMVECTOR position, XMVECTOR& normal);
+
+	template<>
+	inline XMVECTOR SkinVertex<PMXVertexWeight::BDEF1>(const PMXVertex& vertex, unsigned int vertexIndex, const SkinningPaletteView& palette, FXMVECTOR position, XMVECTOR& normal)
+	{
+		const XMMATRIX& mat = palette.matrices[vertex.boneIndices[0]];
+		normal = XMVector3TransformNormal(normal, mat);
+		return XMVector3Transform(position, mat);
+	}
+
+	template<>
+	inline XMVECTOR SkinVertex<PMXVertexWeight::BDEF2>(const PMXVertex& vertex, unsigned int vertexIndex, const SkinningPaletteView& palette, FXMVECTOR position, XMVECTOR& normal)
+	{
+		float weight0 = vertex.boneWeights[0];
+		float weight1 = 1.0f - weight0;
+
+		// Blending shortens the normal, EncodeVertex renormalizes it like the SIMD kernels do
+		XMMATRIX mat = palette.matrices[vertex.boneIndices[0]] * weight0 + palette.matrices[vertex.boneIndices[1]] * weight1;
+		normal = XMVector3TransformNormal(normal, mat);
+		return XMVector3Transform(position, mat);
+	}
+
+	template<>
+	inline XMVECTOR SkinVertex<PMXVertexWeight::BDEF4>(const PMXVertex& vertex, unsigned int vertexIndex, const SkinningPaletteView& palette, FXMVECTOR position, XMVECTOR& normal)
+	{
+		float weight0 = vertex.boneWeights[0];
+		float weight1 = vertex.boneWeights[1];
+		float weight2 = vertex.boneWeights[2];
+		float weight3 = vertex.boneWeights[3];
+
+		XMMATRIX mat = palette.matrices[vertex.boneIndices[0]] * weight0 + palette.matrices[vertex.boneIndices[1]] * weight1 + palette.matrices[vertex.boneIndices[2]] * weight2 + palette.matrices[vertex.boneIndices[3]] * weight3;
+		normal = XMVector3TransformNormal(normal, mat);
+		return XMVector3Transform(position, mat);
+	}
+
+	template<>
+	inline XMVECTOR SkinVertex<PMXVertexWeight::SDEF>(const PMXVertex& vertex, unsigned int vertexIndex, const SkinningPaletteView& palette, FXMVECTOR position, XMVECTOR& normal)
+	{
+		const SdefSkinningData& sdef = palette.sdefData[vertexIndex - palette.sdefStartIndex];
+
+		float w0 = sdef.weight0;
+		float w1 = 1.0f - w0;
+
+		XMVECTOR sdefc = XMLoadFloat3(&sdef.sdefC);
+
+		const XMMATRIX& m0 = palette.matrices[vertex.boneIndices[0]];
+		const XMMATRIX& m1 = palette.matrices[vertex.boneIndices[1]];
+
+		XMVECTOR q0 = palette.rotations[vertex.boneIndices[0]];
+		XMVECTOR q1 = palette.rotations[vertex.boneIndices[1]];
+
+		XMMATRIX rotation = XMMatrixRotationQuaternion(XMQuaternionSlerp(q0, q1, w1));
+
+			// XMVector3Transform(position - sdefc, rotation) + XMVector3Transform(cr0, m0) * w0 + XMVector3Transform(cr1, m1) * w1
+
+		XMVECTOR a = XMVector3Transform(XMVectorSubtract(position, sdefc), rotation);
+		XMVECTOR b = XMVector3Transform(XMLoadFloat3(&sdef.cr0), m0) * w0;
+		XMVECTOR c = XMVector3Transform(XMLoadFloat3(&sdef.cr1), m1) * w1;
+
+		normal = XMVector3Transform(normal, rotation);
+		return XMVectorAdd(XMVectorAdd(a, b), c);
+	}
+
+	template<>
+	inline XMVECTOR SkinVertex<PMXVertexWeight::QDEF>(const PMXVertex& vertex, unsigned int vertexIndex, const SkinningPaletteView& palette, FXMVECTOR position, XMVECTOR& normal)
+	{
+		const XMMATRIX& mat = palette.matrices[vertex.boneIndices[0]];
+		normal = XMVector3TransformNormal(normal, mat);
+		return XMVector3Transform(position, mat);
+	}
+
+	// Dual quaternion linear blending, real parts are the bone rotations
+	inline XMVECTOR SkinVertexDualQuaternion(const PMXVertex& vertex, unsigned int influenceCount, const SkinningPaletteView& palette, FXMVECTOR position, XMVECTOR& normal)
+	{
+		float weights[4] = { vertex.boneWeights[0], 1.0f - vertex.boneWeights[0], 0.0f, 0.0f };
+		if (influenceCount == 4)
+		{
+			std::copy(std::begin(vertex.boneWeights), std::end(vertex.boneWeights), weights);
+		}
+
+		XMVECTOR pivot = palette.rotations[vertex.boneIndices[0]];
+		XMVECTOR real = XMVectorZero();
+		XMVECTOR dual = XMVectorZero();
+
+		for (unsigned int k = 0; k < influenceCount; k++)
+		{
+			int boneIndex = vertex.boneIndices[k];
+			XMVECTOR rotation = palette.rotations[boneIndex];
+
+			// Blend in the hemisphere of the first influence
+			float weight = weights[k];
+			if (XMVectorGetX(XMVector4Dot(pivot, rotation)) < 0.0f)
+			{
+				weight = -weight;
+			}
+
+			real = XMVectorMultiplyAdd(rotation, XMVectorReplicate(weight), real);
+			dual = XMVectorMultiplyAdd(palette.dualQuaternions[boneIndex], XMVectorReplicate(weight), dual);
+		}
+
+		XMVECTOR inverseLength = XMVector4ReciprocalLength(real);
+		real = XMVectorMultiply(real, inverseLength);
+		dual = XMVectorMultiply(dual, inverseLength);
+
+		// translation = 2 * dual * conjugate(real)
+		XMVECTOR translation = XMVectorScale(XMQuaternionMultiply(XMQuaternionConjugate(real), dual), 2.0f);
+
+		normal = XMVector3Rotate(normal, real);
+		return XMVectorAdd(XMVector3Rotate(position, real), translation);
+	}
+
+	// UV of the vertex with its merged UV morph, packed like SkinningStream::uv
+	inline unsigned int PackMorphedUV(const PMXVertex& vertex, FXMVECTOR morphUV)
+	{
+		XMFLOAT2 uv;
+		XMStoreFloat2(&uv, XMVectorAdd(XMLoadFloat2(&vertex.uv), morphUV));
+		return SkinningKernel::PackUV(uv.x, uv.y);
+	}
+
+	// position and packedUV already carry the vertex morphs
+	template<PMXVertexWeight weightType, bool isDualQuaternion>
+	inline void SkinAndEncodeVertex(const PMXVertex& vertex, unsigned int vertexIndex, const SkinningPaletteView& palette, FXMVECTOR position, unsigned int packedUV, const VertexQuantization& quantization, QuantizedVertex& output)
+	{
+		XMVECTOR normal = XMLoadFloat3(&vertex.normal);
+		XMVECTOR skinned;
+
+		if (isDualQuaternion == true)
+		{
+			skinned = SkinVertexDualQuaternion(vertex, GetInfluenceCount(weightType), palette, position, normal);
+		}
+		else
+		{
+			skinned = SkinVertex<weightType>(vertex, vertexIndex, palette, position, normal);
+		}
+
+		XMFLOAT3 skinnedPosition;
+		XMFLOAT3 skinnedNormal;
+		XMStoreFloat3(&skinnedPosition, skinned);
+		XMStoreFloat3(&skinnedNormal, normal);
+		SkinningKernel::EncodeVertex(&skinnedPosition.x, &skinnedNormal.x, packedUV, quantization, output);
+	}
+}
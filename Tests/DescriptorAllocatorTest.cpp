@@ -0,0 +1,105 @@
+#include "Test.h"
+#include <random>
+#include <vector>
+
+#include "Define.h"
+#include "DescriptorAllocator.h"
+
+namespace
+{
+	// Random allocate and free steps, no two live ranges may overlap and freeing everything gives back the whole heap
+	void TestRandomRanges(unsigned int capacity, unsigned int iterations)
+	{
+		DescriptorAllocator allocator;
+		allocator.Initialize(capacity);
+
+		std::vector<DescriptorRange> liveRanges;
+		std::vector<bool> used(capacity, false);
+		unsigned int usedCount = 0;
+
+		std::mt19937 generator(1234);
+		std::uniform_int_distribution<unsigned int> countDistribution(1, 16);
+
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			bool allocate = liveRanges.empty() == true || generator() % 3 != 0;
+
+			if (allocate == true)
+			{
+				DescriptorRange range = allocator.Allocate(countDistribution(generator));
+				if (range.IsValid() == false)
+				{
+					continue;
+				}
+
+				TEST_ASSERT(range.index + range.count <= capacity);
+
+				for (unsigned int index = range.index; index < range.index + range.count; index++)
+				{
+					TEST_ASSERT(used[index] == false);
+					used[index] = true;
+				}
+
+				usedCount += range.count;
+				liveRanges.push_back(range);
+			}
+			else
+			{
+				size_t liveIndex = generator() % liveRanges.size();
+				DescriptorRange range = liveRanges[liveIndex];
+
+				for (unsigned int index = range.index; index < range.index + range.count; index++)
+				{
+					used[index] = false;
+				}
+
+				usedCount -= range.count;
+				allocator.Free(range);
+
+				liveRanges[liveIndex] = liveRanges.back();
+				liveRanges.pop_back();
+			}
+
+			TEST_ASSERT(allocator.GetFreeCount() == capacity - usedCount);
+		}
+
+		for (const DescriptorRange& range : liveRanges)
+		{
+			allocator.Free(range);
+		}
+
+		TEST_ASSERT(allocator.GetFreeCount() == capacity);
+
+		DescriptorRange whole = allocator.Allocate(capacity);
+		TEST_ASSERT(whole.IsValid() == true && whole.index == 0 && whole.count == capacity);
+	}
+
+	// Freed neighbours merge back, and a full heap hands out invalid ranges instead of overlapping ones
+	void TestMergeAndExhaustion()
+	{
+		DescriptorAllocator allocator;
+		allocator.Initialize(16);
+
+		DescriptorRange first = allocator.Allocate(4);
+		DescriptorRange second = allocator.Allocate(4);
+		DescriptorRange third = allocator.Allocate(8);
+		TEST_ASSERT(first.index == 0 && second.index == 4 && third.index == 8);
+		TEST_ASSERT(allocator.Allocate(1).IsValid() == false);
+
+		// Free ranges of 4 and 8 on either side of a live one, 12 only fits once all three merge
+		allocator.Free(first);
+		allocator.Free(third);
+		TEST_ASSERT(allocator.Allocate(12).IsValid() == false);
+
+		allocator.Free(second);
+		DescriptorRange whole = allocator.Allocate(16);
+		TEST_ASSERT(whole.IsValid() == true && whole.index == 0);
+	}
+}
+
+void TestDescriptorAllocator()
+{
+	TestRandomRanges(descriptor_heap_capacity, 10000);
+	TestRandomRanges(64, 10000);
+	TestMergeAndExhaustion();
+}
@@ -0,0 +1,112 @@
+#include "Test.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "SkinningTestPose.h"
+
+namespace
+{
+	// What VertexSkinningByBucket writes for one vertex, position and packedUV already carry its morphs
+	void SkinByCpu(const SkinningTestPose& pose, unsigned int vertexIndex, FXMVECTOR position, unsigned int packedUV, QuantizedVertex& output)
+	{
+		const PMXVertex& vertex = pose.vertices[vertexIndex];
+		SkinningPaletteView palette = pose.GetPaletteView();
+
+		switch (vertex.weightType)
+		{
+		case PMXVertexWeight::BDEF1:
+			VertexSkinning::SkinAndEncodeVertex<PMXVertexWeight::BDEF1, false>(vertex, vertexIndex, palette, position, packedUV, pose.quantization, output);
+			break;
+		case PMXVertexWeight::BDEF2:
+			VertexSkinning::SkinAndEncodeVertex<PMXVertexWeight::BDEF2, false>(vertex, vertexIndex, palette, position, packedUV, pose.quantization, output);
+			break;
+		case PMXVertexWeight::BDEF4:
+			VertexSkinning::SkinAndEncodeVertex<PMXVertexWeight::BDEF4, false>(vertex, vertexIndex, palette, position, packedUV, pose.quantization, output);
+			break;
+		case PMXVertexWeight::SDEF:
+			VertexSkinning::SkinAndEncodeVertex<PMXVertexWeight::SDEF, false>(vertex, vertexIndex, palette, position, packedUV, pose.quantization, output);
+			break;
+		default:
+			VertexSkinning::SkinAndEncodeVertex<PMXVertexWeight::QDEF, false>(vertex, vertexIndex, palette, position, packedUV, pose.quantization, output);
+			break;
+		}
+	}
+
+	// The GPU path blends SDEF linearly, which only matches the CPU when the two bones turn alike
+	void TestPose(bool isTranslationOnly)
+	{
+		SkinningTestPose pose;
+		CreateSkinningTestPose(64, 64, isTranslationOnly, pose);
+
+		unsigned int boneCount = static_cast<unsigned int>(pose.boneMatrices.size());
+		std::vector<float> packedPalette(boneCount * gpuSkinningPaletteStride);
+		GpuSkinning::PackPalette(pose.palette.data(), boneCount, packedPalette.data());
+
+		std::mt19937 generator(91011);
+		std::uniform_real_distribution<float> morphDistribution(-0.25f, 0.25f);
+
+		for (unsigned int i = 0; i < pose.vertices.size(); i++)
+		{
+			const PMXVertex& vertex = pose.vertices[i];
+			if (vertex.weightType == PMXVertexWeight::SDEF && isTranslationOnly == false)
+			{
+				continue;
+			}
+
+			// Every other vertex morphed, the merged offsets UpdateGpuSkinning and VertexSkinningByBucket both get from the gather
+			bool isMorphed = i % 2 == 0;
+			XMVECTOR morphPosition = XMVectorZero();
+			XMVECTOR morphUV = XMVectorZero();
+			if (isMorphed == true)
+			{
+				float x = morphDistribution(generator);
+				float y = morphDistribution(generator);
+				float z = morphDistribution(generator);
+				float u = morphDistribution(generator);
+				float v = morphDistribution(generator);
+				morphPosition = XMVectorSet(x, y, z, 0.0f);
+				morphUV = XMVectorSet(u, v, 0.0f, 0.0f);
+			}
+
+			GpuSkinningVertex gpuVertex;
+			VertexSkinning::PackGpuVertex(vertex, pose.stream, i, gpuVertex);
+
+			GpuMorphVertex morph;
+			XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(morph.position), morphPosition);
+			XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(morph.uv), morphUV);
+
+			float gpuPosition[3];
+			float gpuNormal[3];
+			float gpuUV[2];
+			GpuSkinning::SkinVertex(gpuVertex, morph, packedPalette.data(), gpuPosition, gpuNormal, gpuUV);
+
+			XMVECTOR position = XMVectorAdd(XMLoadFloat3(&vertex.position), morphPosition);
+			unsigned int packedUV = isMorphed == true ? VertexSkinning::PackMorphedUV(vertex, morphUV) : pose.stream.uv[i];
+
+			QuantizedVertex cpuVertex;
+			SkinByCpu(pose, i, position, packedUV, cpuVertex);
+
+			float cpuPosition[3];
+			float cpuNormal[3];
+			SkinningKernel::DecodeVertex(cpuVertex, pose.quantization, cpuPosition, cpuNormal);
+
+			// Half a unorm16 step of the CPU output plus the unorm16 bone weights of the GPU vertex
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				TEST_ASSERT(std::abs(gpuPosition[c] - cpuPosition[c]) < 1e-3f);
+				TEST_ASSERT(std::abs(gpuNormal[c] - cpuNormal[c]) < 2e-3f);
+			}
+
+			unsigned int gpuPackedUV = SkinningKernel::PackUV(gpuUV[0], gpuUV[1]);
+			TEST_ASSERT(std::memcmp(&gpuPackedUV, cpuVertex.uv, sizeof(cpuVertex.uv)) == 0);
+		}
+	}
+}
+
+void TestGpuSkinning()
+{
+	TestPose(false);
+	TestPose(true);
+}
@@ -0,0 +1,201 @@
+#include "Test.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MorphManager.h"
+
+namespace
+{
+	const unsigned int vertexCount = 60000;
+	const unsigned int faceVertexCount = 8000;
+	const unsigned int positionMorphCount = 160;
+	const unsigned int uvMorphCount = 24;
+	const unsigned int groupMorphCount = 16;
+	const unsigned int lastKeyFrame = 100;
+
+	// A face heavy model : every morph touches a few thousand of the face vertices, all of them keyed so all are active
+	void CreateFaceModel(std::vector<PMXMorph>& morphs, std::vector<VMDMorph>& keys)
+	{
+		std::mt19937 generator(1357);
+		std::uniform_real_distribution<float> deltaDistribution(-0.01f, 0.01f);
+		std::uniform_real_distribution<float> weightDistribution(0.1f, 1.0f);
+
+		std::vector<unsigned int> faceVertices(faceVertexCount);
+		for (unsigned int i = 0; i < faceVertexCount; i++)
+		{
+			faceVertices[i] = i * (vertexCount / faceVertexCount);
+		}
+
+		for (unsigned int i = 0; i < positionMorphCount + uvMorphCount + groupMorphCount; i++)
+		{
+			PMXMorph morph;
+			morph.name = L"Morph" + std::to_wstring(i);
+			morph.controlPanel = 3;
+
+			if (i < positionMorphCount + uvMorphCount)
+			{
+				bool isPosition = i < positionMorphCount;
+				morph.morphType = isPosition == true ? PMXMorphType::Position : PMXMorphType::UV;
+
+				std::shuffle(faceVertices.begin(), faceVertices.end(), generator);
+				unsigned int touchedCount = isPosition == true ? 1500 + generator() % 2500 : 500;
+
+				for (unsigned int k = 0; k < touchedCount; k++)
+				{
+					if (isPosition == true)
+					{
+						morph.positionMorph.push_back(PMXMorph::PositionMorph{ faceVertices[k], XMFLOAT3(deltaDistribution(generator), deltaDistribution(generator), deltaDistribution(generator)) });
+					}
+					else
+					{
+						morph.uvMorph.push_back(PMXMorph::UVMorph{ faceVertices[k], XMFLOAT4(deltaDistribution(generator), deltaDistribution(generator), 0.0f, 0.0f) });
+					}
+				}
+			}
+			else
+			{
+				// Expressions mixing a handful of the position morphs
+				morph.morphType = PMXMorphType::Group;
+				for (unsigned int k = 0; k < 6; k++)
+				{
+					morph.groupMorph.push_back(PMXMorph::GroupMorph{ generator() % positionMorphCount, weightDistribution(generator) });
+				}
+			}
+
+			morphs.push_back(morph);
+
+			keys.push_back(VMDMorph{ morph.name, 0, weightDistribution(generator) });
+			keys.push_back(VMDMorph{ morph.name, lastKeyFrame, weightDistribution(generator) });
+		}
+	}
+
+	float GetKeyWeight(const std::vector<VMDMorph>& keys, unsigned int morphIndex, unsigned int frame)
+	{
+		float t = static_cast<float>(frame) / static_cast<float>(lastKeyFrame);
+		return keys[morphIndex * 2].weight * (1.0f - t) + keys[morphIndex * 2 + 1].weight * t;
+	}
+
+	// What AnimatePositionMorph did before the vertex major table : one morph at a time, scattered into every vertex
+	void ScatterMorphs(const std::vector<PMXMorph>& morphs, const std::vector<VMDMorph>& keys, unsigned int frame, std::vector<XMFLOAT4>& positions, std::vector<XMFLOAT4>& uvs)
+	{
+		std::fill(positions.begin(), positions.end(), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+		std::fill(uvs.begin(), uvs.end(), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+
+		std::vector<float> weights(morphs.size(), 0.0f);
+		for (unsigned int i = 0; i < morphs.size(); i++)
+		{
+			float weight = GetKeyWeight(keys, i, frame);
+			if (morphs[i].morphType != PMXMorphType::Group)
+			{
+				weights[i] += weight;
+				continue;
+			}
+
+			for (const PMXMorph::GroupMorph& child : morphs[i].groupMorph)
+			{
+				weights[child.morphIndex] += weight * child.weight;
+			}
+		}
+
+		for (unsigned int i = 0; i < morphs.size(); i++)
+		{
+			XMVECTOR weight = XMVectorReplicate(weights[i]);
+
+			for (const PMXMorph::PositionMorph& data : morphs[i].positionMorph)
+			{
+				XMFLOAT4& position = positions[data.vertexIndex];
+				XMStoreFloat4(&position, XMVectorMultiplyAdd(XMLoadFloat3(&data.position), weight, XMLoadFloat4(&position)));
+			}
+
+			for (const PMXMorph::UVMorph& data : morphs[i].uvMorph)
+			{
+				XMFLOAT4& uv = uvs[data.vertexIndex];
+				XMStoreFloat4(&uv, XMVectorMultiplyAdd(XMLoadFloat4(&data.uv), weight, XMLoadFloat4(&uv)));
+			}
+		}
+	}
+
+	// The fused skinning pass gathers each active row right before skinning its vertex
+	void GatherMorphs(const MorphManager& morphManager, std::vector<XMFLOAT4>& positions, std::vector<XMFLOAT4>& uvs)
+	{
+		const VertexMorphTable& table = morphManager.GetVertexMorphTable();
+
+		for (unsigned int row : morphManager.GetActiveVertexMorphRows())
+		{
+			unsigned int vertexIndex = table.vertexIndices[row];
+
+			XMVECTOR position;
+			XMVECTOR uv;
+			morphManager.GatherVertexMorph(row, position, uv);
+
+			XMStoreFloat4(&positions[vertexIndex], position);
+			XMStoreFloat4(&uvs[vertexIndex], uv);
+		}
+	}
+}
+
+void BenchmarkMorph()
+{
+	std::vector<PMXMorph> morphs;
+	std::vector<VMDMorph> keys;
+	CreateFaceModel(morphs, keys);
+
+	MorphManager morphManager;
+	morphManager.Init(morphs, keys, vertexCount, 0, 0);
+
+	std::vector<XMFLOAT4> scatterPositions(vertexCount);
+	std::vector<XMFLOAT4> scatterUVs(vertexCount);
+	std::vector<XMFLOAT4> gatherPositions(vertexCount);
+	std::vector<XMFLOAT4> gatherUVs(vertexCount);
+
+	// Both sides have to produce the same offsets for the timings to mean anything
+	const unsigned int checkFrame = lastKeyFrame / 2;
+	ScatterMorphs(morphs, keys, checkFrame, scatterPositions, scatterUVs);
+	morphManager.Animate(checkFrame);
+	GatherMorphs(morphManager, gatherPositions, gatherUVs);
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		TEST_ASSERT(std::abs(scatterPositions[i].x - gatherPositions[i].x) < 1e-4f);
+		TEST_ASSERT(std::abs(scatterPositions[i].y - gatherPositions[i].y) < 1e-4f);
+		TEST_ASSERT(std::abs(scatterPositions[i].z - gatherPositions[i].z) < 1e-4f);
+		TEST_ASSERT(std::abs(scatterUVs[i].x - gatherUVs[i].x) < 1e-4f);
+		TEST_ASSERT(std::abs(scatterUVs[i].y - gatherUVs[i].y) < 1e-4f);
+	}
+
+	const unsigned int frameCount = 100;
+	using Clock = std::chrono::high_resolution_clock;
+
+	auto scatterStart = Clock::now();
+	for (unsigned int frame = 0; frame < frameCount; frame++)
+	{
+		ScatterMorphs(morphs, keys, frame % lastKeyFrame, scatterPositions, scatterUVs);
+	}
+	double scatterSeconds = std::chrono::duration<double>(Clock::now() - scatterStart).count();
+
+	double animateSeconds = 0.0;
+	double gatherSeconds = 0.0;
+	for (unsigned int frame = 0; frame < frameCount; frame++)
+	{
+		auto animateStart = Clock::now();
+		morphManager.Animate(frame % lastKeyFrame);
+		auto gatherStart = Clock::now();
+		GatherMorphs(morphManager, gatherPositions, gatherUVs);
+		auto gatherEnd = Clock::now();
+
+		animateSeconds += std::chrono::duration<double>(gatherStart - animateStart).count();
+		gatherSeconds += std::chrono::duration<double>(gatherEnd - gatherStart).count();
+	}
+
+	double toMilliseconds = 1000.0 / frameCount;
+	double tableSeconds = animateSeconds + gatherSeconds;
+
+	std::printf("Morph : %u active morphs on %u rows, scatter %.3f ms, Animate %.3f ms + gather %.3f ms per frame, %.1fx\n",
+		positionMorphCount + uvMorphCount + groupMorphCount, static_cast<unsigned int>(morphManager.GetActiveVertexMorphRows().size()),
+		scatterSeconds * toMilliseconds, animateSeconds * toMilliseconds, gatherSeconds * toMilliseconds, scatterSeconds / tableSeconds);
+}
@@ -0,0 +1,68 @@
+#include "Test.h"
+#include <vector>
+
+#include "MorphManager.h"
+
+namespace
+{
+	PMXMorph CreateMaterialMorph()
+	{
+		PMXMorph morph;
+		morph.name = L"Material";
+		morph.controlPanel = 4;
+		morph.morphType = PMXMorphType::Material;
+
+		PMXMorph::MaterialMorph data = {};
+		data.materialIndex = 0;
+		data.opType = PMXMorph::MaterialMorph::OpType::Add;
+		data.diffuse = XMFLOAT4(1.0f, 0.0f, 0.0f, 0.0f);
+		morph.materialMorph.push_back(data);
+
+		return morph;
+	}
+
+	PMXMorph CreateBoneMorph()
+	{
+		PMXMorph morph;
+		morph.name = L"Bone";
+		morph.controlPanel = 4;
+		morph.morphType = PMXMorphType::Bone;
+		morph.boneMorph.push_back(PMXMorph::BoneMorph{ 0, XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) });
+
+		return morph;
+	}
+
+	// Held at 1 until frame 10, then a step down to 0
+	void AddStepKeys(const std::wstring& name, std::vector<VMDMorph>& keys)
+	{
+		keys.push_back(VMDMorph{ name, 0, 1.0f });
+		keys.push_back(VMDMorph{ name, 10, 1.0f });
+		keys.push_back(VMDMorph{ name, 11, 0.0f });
+		keys.push_back(VMDMorph{ name, 20, 0.0f });
+	}
+}
+
+// Material and bone morphs below the weight epsilon are skipped, their slots have to be cleared every frame
+void TestMorphManager()
+{
+	std::vector<PMXMorph> morphs = { CreateMaterialMorph(), CreateBoneMorph() };
+
+	std::vector<VMDMorph> keys;
+	AddStepKeys(morphs[0].name, keys);
+	AddStepKeys(morphs[1].name, keys);
+
+	MorphManager morphManager;
+	morphManager.Init(morphs, keys, 0, 1, 1);
+
+	morphManager.Animate(5);
+	TEST_ASSERT(morphManager.GetMorphMaterial(0).weight == 1.0f);
+	TEST_ASSERT(morphManager.GetMorphMaterial(0).diffuse.x == 1.0f);
+	TEST_ASSERT(morphManager.GetMorphBone(0).weight == 1.0f);
+	TEST_ASSERT(morphManager.GetMorphBone(0).position.y == 1.0f);
+
+	morphManager.Animate(15);
+	TEST_ASSERT(morphManager.GetMorphMaterial(0).weight == 0.0f);
+	TEST_ASSERT(morphManager.GetMorphMaterial(0).diffuse.x == 0.0f);
+	TEST_ASSERT(morphManager.GetMorphBone(0).weight == 0.0f);
+	TEST_ASSERT(morphManager.GetMorphBone(0).position.y == 0.0f);
+}
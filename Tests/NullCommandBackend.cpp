@@ -0,0 +1,161 @@
+#include "NullCommandBackend.h"
+#include <climits>
+#include <map>
+
+namespace
+{
+	const unsigned int noPass = UINT_MAX;
+
+	// Pass open on this thread, passes nest when a waiting thread picks up another one
+	thread_local unsigned int recordingPass = noPass;
+}
+
+void NullCommandBackend::BeginFrame(unsigned int passCount)
+{
+	std::lock_guard<std::mutex> lock(mEventMutex);
+	mEvents.clear();
+	mPassCount = passCount;
+	mPassCommands.assign(passCount, std::vector<unsigned int>());
+	mPreviousRecordingPasses.assign(passCount, noPass);
+	mSubmittedCommands.clear();
+	mHasCommandOutsidePass = false;
+	mEvents.push_back(CommandBackendEvent{ CommandBackendEventType::BeginFrame, passCount, std::this_thread::get_id() });
+}
+
+void NullCommandBackend::BeginPass(unsigned int pass)
+{
+	AddEvent(CommandBackendEventType::BeginPass, pass);
+
+	if (pass < mPassCount)
+	{
+		mPreviousRecordingPasses[pass] = recordingPass;
+		recordingPass = pass;
+	}
+}
+
+void NullCommandBackend::EndPass(unsigned int pass)
+{
+	AddEvent(CommandBackendEventType::EndPass, pass);
+
+	if (pass < mPassCount)
+	{
+		recordingPass = mPreviousRecordingPasses[pass];
+	}
+}
+
+void NullCommandBackend::Submit()
+{
+	AddEvent(CommandBackendEventType::Submit, mPassCount);
+
+	for (const std::vector<unsigned int>& commands : mPassCommands)
+	{
+		mSubmittedCommands.insert(mSubmittedCommands.end(), commands.begin(), commands.end());
+	}
+}
+
+void NullCommandBackend::RecordCommand(unsigned int command)
+{
+	if (recordingPass == noPass)
+	{
+		mHasCommandOutsidePass = true;
+		return;
+	}
+
+	mPassCommands[recordingPass].push_back(command);
+}
+
+const std::vector<CommandBackendEvent>& NullCommandBackend::GetEvents() const
+{
+	return mEvents;
+}
+
+const std::vector<unsigned int>& NullCommandBackend::GetSubmittedCommands() const
+{
+	return mSubmittedCommands;
+}
+
+bool NullCommandBackend::IsValidFrame() const
+{
+	if (mHasCommandOutsidePass == true ||
+		mEvents.size() != mPassCount * 2 + 2 ||
+		mEvents.front().type != CommandBackendEventType::BeginFrame ||
+		mEvents.back().type != CommandBackendEventType::Submit)
+	{
+		return false;
+	}
+
+	// A thread may pick up another pass while it waits inside one, so the passes of a thread must nest
+	std::map<std::thread::id, std::vector<unsigned int>> openPasses;
+	std::vector<unsigned int> beginCounts(mPassCount, 0);
+	std::vector<unsigned int> endCounts(mPassCount, 0);
+
+	for (unsigned int i = 1; i + 1 < mEvents.size(); i++)
+	{
+		const CommandBackendEvent& event = mEvents[i];
+		if (event.pass >= mPassCount)
+		{
+			return false;
+		}
+
+		std::vector<unsigned int>& threadPasses = openPasses[event.threadId];
+
+		if (event.type == CommandBackendEventType::BeginPass)
+		{
+			beginCounts[event.pass]++;
+			threadPasses.push_back(event.pass);
+		}
+		else if (event.type == CommandBackendEventType::EndPass)
+		{
+			endCounts[event.pass]++;
+			if (threadPasses.empty() == true || threadPasses.back() != event.pass)
+			{
+				return false;
+			}
+
+			threadPasses.pop_back();
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	for (unsigned int pass = 0; pass < mPassCount; pass++)
+	{
+		if (beginCounts[pass] != 1 || endCounts[pass] != 1)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+unsigned int NullCommandBackend::GetNestedPassCount() const
+{
+	std::map<std::thread::id, unsigned int> openPassCounts;
+	unsigned int nestedPassCount = 0;
+
+	for (const CommandBackendEvent& event : mEvents)
+	{
+		if (event.type == CommandBackendEventType::BeginPass)
+		{
+			if (openPassCounts[event.threadId]++ > 0)
+			{
+				nestedPassCount++;
+			}
+		}
+		else if (event.type == CommandBackendEventType::EndPass)
+		{
+			openPassCounts[event.threadId]--;
+		}
+	}
+
+	return nestedPassCount;
+}
+
+void NullCommandBackend::AddEvent(CommandBackendEventType type, unsigned int pass)
+{
+	std::lock_guard<std::mutex> lock(mEventMutex);
+	mEvents.push_back(CommandBackendEvent{ type, pass, std::this_thread::get_id() });
+}
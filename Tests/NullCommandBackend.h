@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CommandBackend.h"
+
+enum class CommandBackendEventType
+{
+	BeginFrame,
+	BeginPass,
+	EndPass,
+	Submit,
+};
+
+struct CommandBackendEvent
+{
+	CommandBackendEventType type;
+	unsigned int pass;
+	std::thread::id threadId;
+};
+
+// Logs the backend calls instead of recording commands, so the pass scheduling can be checked without a device
+class NullCommandBackend : public ICommandBackend
+{
+public:
+	void BeginFrame(unsigned int passCount) override;
+	void BeginPass(unsigned int pass) override;
+	void EndPass(unsigned int pass) override;
+	void Submit() override;
+
+	// Stands in for a recorded command, goes to the list of the pass open on the calling thread like Dx12Wrapper::CommandList
+	void RecordCommand(unsigned int command);
+
+	// Calls since the last BeginFrame
+	const std::vector<CommandBackendEvent>& GetEvents() const;
+	// Every pass list of the last Submit, in the order it was submitted
+	const std::vector<unsigned int>& GetSubmittedCommands() const;
+	// Each pass began and ended once, nested on one thread, between BeginFrame and Submit, and nothing recorded outside a pass
+	bool IsValidFrame() const;
+	// Passes that began while their thread had another pass open
+	unsigned int GetNestedPassCount() const;
+
+private:
+	void AddEvent(CommandBackendEventType type, unsigned int pass);
+
+	std::mutex mEventMutex;
+	std::vector<CommandBackendEvent> mEvents;
+	unsigned int mPassCount = 0;
+
+	// Each list is only touched by the thread recording its pass
+	std::vector<std::vector<unsigned int>> mPassCommands;
+	std::vector<unsigned int> mPreviousRecordingPasses;
+	std::vector<unsigned int> mSubmittedCommands;
+	std::atomic<bool> mHasCommandOutsidePass{ false };
+};
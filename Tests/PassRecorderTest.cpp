@@ -0,0 +1,176 @@
+#include "Test.h"
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "JobSystem.h"
+#include "NullCommandBackend.h"
+#include "PassRecorder.h"
+
+namespace
+{
+	const unsigned int passCount = 24;
+	const unsigned int commandsPerPass = 16;
+	const unsigned int frameCount = 16;
+
+	void RecordCommands(NullCommandBackend& backend, unsigned int pass, unsigned int begin, unsigned int end)
+	{
+		for (unsigned int command = begin; command < end; command++)
+		{
+			backend.RecordCommand(pass * commandsPerPass + command);
+		}
+	}
+
+	// Each list holds only its own pass's commands in the order they were recorded, and the lists go out in pass order
+	void CheckSubmission(const NullCommandBackend& backend)
+	{
+		TEST_ASSERT(backend.IsValidFrame() == true);
+
+		const std::vector<unsigned int>& commands = backend.GetSubmittedCommands();
+		TEST_ASSERT(commands.size() == passCount * commandsPerPass);
+
+		for (unsigned int i = 0; i < commands.size(); i++)
+		{
+			TEST_ASSERT(commands[i] == i);
+		}
+	}
+
+	void TestEmptyPasses()
+	{
+		PassRecorder recorder;
+		NullCommandBackend backend;
+
+		for (unsigned int pass = 0; pass < passCount; pass++)
+		{
+			recorder.AddPass("Pass " + std::to_string(pass), []() {});
+		}
+
+		for (unsigned int frame = 0; frame < 64; frame++)
+		{
+			recorder.Record(backend);
+			TEST_ASSERT(backend.IsValidFrame() == true);
+			TEST_ASSERT(backend.GetSubmittedCommands().empty() == true);
+		}
+	}
+
+	// Later passes are shorter, so they finish first whichever thread picks them up
+	void TestSubmissionOrder()
+	{
+		PassRecorder recorder;
+		NullCommandBackend backend;
+
+		for (unsigned int pass = 0; pass < passCount; pass++)
+		{
+			recorder.AddPass("Pass " + std::to_string(pass), [&backend, pass]()
+				{
+					for (unsigned int command = 0; command < commandsPerPass; command++)
+					{
+						std::this_thread::sleep_for(std::chrono::microseconds((passCount - pass) * 10));
+						RecordCommands(backend, pass, command, command + 1);
+					}
+				});
+		}
+
+		for (unsigned int frame = 0; frame < frameCount; frame++)
+		{
+			recorder.Record(backend);
+			CheckSubmission(backend);
+		}
+	}
+
+	// A pass blocked on something outside the job system keeps its thread, the other passes move to the remaining threads
+	void TestBlockingPass()
+	{
+		PassRecorder recorder;
+		NullCommandBackend backend;
+
+		for (unsigned int pass = 0; pass < passCount; pass++)
+		{
+			recorder.AddPass("Pass " + std::to_string(pass), [&backend, pass]()
+				{
+					RecordCommands(backend, pass, 0, commandsPerPass / 2);
+					std::this_thread::sleep_for(pass == 0 ? std::chrono::milliseconds(20) : std::chrono::milliseconds(1));
+					RecordCommands(backend, pass, commandsPerPass / 2, commandsPerPass);
+				});
+		}
+
+		unsigned int threadCount = JobSystem::Instance().GetThreadCount();
+
+		for (unsigned int frame = 0; frame < 4; frame++)
+		{
+			recorder.Record(backend);
+			CheckSubmission(backend);
+
+			std::set<std::thread::id> recordingThreads;
+			unsigned int passesEndedBeforeBlockingPass = 0;
+			bool hasBlockingPassEnded = false;
+
+			for (const CommandBackendEvent& event : backend.GetEvents())
+			{
+				if (event.type != CommandBackendEventType::EndPass)
+				{
+					continue;
+				}
+
+				recordingThreads.insert(event.threadId);
+
+				if (event.pass == 0)
+				{
+					hasBlockingPassEnded = true;
+				}
+				else if (hasBlockingPassEnded == false)
+				{
+					passesEndedBeforeBlockingPass++;
+				}
+			}
+
+			// Idle threads steal the passes queued behind the blocking one instead of waiting for it
+			if (threadCount > 1)
+			{
+				TEST_ASSERT(recordingThreads.size() > 1);
+				TEST_ASSERT(passesEndedBeforeBlockingPass == passCount - 1);
+			}
+		}
+	}
+
+	// A pass waiting on its own parallel work may run other passes on its thread, nested inside its own
+	void TestNestedPasses()
+	{
+		PassRecorder recorder;
+		NullCommandBackend backend;
+
+		for (unsigned int pass = 0; pass < passCount; pass++)
+		{
+			recorder.AddPass("Pass " + std::to_string(pass), [&backend, pass]()
+				{
+					RecordCommands(backend, pass, 0, commandsPerPass / 2);
+
+					JobSystem::Instance().ParallelFor(0, 64, 1, [](unsigned int begin, unsigned int end)
+						{
+							std::this_thread::sleep_for(std::chrono::microseconds((end - begin) * 50));
+						});
+
+					RecordCommands(backend, pass, commandsPerPass / 2, commandsPerPass);
+				});
+		}
+
+		unsigned int nestedPassCount = 0;
+		for (unsigned int frame = 0; frame < frameCount; frame++)
+		{
+			recorder.Record(backend);
+			CheckSubmission(backend);
+			nestedPassCount += backend.GetNestedPassCount();
+		}
+
+		std::printf("PassRecorder : %u passes nested in %u frames\n", nestedPassCount, frameCount);
+	}
+}
+
+void TestPassRecorder()
+{
+	TestEmptyPasses();
+	TestSubmissionOrder();
+	TestBlockingPass();
+	TestNestedPasses();
+}
@@ -0,0 +1,231 @@
+#include "Test.h"
+#include <vector>
+
+#include "RenderGraph.h"
+
+namespace
+{
+	const RenderGraphState present = 1;
+	const RenderGraphState renderTarget = 2;
+	const RenderGraphState shaderResource = 3;
+	const RenderGraphState depthWrite = 4;
+
+	struct DeclaredAccess
+	{
+		unsigned int pass;
+		unsigned int resource;
+		RenderGraphState state;
+	};
+
+	void ApplyBarriers(const std::vector<RenderGraphBarrier>& barriers, std::vector<RenderGraphState>& states, std::vector<bool>& isPending, std::vector<RenderGraphState>& pendingStates)
+	{
+		std::vector<bool> isInBatch(states.size(), false);
+
+		for (const RenderGraphBarrier& barrier : barriers)
+		{
+			unsigned int resource = barrier.resource;
+
+			// One barrier per resource and batch, starting from the state the replay has it in
+			TEST_ASSERT(resource < states.size());
+			TEST_ASSERT(isInBatch[resource] == false);
+			TEST_ASSERT(barrier.before == states[resource]);
+			isInBatch[resource] = true;
+
+			switch (barrier.type)
+			{
+			case RenderGraphBarrierType::Transition:
+				TEST_ASSERT(isPending[resource] == false);
+				states[resource] = barrier.after;
+				break;
+			case RenderGraphBarrierType::BeginOnly:
+				TEST_ASSERT(isPending[resource] == false);
+				isPending[resource] = true;
+				pendingStates[resource] = barrier.after;
+				break;
+			case RenderGraphBarrierType::EndOnly:
+				TEST_ASSERT(isPending[resource] == true && pendingStates[resource] == barrier.after);
+				isPending[resource] = false;
+				states[resource] = barrier.after;
+				break;
+			}
+		}
+	}
+
+	// Replaying the batches in execution order leaves every access in the state it declared,
+	// and the final batch puts every resource back in the state it had before the frame
+	void CheckBarrierReplay(const RenderGraph& graph, const std::vector<RenderGraphState>& initialStates, const std::vector<DeclaredAccess>& accesses)
+	{
+		std::vector<RenderGraphState> states = initialStates;
+		std::vector<bool> isPending(states.size(), false);
+		std::vector<RenderGraphState> pendingStates(states.size(), 0);
+
+		for (unsigned int pass = 0; pass < graph.GetPassCount(); pass++)
+		{
+			TEST_ASSERT(graph.IsCulled(pass) == false || graph.GetBarriers(pass).empty() == true);
+		}
+
+		for (unsigned int pass : graph.GetExecutionOrder())
+		{
+			ApplyBarriers(graph.GetBarriers(pass), states, isPending, pendingStates);
+
+			for (const DeclaredAccess& access : accesses)
+			{
+				if (access.pass == pass)
+				{
+					TEST_ASSERT(isPending[access.resource] == false);
+					TEST_ASSERT(states[access.resource] == access.state);
+				}
+			}
+		}
+
+		ApplyBarriers(graph.GetFinalBarriers(), states, isPending, pendingStates);
+
+		for (unsigned int resource = 0; resource < states.size(); resource++)
+		{
+			TEST_ASSERT(isPending[resource] == false);
+			TEST_ASSERT(states[resource] == initialStates[resource]);
+		}
+	}
+
+	unsigned int GetPosition(const std::vector<unsigned int>& executionOrder, unsigned int pass)
+	{
+		for (unsigned int i = 0; i < executionOrder.size(); i++)
+		{
+			if (executionOrder[i] == pass)
+			{
+				return i;
+			}
+		}
+
+		TEST_ASSERT(false);
+		return 0;
+	}
+
+	// A small frame with and without an optional effect, checks culling, group and pass order and the barriers
+	void TestFrame(bool useEffect)
+	{
+		RenderGraph graph;
+		std::vector<unsigned int> executed;
+		std::vector<DeclaredAccess> accesses;
+
+		unsigned int output = graph.AddResource("Output", present);
+		unsigned int color = graph.AddResource("Color", shaderResource);
+		unsigned int depth = graph.AddResource("Depth", depthWrite);
+		unsigned int effect = graph.AddResource("Effect", shaderResource);
+		unsigned int unused = graph.AddResource("Unused", shaderResource);
+		graph.SetOutput(output);
+
+		std::vector<RenderGraphState> initialStates = { present, shaderResource, depthWrite, shaderResource, shaderResource };
+
+		auto read = [&](unsigned int pass, unsigned int resource, RenderGraphState state)
+		{
+			graph.Read(pass, resource, state);
+			accesses.push_back(DeclaredAccess{ pass, resource, state });
+		};
+		auto write = [&](unsigned int pass, unsigned int resource, RenderGraphState state)
+		{
+			graph.Write(pass, resource, state);
+			accesses.push_back(DeclaredAccess{ pass, resource, state });
+		};
+
+		// Added before the group it depends on, so the group order has to come from the dependencies
+		unsigned int postGroup = graph.AddGroup("Post");
+		unsigned int sceneGroup = graph.AddGroup("Scene");
+
+		unsigned int scenePass = graph.AddPass("Scene", sceneGroup, [&executed]() { executed.push_back(0); });
+		write(scenePass, color, renderTarget);
+		write(scenePass, depth, depthWrite);
+
+		unsigned int effectPass = graph.AddPass("Effect", postGroup, [&executed]() { executed.push_back(1); });
+		read(effectPass, color, shaderResource);
+		read(effectPass, depth, shaderResource);
+		write(effectPass, effect, renderTarget);
+
+		unsigned int unusedPass = graph.AddPass("Unused", postGroup, [&executed]() { executed.push_back(2); });
+		read(unusedPass, color, shaderResource);
+		write(unusedPass, unused, renderTarget);
+
+		unsigned int copyPass = graph.AddPass("Copy", postGroup, [&executed]() { executed.push_back(3); });
+		read(copyPass, color, shaderResource);
+		write(copyPass, output, renderTarget);
+
+		unsigned int compositePass = graph.AddPass("Composite", postGroup, [&executed]() { executed.push_back(4); });
+		graph.Modify(compositePass, output, renderTarget);
+		accesses.push_back(DeclaredAccess{ compositePass, output, renderTarget });
+		if (useEffect == true)
+		{
+			read(compositePass, effect, shaderResource);
+		}
+
+		TEST_ASSERT(graph.Compile() == true);
+
+		TEST_ASSERT(graph.IsCulled(scenePass) == false);
+		TEST_ASSERT(graph.IsCulled(copyPass) == false);
+		TEST_ASSERT(graph.IsCulled(compositePass) == false);
+		TEST_ASSERT(graph.IsCulled(unusedPass) == true);
+		TEST_ASSERT(graph.IsCulled(effectPass) == !useEffect);
+
+		const std::vector<unsigned int>& groupOrder = graph.GetGroupOrder();
+		TEST_ASSERT(groupOrder.size() == 2 && groupOrder[0] == sceneGroup && groupOrder[1] == postGroup);
+
+		// Every pass runs after the passes that wrote what it reads
+		const std::vector<unsigned int>& executionOrder = graph.GetExecutionOrder();
+		TEST_ASSERT(executionOrder.size() == (useEffect == true ? 4u : 3u));
+		TEST_ASSERT(GetPosition(executionOrder, scenePass) < GetPosition(executionOrder, copyPass));
+		TEST_ASSERT(GetPosition(executionOrder, copyPass) < GetPosition(executionOrder, compositePass));
+		if (useEffect == true)
+		{
+			TEST_ASSERT(GetPosition(executionOrder, scenePass) < GetPosition(executionOrder, effectPass));
+			TEST_ASSERT(GetPosition(executionOrder, effectPass) < GetPosition(executionOrder, compositePass));
+		}
+
+		CheckBarrierReplay(graph, initialStates, accesses);
+
+		// Effect is written by the effect pass and read by the composite pass, with the copy pass in between
+		if (useEffect == true)
+		{
+			TEST_ASSERT(graph.GetSplitBarrierCount() > 0);
+		}
+
+		for (unsigned int group : groupOrder)
+		{
+			graph.ExecuteGroup(group, [](const std::vector<RenderGraphBarrier>&) {});
+		}
+
+		TEST_ASSERT(executed == executionOrder);
+	}
+
+	// Two groups that each read what the other writes cannot be ordered
+	void TestGroupCycle()
+	{
+		RenderGraph graph;
+
+		unsigned int output = graph.AddResource("Output", present);
+		unsigned int first = graph.AddResource("First", shaderResource);
+		unsigned int second = graph.AddResource("Second", shaderResource);
+		graph.SetOutput(output);
+
+		unsigned int groupA = graph.AddGroup("A");
+		unsigned int groupB = graph.AddGroup("B");
+
+		unsigned int writeFirst = graph.AddPass("Write First", groupA, []() {});
+		graph.Write(writeFirst, first, renderTarget);
+
+		unsigned int writeSecond = graph.AddPass("Write Second", groupB, []() {});
+		graph.Read(writeSecond, first, shaderResource);
+		graph.Write(writeSecond, second, renderTarget);
+
+		unsigned int writeOutput = graph.AddPass("Write Output", groupA, []() {});
+		graph.Read(writeOutput, second, shaderResource);
+		graph.Write(writeOutput, output, renderTarget);
+
+		TEST_ASSERT(graph.Compile() == false);
+	}
+}
+
+void TestRenderGraph()
+{
+	TestFrame(false);
+	TestFrame(true);
+	TestGroupCycle();
+}
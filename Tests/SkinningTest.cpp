@@ -0,0 +1,128 @@
+#include "Test.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "SkinningTestPose.h"
+
+namespace
+{
+	// The buckets PMXActor hands to SkinningKernel::Skinning, the rest always take the scalar path
+	const PMXVertexWeight kernelWeightTypes[] = { PMXVertexWeight::BDEF1, PMXVertexWeight::BDEF2, PMXVertexWeight::BDEF4, PMXVertexWeight::QDEF };
+
+	// What VertexSkinningByBucket writes for unmorphed vertices
+	template<PMXVertexWeight weightType>
+	void SkinByVertex(const SkinningTestPose& pose, std::vector<QuantizedVertex>& vertices)
+	{
+		unsigned int startIndex;
+		unsigned int endIndex;
+		pose.GetRange(weightType, startIndex, endIndex);
+
+		SkinningPaletteView palette = pose.GetPaletteView();
+		for (unsigned int i = startIndex; i < endIndex; i++)
+		{
+			const PMXVertex& vertex = pose.vertices[i];
+			VertexSkinning::SkinAndEncodeVertex<weightType, false>(vertex, i, palette, XMLoadFloat3(&vertex.position), pose.stream.uv[i], pose.quantization, vertices[i]);
+		}
+	}
+
+	// One step of unorm16 rounding for the position, the octahedral normal compared decoded since its seams have two encodings
+	void CheckSameVertex(const QuantizedVertex& expected, const QuantizedVertex& actual, const VertexQuantization& quantization)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			TEST_ASSERT(std::abs(static_cast<int>(expected.position[c]) - static_cast<int>(actual.position[c])) <= 1);
+		}
+
+		float expectedPosition[3];
+		float expectedNormal[3];
+		float actualPosition[3];
+		float actualNormal[3];
+		SkinningKernel::DecodeVertex(expected, quantization, expectedPosition, expectedNormal);
+		SkinningKernel::DecodeVertex(actual, quantization, actualPosition, actualNormal);
+
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			TEST_ASSERT(std::abs(expectedNormal[c] - actualNormal[c]) < 1e-3f);
+		}
+
+		TEST_ASSERT(expected.uv[0] == actual.uv[0] && expected.uv[1] == actual.uv[1]);
+	}
+}
+
+void TestSkinningKernel()
+{
+	SkinningTestPose pose;
+	CreateSkinningTestPose(256, 64, false, pose);
+
+	std::vector<QuantizedVertex> scalarVertices(pose.stream.positionX.size());
+	SkinByVertex<PMXVertexWeight::BDEF1>(pose, scalarVertices);
+	SkinByVertex<PMXVertexWeight::BDEF2>(pose, scalarVertices);
+	SkinByVertex<PMXVertexWeight::BDEF4>(pose, scalarVertices);
+	SkinByVertex<PMXVertexWeight::QDEF>(pose, scalarVertices);
+
+	// Every kernel up to the one this CPU would pick
+	for (int type = 0; type <= static_cast<int>(SkinningKernel::DetectKernelType()); type++)
+	{
+		SkinningKernelType kernelType = static_cast<SkinningKernelType>(type);
+
+		std::vector<QuantizedVertex> kernelVertices(pose.stream.positionX.size());
+		SkinningOutput output = { kernelVertices.data(), pose.quantization };
+
+		for (PMXVertexWeight weightType : kernelWeightTypes)
+		{
+			unsigned int startIndex;
+			unsigned int endIndex;
+			pose.GetRange(weightType, startIndex, endIndex);
+
+			SkinningKernel::Skinning(kernelType, VertexSkinning::GetInfluenceCount(weightType), pose.stream, pose.palette.data(), startIndex, endIndex, output);
+
+			for (unsigned int i = startIndex; i < endIndex; i++)
+			{
+				CheckSameVertex(scalarVertices[i], kernelVertices[i], pose.quantization);
+			}
+		}
+	}
+}
+
+void BenchmarkSkinningKernel()
+{
+	SkinningTestPose pose;
+	CreateSkinningTestPose(65536, 256, false, pose);
+
+	unsigned int startIndex;
+	unsigned int endIndex;
+	pose.GetRange(PMXVertexWeight::BDEF4, startIndex, endIndex);
+
+	std::vector<QuantizedVertex> vertices(pose.stream.positionX.size());
+	SkinningOutput output = { vertices.data(), pose.quantization };
+
+	const unsigned int iterationCount = 64;
+
+	// Single thread BDEF4 throughput, with the normal and with it passed through
+	auto measure = [&](SkinningKernelType kernelType, bool skinNormal)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int iteration = 0; iteration < iterationCount; iteration++)
+		{
+			SkinningKernel::Skinning(kernelType, 4, pose.stream, pose.palette.data(), startIndex, endIndex, output, skinNormal);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double seconds = std::chrono::duration<double>(end - start).count();
+		return static_cast<double>(endIndex - startIndex) * iterationCount / seconds;
+	};
+
+	for (int type = 0; type <= static_cast<int>(SkinningKernel::DetectKernelType()); type++)
+	{
+		SkinningKernelType kernelType = static_cast<SkinningKernelType>(type);
+
+		double verticesPerSecond = measure(kernelType, true);
+		double positionOnlyPerSecond = measure(kernelType, false);
+		double normalOverhead = (positionOnlyPerSecond / verticesPerSecond - 1.0) * 100.0;
+
+		std::printf("Skinning Kernel %s : %.2f M vertices/s per core, normal overhead %.1f%%\n", SkinningKernel::GetKernelName(kernelType), verticesPerSecond / 1000000.0, normalOverhead);
+	}
+}
@@ -0,0 +1,132 @@
+#include "SkinningTestPose.h"
+#include <random>
+
+namespace
+{
+	const PMXVertexWeight weightTypes[] = { PMXVertexWeight::BDEF1, PMXVertexWeight::BDEF2, PMXVertexWeight::BDEF4, PMXVertexWeight::SDEF, PMXVertexWeight::QDEF };
+
+	XMVECTOR RandomVector(std::mt19937& generator, float extent)
+	{
+		std::uniform_real_distribution<float> distribution(-extent, extent);
+
+		float x = distribution(generator);
+		float y = distribution(generator);
+		float z = distribution(generator);
+		return XMVectorSet(x, y, z, 0.0f);
+	}
+}
+
+SkinningPaletteView SkinningTestPose::GetPaletteView() const
+{
+	return SkinningPaletteView{ boneMatrices.data(), boneRotations.data(), boneDualQuaternions.data(), sdefVertices.data(), sdefStartIndex };
+}
+
+void SkinningTestPose::GetRange(PMXVertexWeight weightType, unsigned int& startIndex, unsigned int& endIndex) const
+{
+	startIndex = 0;
+	while (startIndex < vertices.size() && vertices[startIndex].weightType != weightType)
+	{
+		startIndex++;
+	}
+
+	endIndex = startIndex;
+	while (endIndex < vertices.size() && vertices[endIndex].weightType == weightType)
+	{
+		endIndex++;
+	}
+}
+
+void CreateSkinningTestPose(unsigned int vertexCount, unsigned int boneCount, bool isTranslationOnly, SkinningTestPose& pose)
+{
+	std::mt19937 generator(5678);
+	std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+	std::uniform_int_distribution<int> boneDistribution(0, static_cast<int>(boneCount) - 1);
+
+	pose.vertices.clear();
+
+	for (PMXVertexWeight weightType : weightTypes)
+	{
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			PMXVertex vertex = {};
+			XMStoreFloat3(&vertex.position, RandomVector(generator, 1.0f));
+			XMStoreFloat3(&vertex.normal, XMVector3Normalize(RandomVector(generator, 1.0f)));
+			vertex.uv = XMFLOAT2(unitDistribution(generator), unitDistribution(generator));
+			vertex.weightType = weightType;
+
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				vertex.boneIndices[k] = boneDistribution(generator);
+			}
+
+			switch (weightType)
+			{
+			case PMXVertexWeight::BDEF1:
+				vertex.boneWeights[0] = 1.0f;
+				break;
+			case PMXVertexWeight::BDEF2:
+				vertex.boneWeights[0] = unitDistribution(generator);
+				break;
+			case PMXVertexWeight::SDEF:
+				vertex.boneWeights[0] = unitDistribution(generator);
+				XMStoreFloat3(&vertex.sdefC, RandomVector(generator, 1.0f));
+				XMStoreFloat3(&vertex.sdefR0, XMVectorAdd(XMLoadFloat3(&vertex.sdefC), RandomVector(generator, 0.25f)));
+				XMStoreFloat3(&vertex.sdefR1, XMVectorAdd(XMLoadFloat3(&vertex.sdefC), RandomVector(generator, 0.25f)));
+				break;
+			default:
+			{
+				// BDEF4 and QDEF, QDEF skins with its first bone only
+				float weightSum = 0.0f;
+				for (unsigned int k = 0; k < 4; k++)
+				{
+					vertex.boneWeights[k] = unitDistribution(generator) + 0.01f;
+					weightSum += vertex.boneWeights[k];
+				}
+
+				for (unsigned int k = 0; k < 4; k++)
+				{
+					vertex.boneWeights[k] /= weightSum;
+				}
+				break;
+			}
+			}
+
+			pose.vertices.push_back(vertex);
+		}
+	}
+
+	VertexSkinning::FillStream(pose.vertices, pose.stream);
+
+	unsigned int sdefEndIndex = 0;
+	pose.GetRange(PMXVertexWeight::SDEF, pose.sdefStartIndex, sdefEndIndex);
+
+	pose.sdefVertices.clear();
+	for (unsigned int i = pose.sdefStartIndex; i < sdefEndIndex; i++)
+	{
+		pose.sdefVertices.push_back(VertexSkinning::CreateSdefData(pose.vertices[i]));
+	}
+
+	// Each bone turns up to a radian about its head and moves up to half a unit
+	pose.boneMatrices.resize(boneCount);
+	pose.boneRotations.resize(boneCount);
+	pose.boneDualQuaternions.resize(boneCount);
+	pose.palette.resize(boneCount * skinningPaletteStride);
+
+	for (unsigned int bone = 0; bone < boneCount; bone++)
+	{
+		XMVECTOR head = RandomVector(generator, 1.0f);
+		XMVECTOR translation = RandomVector(generator, 0.5f);
+		XMVECTOR axis = XMVector3Normalize(RandomVector(generator, 1.0f));
+		float angle = isTranslationOnly == true ? 0.0f : unitDistribution(generator);
+
+		XMMATRIX initInverseTransform = XMMatrixTranslationFromVector(XMVectorNegate(head));
+		XMMATRIX globalTransform = XMMatrixRotationAxis(axis, angle) * XMMatrixTranslationFromVector(XMVectorAdd(head, translation));
+
+		VertexSkinning::SetPaletteBone(initInverseTransform, globalTransform, pose.boneMatrices[bone], pose.boneRotations[bone], pose.boneDualQuaternions[bone], &pose.palette[bone * skinningPaletteStride]);
+	}
+
+	// Posed vertices stay within 5 units of the origin, morphs in the tests move them less than 1 more
+	float boundsMin[3] = { -6.0f, -6.0f, -6.0f };
+	float boundsMax[3] = { 6.0f, 6.0f, 6.0f };
+	pose.quantization = SkinningKernel::CreateQuantization(boundsMin, boundsMax);
+}
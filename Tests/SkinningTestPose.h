@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+
+#include "VertexSkinning.h"
+
+// Synthetic model posed the way PMXActor poses its bones, vertices sorted by weight type like SortVerticesByWeightType
+struct SkinningTestPose
+{
+	std::vector<PMXVertex> vertices;
+	SkinningStream stream;
+
+	std::vector<XMMATRIX> boneMatrices;
+	std::vector<XMVECTOR> boneRotations;
+	std::vector<XMVECTOR> boneDualQuaternions;
+	std::vector<float> palette;
+
+	std::vector<SdefSkinningData> sdefVertices;
+	unsigned int sdefStartIndex = 0;
+
+	VertexQuantization quantization;
+
+	SkinningPaletteView GetPaletteView() const;
+	// [startIndex, endIndex) of the vertices of one weight type
+	void GetRange(PMXVertexWeight weightType, unsigned int& startIndex, unsigned int& endIndex) const;
+};
+
+// vertexCount of every weight type, a multiple of skinningStreamAlignment so each type is whole kernel blocks.
+// With isTranslationOnly no bone rotates, SDEF and dual quaternion blending then reduce to the linear blend
+void CreateSkinningTestPose(unsigned int vertexCount, unsigned int boneCount, bool isTranslationOnly, SkinningTestPose& pose);
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// Asserts in every configuration, so a Release run of the tests fails too
+#define TEST_ASSERT(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::printf("%s(%d) : assertion failed : %s\n", __FILE__, __LINE__, #condition); \
+			std::abort(); \
+		} \
+	} while (false)
+
+void TestPassRecorder();
+void TestDescriptorAllocator();
+void TestRenderGraph();
+void TestSkinningKernel();
+void TestGpuSkinning();
+void TestMorphManager();
+
+// Run by main with --bench, print their measurements
+void BenchmarkSkinningKernel();
+void BenchmarkMorph();
@@ -0,0 +1,37 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Test.h"
+
+// Headless checks of the device free parts of the renderer, a failed check aborts with its file and line.
+// --bench also measures them once every check passed
+int main(int argc, char** argv)
+{
+	TestPassRecorder();
+	std::printf("PassRecorder passed\n");
+
+	TestDescriptorAllocator();
+	std::printf("DescriptorAllocator passed\n");
+
+	TestRenderGraph();
+	std::printf("RenderGraph passed\n");
+
+	TestSkinningKernel();
+	std::printf("SkinningKernel passed\n");
+
+	TestGpuSkinning();
+	std::printf("GpuSkinning passed\n");
+
+	TestMorphManager();
+	std::printf("MorphManager passed\n");
+
+	std::printf("All tests passed\n");
+
+	if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+	{
+		BenchmarkSkinningKernel();
+		BenchmarkMorph();
+	}
+
+	return 0;
+}